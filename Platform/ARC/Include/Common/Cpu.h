@@ -3,19 +3,111 @@
 /* Instruction cache related auxiliary registers */
 #define ARC_AUX_IC_IVIC 0x10
 #define ARC_AUX_IC_CTRL 0x11
+#define ARC_AUX_IC_IVIL 0x19
 #define ARC_BCR_IC_BUILD 0x77
 
 /* Data cache related auxiliary registers */
 #define ARC_AUX_DC_IVDC 0x47
 #define ARC_AUX_DC_CTRL 0x48
+#define ARC_AUX_DC_IVDL 0x4a
+#define ARC_AUX_DC_FLSH 0x4b
+#define ARC_AUX_DC_FLDL 0x4c
 #define ARC_BCR_DC_BUILD 0x72
 #define ARC_BCR_SLC 0xce
+#define ARC_AUX_SLC_CFG 0x901
+#define ARC_AUX_SLC_FLUSH 0x904
+#define ARC_AUX_SLC_INVALIDATE 0x905
+#define ARC_AUX_SLC_RGN_START 0x914
+#define ARC_AUX_SLC_RGN_END 0x916
+#define ARC_AUX_VOLATILE 0x5e // Uncached region start in bits 31:28
+
+/* Core identification and multi-core related registers */
+#define ARC_AUX_IDENTITY 0x04
+#define ARC_BCR_MCIP 0xd0
+
+/* Zero overhead loop auxiliary registers */
+#define ARC_AUX_LP_START 0x02
+#define ARC_AUX_LP_END 0x03
+
+/* Exception and interrupt related auxiliary registers */
+#define ARC_AUX_IRQ_CTRL 0x0e
+#define ARC_AUX_INT_VECTOR_BASE 0x25
+#define ARC_AUX_IRQ_PRIORITY 0x206
+#define ARC_AUX_IRQ_CAUSE 0x40a
+#define ARC_AUX_IRQ_SELECT 0x40b
+#define ARC_AUX_IRQ_ENABLE 0x40c
+#define ARC_AUX_ERET 0x400
+#define ARC_AUX_ERBTA 0x401
+#define ARC_AUX_ERSTATUS 0x402
+#define ARC_AUX_ECR 0x403
+#define ARC_AUX_EFA 0x404
+#define ARC_AUX_BTA 0x412
+#define ARC_BCR_IRQ_BUILD 0xf3
 
 /* DSP-extensions related auxiliary registers */
 #define ARC_AUX_DSP_BUILD 0x7a
 #define ARC_AUX_DSP_CTRL 0x59f
 #define ARC_AUX_SLC_CTRL 0x903
 
+/* Timer related auxiliary registers */
+#define ARC_BCR_TIMER_BUILD 0x75
+#define ARC_AUX_COUNT0 0x21
+#define ARC_AUX_CONTROL0 0x22
+#define ARC_AUX_LIMIT0 0x23
+#define ARC_AUX_COUNT1 0x100
+#define ARC_AUX_CONTROL1 0x101
+#define ARC_AUX_LIMIT1 0x102
+#define ARC_AUX_RTC_CTRL 0x103
+#define ARC_AUX_RTC_LOW 0x104
+#define ARC_AUX_RTC_HIGH 0x105
+
+/* TIMER_BUILD Bits Positions */
+#define TIMER_BUILD_T0_BIT 8
+#define TIMER_BUILD_T1_BIT 9
+#define TIMER_BUILD_RTC_BIT 10
+
+/* CONTROLn and AUX_RTC_CTRL Bits Positions */
+#define TIMER_CTRL_IE_BIT 0 // Interrupt when count reaches limit
+#define TIMER_CTRL_NH_BIT 1 // Count only while CPU is not halted
+#define RTC_CTRL_E_BIT 0 // Enable
+#define RTC_CTRL_A0_BIT 31 // Last LOW/HIGH read pair was atomic
+
+/* IC_BUILD and DC_BUILD Fields */
+#define CACHE_BUILD_VER_MASK 0xff // 0 when there is no cache
+#define CACHE_BUILD_WAYS_SHIFT 8 // 1 << field
+#define CACHE_BUILD_SIZE_SHIFT 12 // 512 bytes << field
+#define CACHE_BUILD_LINE_SHIFT 16 // 8 (I$) or 16 (D$) bytes << field
+#define CACHE_BUILD_FIELD_MASK 0xf
+
+/* SLC_CFG Fields */
+#define SLC_CFG_SIZE_MASK 0xf // 128 KiB << field
+#define SLC_CFG_LINE_SHIFT 4 // 128 bytes when field is 0, 64 otherwise
+#define SLC_CFG_LINE_MASK 0x3
+#define SLC_CFG_WAYS_SHIFT 6 // 4 << field
+#define SLC_CFG_WAYS_MASK 0x3
+
+/* IDENTITY and MCIP_BCR Fields */
+#define IDENTITY_CORE_SHIFT 8 // ARCNUM
+#define IDENTITY_CORE_MASK 0xff
+#define MCIP_BCR_CORES_SHIFT 16 // 0 when there is no MCIP
+#define MCIP_BCR_CORES_MASK 0x3f
+#define DSP_BUILD_VER_MASK 0xff // 0 when there is no DSP
+
+/* IC_CTRL and DC_CTRL Bits Positions */
+#define CACHE_CTRL_DC_BIT 0 // Cache disabled
+#define DC_CTRL_IM_BIT 6 // IVDC/IVDL write dirty lines back first
+#define DC_CTRL_FS_BIT 8 // Flush in progress
+
+/* SLC_CTRL Bits Positions, bit 0 disables SLC as in IC_CTRL and DC_CTRL */
+#define SLC_CTRL_IM_BIT 6 // Invalidation writes dirty lines back first
+#define SLC_CTRL_BUSY_BIT 8 // Operation in progress
+#define SLC_CTRL_RGN_OP_INV_BIT 9 // Region operation invalidates
+
+/* PcdArcCachePolicy Bits Positions */
+#define CACHE_POLICY_IC_BIT 0
+#define CACHE_POLICY_DC_BIT 1
+#define CACHE_POLICY_SLC_BIT 2
+
 /* STATUS32 Bits Positions */
 #define STATUS_AD_BIT 19 // Enable unaligned access
 
@@ -0,0 +1,61 @@
+#pragma once
+
+/* Vectors 0-15 are exceptions, interrupts follow */
+#define ARC_EXCEPTION_COUNT 16
+#define ARC_VECTOR_COUNT 256
+#define ARC_IRQ_TIMER0 16
+#define ARC_IRQ_TIMER1 17
+
+/* Priority given to interrupts, and STATUS32.E that lets them in */
+#define ARC_IRQ_PRIORITY 1
+
+/* SETI operand: take IE and E from operand */
+#define SETI_USE_OPERAND_BIT 5
+#define SETI_IE_BIT 4
+
+/* ECR fields */
+#define ECR_VECTOR_SHIFT 16
+#define ECR_VECTOR_MASK 0xff
+
+/*
+ * Frame built on stack by exception and interrupt entry code (see
+ * CpuLib/Arc2Vector.S). Interrupt entry finds PC and STATUS32 pushed by
+ * hardware right above registers it saves, exception entry copies them from
+ * ERET and ERSTATUS and writes them back on return. BTA is taken from BTA
+ * for interrupts and from ERBTA for exceptions, it is the branch target
+ * to resume to when the interrupted instruction sits in a delay slot.
+ */
+#define FRAME_BLINK 52
+#define FRAME_LP_COUNT 56
+#define FRAME_LP_START 60
+#define FRAME_LP_END 64
+#define FRAME_ACCL 68
+#define FRAME_ACCH 72
+#define FRAME_BTA 76
+#define FRAME_PC 80
+#define FRAME_STATUS32 84
+#define FRAME_SIZE 88
+
+#ifndef __ASSEMBLY__
+typedef struct {
+  UINT32 R[13]; // r0-r12
+  UINT32 Blink;
+  UINT32 LpCount;
+  UINT32 LpStart;
+  UINT32 LpEnd;
+  UINT32 Accl; // r58, MPY/MAC accumulator
+  UINT32 Acch; // r59
+  UINT32 Bta;
+  UINT32 Pc; // Interrupted instruction, or faulting one for exceptions
+  UINT32 Status32;
+} ARC_INTERRUPT_FRAME;
+
+/*
+ * EFI_SYSTEM_CONTEXT has no ARC member, and all of its members are pointers
+ * to processor context, so the frame is passed in the first one.
+ */
+#define ARC_FRAME_TO_CONTEXT(Context, Frame)\
+  ((Context).SystemContextEbc = (EFI_SYSTEM_CONTEXT_EBC *) (Frame))
+#define ARC_CONTEXT_TO_FRAME(Context)\
+  ((ARC_INTERRUPT_FRAME *) (Context).SystemContextEbc)
+#endif
@@ -0,0 +1,46 @@
+/** @file
+  CPU cache and core topology published by PEI core.
+
+  ARC_CPU_INFO is the interface of ARC CPU info PPI, installed by PEI core
+  before any PEIM runs, and data of ARC CPU info GUID HOB handed off to DXE.
+  Both are filled by GetArcCpuInfo(), see Include/Library/ArcCpuInfoLib.h.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef ARC_CPU_INFO_H_
+#define ARC_CPU_INFO_H_
+
+#define ARC_CPU_INFO_HOB_GUID \
+  { 0x63aa14be, 0x18ea, 0x4a1d, { 0xaa, 0x91, 0xdb, 0xb4, 0x9d, 0x5a, 0xd8, 0xbd } }
+
+#define ARC_CPU_INFO_PPI_GUID \
+  { 0xeee28292, 0xbcfd, 0x47a2, { 0x95, 0xeb, 0xf2, 0x0d, 0x23, 0x9d, 0x1e, 0xe6 } }
+
+#define ARC_CPU_INFO_REVISION 1
+
+typedef struct {
+  UINT32 Size; // Bytes, 0 when there is no cache
+  UINT32 LineSize; // Bytes
+  UINT32 Ways;
+  UINT32 Version; // Build configuration register version
+} ARC_CACHE_INFO;
+
+typedef struct {
+  UINT32 Revision; // ARC_CPU_INFO_REVISION
+  UINT32 CoreId; // Core number of the boot core, IDENTITY ARCNUM
+  UINT32 CoreCount; // Cores in the cluster, 1 without MCIP
+  UINT32 DspVersion; // 0 when there is no DSP
+  ARC_CACHE_INFO ICache;
+  ARC_CACHE_INFO DCache;
+  ARC_CACHE_INFO Slc;
+} ARC_CPU_INFO;
+
+extern EFI_GUID gArcCpuInfoHobGuid;
+extern EFI_GUID gArcCpuInfoPpiGuid;
+
+#endif // ARC_CPU_INFO_H_
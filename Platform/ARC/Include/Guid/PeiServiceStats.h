@@ -0,0 +1,53 @@
+/** @file
+  PEI service call statistics handed off to DXE as GUID HOB.
+
+  HOB data is PEI_SERVICE_STATS_HEADER followed by EntryCount entries, one
+  per caller that made any calls. Built by PEI core with PEI_SERVICE_STATS
+  defined only.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef PEI_SERVICE_STATS_H_
+#define PEI_SERVICE_STATS_H_
+
+#define PEI_SERVICE_STATS_GUID \
+  { 0x80d2e02a, 0xc8be, 0x49e1, { 0xa9, 0x7d, 0x61, 0x98, 0x67, 0x59, 0xc0, 0x32 } }
+
+//
+// Services accounted, index of PEI_SERVICE_STATS_ENTRY.Stats
+//
+#define PEI_SERVICE_INSTALL_PPI 0
+#define PEI_SERVICE_LOCATE_PPI 1
+#define PEI_SERVICE_FIND_NEXT_VOLUME 2
+#define PEI_SERVICE_FIND_NEXT_FILE 3
+#define PEI_SERVICE_FIND_SECTION_DATA 4
+#define PEI_SERVICE_GET_FILE_INFO 5
+#define PEI_SERVICE_COUNT 6
+
+typedef struct {
+  UINT32 Calls;
+  UINT32 MaxTicks; // Longest call, saturated
+  UINT64 TotalTicks; // Includes notifications made by InstallPpi
+  UINT64 Bytes; // Bytes of FV walked to find files and sections
+} PEI_SERVICE_STAT;
+
+typedef struct {
+  EFI_GUID FileName; // Calling PEIM, zero for PEI core and notifications
+  PEI_SERVICE_STAT Stats[PEI_SERVICE_COUNT];
+} PEI_SERVICE_STATS_ENTRY;
+
+typedef struct {
+  UINT64 Frequency; // Performance counter ticks per second
+  UINT16 EntryCount;
+  UINT16 ServiceCount; // PEI_SERVICE_COUNT
+  UINT32 Reserved;
+} PEI_SERVICE_STATS_HEADER;
+
+extern EFI_GUID gArcPeiServiceStatsGuid;
+
+#endif // PEI_SERVICE_STATS_H_
@@ -0,0 +1,98 @@
+/** @file
+  System level cache maintenance provided by ARC CacheMaintenanceLib
+  (CpuLib/CpuCache.inf) beyond MdePkg CacheMaintenanceLib interface.
+
+  SLC is shared by all cores and sits between their data caches and memory,
+  CacheMaintenanceLib functions do not reach it. Write data cache back first
+  for data to get to memory, e.g. WriteBackDataCacheRange() followed by
+  WriteBackSlcRange(). All functions do nothing when SLC is not there or is
+  disabled.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef ARC_CACHE_LIB_H_
+#define ARC_CACHE_LIB_H_
+
+#include <Uefi/UefiBaseType.h>
+
+/**
+  Write back all dirty SLC lines.
+
+**/
+VOID
+EFIAPI
+WriteBackSlc(VOID);
+
+/**
+  Write back all dirty SLC lines and invalidate all lines.
+
+**/
+VOID
+EFIAPI
+WriteBackInvalidateSlc(VOID);
+
+/**
+  Invalidate all SLC lines, dirty lines are discarded.
+
+**/
+VOID
+EFIAPI
+InvalidateSlc(VOID);
+
+/**
+  Write back dirty SLC lines of a range, or of the whole SLC when range is
+  PcdArcCacheFlushThreshold bytes or more.
+
+  @param Address  Start of range.
+  @param Length   Range length in bytes.
+
+  @return Address.
+
+**/
+VOID *
+EFIAPI
+WriteBackSlcRange(
+  IN VOID *Address,
+  IN UINTN Length
+  );
+
+/**
+  Write back and invalidate SLC lines of a range, or the whole SLC when
+  range is PcdArcCacheFlushThreshold bytes or more.
+
+  @param Address  Start of range.
+  @param Length   Range length in bytes.
+
+  @return Address.
+
+**/
+VOID *
+EFIAPI
+WriteBackInvalidateSlcRange(
+  IN VOID *Address,
+  IN UINTN Length
+  );
+
+/**
+  Invalidate SLC lines of a range, dirty lines are discarded. Lines outside
+  of the range are never touched.
+
+  @param Address  Start of range.
+  @param Length   Range length in bytes.
+
+  @return Address.
+
+**/
+VOID *
+EFIAPI
+InvalidateSlcRange(
+  IN VOID *Address,
+  IN UINTN Length
+  );
+
+#endif // ARC_CACHE_LIB_H_
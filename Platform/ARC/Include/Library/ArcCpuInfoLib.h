@@ -0,0 +1,72 @@
+/** @file
+  ARC CPU cache geometry and core topology decoded from build configuration
+  registers.
+
+  Nothing is cached, every call reads the registers again. Code running after
+  PEI core started may locate ARC CPU info PPI or, in DXE, ARC CPU info HOB
+  instead, see Include/Guid/ArcCpuInfo.h.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef ARC_CPU_INFO_LIB_H_
+#define ARC_CPU_INFO_LIB_H_
+
+#include <Uefi/UefiBaseType.h>
+#include <Guid/ArcCpuInfo.h>
+
+/**
+  Decode instruction cache geometry from IC_BUILD.
+
+  @param Info   Geometry, all zero when there is no instruction cache.
+
+  @return TRUE if there is instruction cache, enabled or not.
+
+**/
+BOOLEAN
+GetArcICacheInfo(
+  OUT ARC_CACHE_INFO *Info
+  );
+
+/**
+  Decode data cache geometry from DC_BUILD.
+
+  @param Info   Geometry, all zero when there is no data cache.
+
+  @return TRUE if there is data cache, enabled or not.
+
+**/
+BOOLEAN
+GetArcDCacheInfo(
+  OUT ARC_CACHE_INFO *Info
+  );
+
+/**
+  Decode system level cache geometry from SLC_BUILD and SLC_CFG.
+
+  @param Info   Geometry, all zero when there is no SLC.
+
+  @return TRUE if there is SLC, enabled or not.
+
+**/
+BOOLEAN
+GetArcSlcInfo(
+  OUT ARC_CACHE_INFO *Info
+  );
+
+/**
+  Decode caches, DSP presence, boot core number and core count.
+
+  @param Info   CPU info.
+
+**/
+VOID
+GetArcCpuInfo(
+  OUT ARC_CPU_INFO *Info
+  );
+
+#endif // ARC_CPU_INFO_LIB_H_
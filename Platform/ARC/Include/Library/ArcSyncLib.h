@@ -0,0 +1,256 @@
+/** @file
+  Atomics and queued spin locks provided by ARC SynchronizationLib
+  (CpuLib/CpuSync.inf) beyond MdePkg SynchronizationLib interface.
+
+  SPIN_LOCK of SynchronizationLib is a single word every waiter polls and
+  writes, so its cache line moves between all cores on every handoff.
+  TICKET_LOCK hands the lock over in FIFO order, waiters still poll one
+  line. MCS_LOCK queues waiters, each polls its own MCS_LOCK_NODE, and a
+  handoff touches the next waiter's line only.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef ARC_SYNC_LIB_H_
+#define ARC_SYNC_LIB_H_
+
+#include <Uefi/UefiBaseType.h>
+
+//
+// Static padding of lock data, the largest ARCv2 data cache line. Run time
+// line size is returned by GetSpinLockProperties().
+//
+#define ARC_SYNC_LINE_SIZE 64
+
+typedef struct {
+  volatile UINT32 Next; // Ticket given to the next caller
+  volatile UINT32 Owner; // Ticket holding the lock
+} __attribute__((aligned(ARC_SYNC_LINE_SIZE))) TICKET_LOCK;
+
+typedef struct _MCS_LOCK_NODE MCS_LOCK_NODE;
+
+//
+// Queue entry of one lock holder or waiter, lives from acquisition until
+// release, e.g. on caller stack
+//
+struct _MCS_LOCK_NODE {
+  MCS_LOCK_NODE *volatile Next;
+  volatile UINT32 Locked; // Cleared by previous holder on handoff
+} __attribute__((aligned(ARC_SYNC_LINE_SIZE)));
+
+typedef struct {
+  MCS_LOCK_NODE *volatile Tail; // Last waiter, NULL when lock is free
+} __attribute__((aligned(ARC_SYNC_LINE_SIZE))) MCS_LOCK;
+
+/**
+  Atomically add Addend to Value, full memory barrier.
+
+  @param Value    Value to add to.
+  @param Addend   Value to add.
+
+  @return Value before addition.
+
+**/
+UINT32
+EFIAPI
+InterlockedFetchAdd32(
+  IN OUT volatile UINT32 *Value,
+  IN UINT32 Addend
+  );
+
+/**
+  Atomically and Value with AndData, full memory barrier.
+
+  @param Value    Value to update.
+  @param AndData  Value to and with.
+
+  @return Value before the operation.
+
+**/
+UINT32
+EFIAPI
+InterlockedFetchAnd32(
+  IN OUT volatile UINT32 *Value,
+  IN UINT32 AndData
+  );
+
+/**
+  Atomically or Value with OrData, full memory barrier.
+
+  @param Value    Value to update.
+  @param OrData   Value to or with.
+
+  @return Value before the operation.
+
+**/
+UINT32
+EFIAPI
+InterlockedFetchOr32(
+  IN OUT volatile UINT32 *Value,
+  IN UINT32 OrData
+  );
+
+/**
+  Atomically replace Value with ExchangeValue, full memory barrier.
+
+  @param Value          Value to replace.
+  @param ExchangeValue  New value.
+
+  @return Value before exchange.
+
+**/
+UINT32
+EFIAPI
+InterlockedExchange32(
+  IN OUT volatile UINT32 *Value,
+  IN UINT32 ExchangeValue
+  );
+
+/**
+  Atomically replace pointer with ExchangeValue, full memory barrier.
+
+  @param Value          Pointer to replace.
+  @param ExchangeValue  New pointer.
+
+  @return Pointer before exchange.
+
+**/
+VOID *
+EFIAPI
+InterlockedExchangePointer(
+  IN OUT VOID *volatile *Value,
+  IN VOID *ExchangeValue
+  );
+
+/**
+  Full memory barrier, accesses before it are seen by other cores before
+  accesses after it.
+
+**/
+VOID
+EFIAPI
+SyncMemoryBarrier(VOID);
+
+/**
+  Initialize ticket lock to released state.
+
+  @param Lock   Lock to initialize.
+
+  @return Lock.
+
+**/
+TICKET_LOCK *
+EFIAPI
+InitializeTicketLock(
+  OUT TICKET_LOCK *Lock
+  );
+
+/**
+  Wait for ticket lock, callers get it in order of arrival.
+
+  @param Lock   Lock to acquire.
+
+  @return Lock.
+
+**/
+TICKET_LOCK *
+EFIAPI
+AcquireTicketLock(
+  IN OUT TICKET_LOCK *Lock
+  );
+
+/**
+  Acquire ticket lock if nobody holds or waits for it.
+
+  @param Lock   Lock to acquire.
+
+  @return TRUE if lock is acquired.
+
+**/
+BOOLEAN
+EFIAPI
+AcquireTicketLockOrFail(
+  IN OUT TICKET_LOCK *Lock
+  );
+
+/**
+  Release ticket lock to the next waiter.
+
+  @param Lock   Lock to release.
+
+  @return Lock.
+
+**/
+TICKET_LOCK *
+EFIAPI
+ReleaseTicketLock(
+  IN OUT TICKET_LOCK *Lock
+  );
+
+/**
+  Initialize MCS lock to released state.
+
+  @param Lock   Lock to initialize.
+
+  @return Lock.
+
+**/
+MCS_LOCK *
+EFIAPI
+InitializeMcsLock(
+  OUT MCS_LOCK *Lock
+  );
+
+/**
+  Queue Node on MCS lock and wait until it is handed over.
+
+  @param Lock   Lock to acquire.
+  @param Node   Queue entry of the caller, kept until ReleaseMcsLock().
+
+  @return Lock.
+
+**/
+MCS_LOCK *
+EFIAPI
+AcquireMcsLock(
+  IN OUT MCS_LOCK *Lock,
+  OUT MCS_LOCK_NODE *Node
+  );
+
+/**
+  Acquire MCS lock if it is free.
+
+  @param Lock   Lock to acquire.
+  @param Node   Queue entry of the caller, kept until ReleaseMcsLock().
+
+  @return TRUE if lock is acquired.
+
+**/
+BOOLEAN
+EFIAPI
+AcquireMcsLockOrFail(
+  IN OUT MCS_LOCK *Lock,
+  OUT MCS_LOCK_NODE *Node
+  );
+
+/**
+  Hand MCS lock over to the next waiter, or release it if there is none.
+
+  @param Lock   Lock to release.
+  @param Node   Queue entry lock was acquired with.
+
+  @return Lock.
+
+**/
+MCS_LOCK *
+EFIAPI
+ReleaseMcsLock(
+  IN OUT MCS_LOCK *Lock,
+  IN OUT MCS_LOCK_NODE *Node
+  );
+
+#endif // ARC_SYNC_LIB_H_
@@ -0,0 +1,146 @@
+/** @file
+  Boot performance records and the HOB list they are handed off in.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef BOOT_PERF_LIB_H_
+#define BOOT_PERF_LIB_H_
+
+#include <PiPei.h>
+#include <Library/PerformanceLib.h>
+
+//
+// Records are kept in temporary RAM (PcdPerfBufferBase/Size) as raw counter
+// values, so taking one costs a counter read and a few stores. They are
+// converted to FPDT records only once, by BuildPerfHob(), into the GUID HOB
+// DxeCorePerformanceLib merges into its own records.
+//
+#define PERF_BUFFER_SIGNATURE SIGNATURE_32('P', 'R', 'E', 'C')
+
+typedef struct {
+  UINT32 Signature;
+  UINT16 Count;
+  UINT16 Capacity;
+  UINT32 Dropped; // Records lost because buffer was full
+  UINT32 Reserved;
+} PERF_BUFFER;
+
+typedef struct {
+  UINT64 Ticks; // Performance counter, see TimerLib
+  CONST EFI_GUID *Guid; // Name of measured module file
+  UINT16 ProgressId; // MODULE_START_ID etc. of PerformanceLib.h
+  UINT16 Reserved;
+} PERF_RECORD;
+
+//
+// Boot phases marked by PerfPhase()
+//
+#define BOOT_PHASE_SEC 0
+#define BOOT_PHASE_PEI 1
+#define BOOT_PHASE_DXE_IPL 2
+#define BOOT_PHASE_DXE 3 // Right before DXE core entry point is called
+
+/**
+  Drop records of previous boot, to be called once by SEC.
+
+**/
+VOID
+PerfReset(VOID);
+
+/**
+  Append record with given counter value.
+
+  @param Ticks        Performance counter value.
+  @param ProgressId   Progress ID, e.g. MODULE_START_ID.
+  @param Guid         Name of measured module file.
+
+**/
+VOID
+PerfRecordTicks(
+  IN UINT64 Ticks,
+  IN UINT16 ProgressId,
+  IN CONST EFI_GUID *Guid
+  );
+
+/**
+  Append record with current counter value.
+
+  @param ProgressId   Progress ID, e.g. MODULE_START_ID.
+  @param Guid         Name of measured module file.
+
+**/
+VOID
+PerfRecord(
+  IN UINT16 ProgressId,
+  IN CONST EFI_GUID *Guid
+  );
+
+/**
+  With PcdBootPhaseMarkers, write "@phs <phase> <ticks high> <ticks low>" line
+  to serial port, so that host can tell boot phases apart in console output
+  without decoding logs, see scripts/boot-bench.py.
+
+  @param Phase    BOOT_PHASE_SEC etc.
+  @param Ticks    Performance counter value phase started at.
+
+**/
+VOID
+PerfPhase(
+  IN UINT32 Phase,
+  IN UINT64 Ticks
+  );
+
+/**
+  Start HOB list with PHIT HOB.
+
+  @param Base   HOB list memory.
+  @param Size   HOB list memory size in bytes.
+
+  @return PHIT HOB, NULL if there is no room for it.
+
+**/
+EFI_HOB_HANDOFF_INFO_TABLE *
+CreateHobList(
+  IN VOID *Base,
+  IN UINTN Size
+  );
+
+/**
+  Append GUID extension HOB to HOB list.
+
+  @param HobList      PHIT HOB returned by CreateHobList().
+  @param Guid         HOB name.
+  @param DataLength   HOB data size in bytes.
+
+  @return HOB data, NULL if HOB list is full.
+
+**/
+VOID *
+AddGuidHob(
+  IN OUT EFI_HOB_HANDOFF_INFO_TABLE *HobList,
+  IN CONST EFI_GUID *Guid,
+  IN UINTN DataLength
+  );
+
+/**
+  Append records as FPDT GUID event records in extended firmware performance
+  GUID HOB, see MdeModulePkg/Include/Guid/ExtendedFirmwarePerformance.h.
+
+  @param HobList      PHIT HOB returned by CreateHobList().
+
+  @retval EFI_SUCCESS           HOB is added.
+  @retval EFI_NOT_FOUND         There are no records.
+  @retval EFI_OUT_OF_RESOURCES  HOB list is full.
+
+**/
+EFI_STATUS
+BuildPerfHob(
+  IN OUT EFI_HOB_HANDOFF_INFO_TABLE *HobList
+  );
+
+#endif // BOOT_PERF_LIB_H_
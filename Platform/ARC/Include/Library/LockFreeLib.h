@@ -0,0 +1,232 @@
+/** @file
+  Lock free rings and sequence lock built on ARC SynchronizationLib atomics.
+
+  Rings carry UINTN values, e.g. pointers, in caller provided storage of
+  power of 2 entries. SPSC_RING takes one producer and one consumer, each
+  index is written by one side only and the other side's index is cached,
+  so the sides share lines only when the ring looks full or empty.
+  MPMC_RING is D. Vyukov's bounded queue, any number of producers and
+  consumers claim slots with compare exchange on head or tail and hand them
+  over with per cell sequence numbers. SEQ_LOCK lets readers of read-mostly
+  data run without writing anything, they retry if a writer was in.
+
+  Atomic fetch-add, fetch-and and fetch-or are InterlockedFetchAdd32(),
+  InterlockedFetchAnd32() and InterlockedFetchOr32() of ArcSyncLib.h.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef LOCK_FREE_LIB_H_
+#define LOCK_FREE_LIB_H_
+
+#include <Uefi/UefiBaseType.h>
+#include <Library/ArcSyncLib.h>
+
+//
+// Consumer fields, producer fields and fields both only read are on
+// separate cache lines
+//
+typedef struct {
+  // Next entry to pop
+  volatile UINT32 Head __attribute__((aligned(ARC_SYNC_LINE_SIZE)));
+  UINT32 TailCache; // Consumer's view of Tail
+  // Next entry to push
+  volatile UINT32 Tail __attribute__((aligned(ARC_SYNC_LINE_SIZE)));
+  UINT32 HeadCache; // Producer's view of Head
+  UINT32 Mask __attribute__((aligned(ARC_SYNC_LINE_SIZE))); // Entry count - 1
+  UINTN *Entries;
+} SPSC_RING;
+
+typedef struct {
+  volatile UINT32 Sequence; // Position cell is ready for
+  UINTN Value;
+} MPMC_RING_CELL;
+
+typedef struct {
+  // Next position to push
+  volatile UINT32 Tail __attribute__((aligned(ARC_SYNC_LINE_SIZE)));
+  // Next position to pop
+  volatile UINT32 Head __attribute__((aligned(ARC_SYNC_LINE_SIZE)));
+  UINT32 Mask __attribute__((aligned(ARC_SYNC_LINE_SIZE))); // Cell count - 1
+  MPMC_RING_CELL *Cells;
+} MPMC_RING;
+
+typedef struct {
+  volatile UINT32 Sequence; // Odd while a writer is in
+} __attribute__((aligned(ARC_SYNC_LINE_SIZE))) SEQ_LOCK;
+
+/**
+  Initialize empty SPSC ring.
+
+  @param Ring     Ring to initialize.
+  @param Entries  Ring storage.
+  @param Count    Number of entries, power of 2.
+
+  @retval EFI_SUCCESS           Ring is initialized.
+  @retval EFI_INVALID_PARAMETER Count is not a power of 2.
+
+**/
+EFI_STATUS
+EFIAPI
+InitializeSpscRing(
+  OUT SPSC_RING *Ring,
+  IN UINTN *Entries,
+  IN UINT32 Count
+  );
+
+/**
+  Append value to SPSC ring, called by producer only.
+
+  @param Ring     Ring to append to.
+  @param Value    Value to append.
+
+  @return TRUE if value is appended, FALSE if ring is full.
+
+**/
+BOOLEAN
+EFIAPI
+SpscRingPush(
+  IN OUT SPSC_RING *Ring,
+  IN UINTN Value
+  );
+
+/**
+  Take the oldest value from SPSC ring, called by consumer only.
+
+  @param Ring     Ring to take from.
+  @param Value    Value taken.
+
+  @return TRUE if value is taken, FALSE if ring is empty.
+
+**/
+BOOLEAN
+EFIAPI
+SpscRingPop(
+  IN OUT SPSC_RING *Ring,
+  OUT UINTN *Value
+  );
+
+/**
+  Initialize empty MPMC ring.
+
+  @param Ring     Ring to initialize.
+  @param Cells    Ring storage.
+  @param Count    Number of cells, power of 2.
+
+  @retval EFI_SUCCESS           Ring is initialized.
+  @retval EFI_INVALID_PARAMETER Count is not a power of 2.
+
+**/
+EFI_STATUS
+EFIAPI
+InitializeMpmcRing(
+  OUT MPMC_RING *Ring,
+  IN MPMC_RING_CELL *Cells,
+  IN UINT32 Count
+  );
+
+/**
+  Append value to MPMC ring.
+
+  @param Ring     Ring to append to.
+  @param Value    Value to append.
+
+  @return TRUE if value is appended, FALSE if ring is full.
+
+**/
+BOOLEAN
+EFIAPI
+MpmcRingPush(
+  IN OUT MPMC_RING *Ring,
+  IN UINTN Value
+  );
+
+/**
+  Take the oldest value from MPMC ring.
+
+  @param Ring     Ring to take from.
+  @param Value    Value taken.
+
+  @return TRUE if value is taken, FALSE if ring is empty.
+
+**/
+BOOLEAN
+EFIAPI
+MpmcRingPop(
+  IN OUT MPMC_RING *Ring,
+  OUT UINTN *Value
+  );
+
+/**
+  Initialize sequence lock.
+
+  @param Lock   Lock to initialize.
+
+**/
+VOID
+EFIAPI
+InitializeSeqLock(
+  OUT SEQ_LOCK *Lock
+  );
+
+/**
+  Start reading data guarded by sequence lock, waits while a writer is in.
+
+  @param Lock   Lock guarding the data.
+
+  @return Sequence to pass to SeqLockReadRetry().
+
+**/
+UINT32
+EFIAPI
+SeqLockReadBegin(
+  IN SEQ_LOCK *Lock
+  );
+
+/**
+  Finish reading data guarded by sequence lock. Data read since
+  SeqLockReadBegin() may be torn and must not be used unless this returns
+  FALSE.
+
+  @param Lock       Lock guarding the data.
+  @param Sequence   Value returned by SeqLockReadBegin().
+
+  @return TRUE if a writer was in, read has to be started over.
+
+**/
+BOOLEAN
+EFIAPI
+SeqLockReadRetry(
+  IN SEQ_LOCK *Lock,
+  IN UINT32 Sequence
+  );
+
+/**
+  Start writing data guarded by sequence lock, waits for other writers.
+
+  @param Lock   Lock guarding the data.
+
+**/
+VOID
+EFIAPI
+SeqLockWriteBegin(
+  IN OUT SEQ_LOCK *Lock
+  );
+
+/**
+  Finish writing data guarded by sequence lock.
+
+  @param Lock   Lock guarding the data.
+
+**/
+VOID
+EFIAPI
+SeqLockWriteEnd(
+  IN OUT SEQ_LOCK *Lock
+  );
+
+#endif // LOCK_FREE_LIB_H_
@@ -0,0 +1,69 @@
+/** @file
+  Statistical profiler sampling interrupted PC on TIMER0 interrupt.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef PC_SAMPLE_LIB_H_
+#define PC_SAMPLE_LIB_H_
+
+#include <Uefi/UefiBaseType.h>
+
+//
+// Samples are counted in a histogram in temporary RAM (PcdPcSampleBufferBase/
+// Size) keyed by interrupted PC and BLINK, an open addressing hash table of
+// power of 2 capacity. Samples of keys that find no free entry within a few
+// probes are only counted as dropped. Histogram is symbolized off-target by
+// scripts/pc-symbolize.py.
+//
+#define PC_SAMPLE_SIGNATURE SIGNATURE_32('P', 'C', 'S', 'M')
+
+typedef struct {
+  UINT32 Signature;
+  UINT32 Capacity; // Number of entries, follow the header
+  UINT32 Samples; // All samples taken, including dropped ones
+  UINT32 Dropped;
+  UINT32 Rate; // Samples per second
+  UINT32 Reserved;
+} PC_SAMPLE_BUFFER;
+
+typedef struct {
+  UINT32 Pc;
+  UINT32 Blink; // Return address, if interrupted code has not spilled it
+  UINT32 Count; // Zero for free entry
+} PC_SAMPLE;
+
+/**
+  Clear histogram and start sampling at PcdPcSampleRate.
+
+  CPU exception handlers must be initialized already, see
+  InitializeCpuExceptionHandlers().
+
+  @retval EFI_SUCCESS           Sampling is started.
+  @retval EFI_UNSUPPORTED       Sampling is disabled at build time, or TIMER0
+                                is missing or taken by TimerLib.
+  @retval EFI_ALREADY_STARTED   TIMER0 interrupt has another handler.
+
+**/
+EFI_STATUS
+PcSampleStart(VOID);
+
+/**
+  Stop sampling, histogram is kept.
+
+**/
+VOID
+PcSampleStop(VOID);
+
+/**
+  Write histogram header and used entries to serial port as "@pcs" lines.
+
+**/
+VOID
+PcSampleDump(VOID);
+
+#endif // PC_SAMPLE_LIB_H_
@@ -0,0 +1,56 @@
+/** @file
+  Serial port library extensions.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef SERIAL_PORT_EXT_LIB_H_
+#define SERIAL_PORT_EXT_LIB_H_
+
+#include <Uefi/UefiBaseType.h>
+
+/**
+  Move bytes queued by SerialPortWrite() to serial device.
+
+  @param Wait   FALSE to move only what device can take right away, TRUE to
+                return once every queued byte is transmitted.
+
+**/
+VOID
+EFIAPI
+SerialPortDrain(
+  IN BOOLEAN Wait
+  );
+
+/**
+  Serial device interrupt handler. Moves received bytes to receive ring, to be
+  called by interrupt dispatcher only.
+
+**/
+VOID
+EFIAPI
+SerialPortInterruptHandler(VOID);
+
+/**
+  Enable or disable serial device receive interrupt. Until it is enabled,
+  SerialPortRead() and SerialPortPoll() poll the device. Bytes still in receive
+  ring once it is disabled are dropped.
+
+  @param Enable   TRUE once SerialPortInterruptHandler() is routed device
+                  interrupt, FALSE before it is unrouted.
+
+  @retval EFI_SUCCESS       Receive interrupt is enabled or disabled.
+  @retval EFI_UNSUPPORTED   Serial device has no receive ring.
+
+**/
+EFI_STATUS
+EFIAPI
+SerialPortEnableRxInterrupt(
+  IN BOOLEAN Enable
+  );
+
+#endif // SERIAL_PORT_EXT_LIB_H_
@@ -23,34 +23,161 @@
 
 #define MAX_STR_LEN 256
 
-#ifdef VERBOSE
-#define LOG(...) {\
+//
+// Ring of binary LOG() records kept in temporary RAM. Records are words:
+// LOG_RECORD_MAGIC with argument count in the low byte, address of the
+// logging site anchor, then arguments. A zero word marks the place writer wrapped
+// from. Text is rebuilt off-target by scripts/log-decode.py.
+//
+#define LOG_RING_SIGNATURE SIGNATURE_32('L', 'R', 'N', 'G')
+#define LOG_RECORD_MAGIC 0x4c4f4700
+#define LOG_MAX_ARGS 8
+
+typedef struct {
+  UINT32 Signature;
+  UINT32 Size; // Record area size in bytes, follows the header
+  UINT32 Head; // Write offset within record area
+  UINT32 Lap; // Number of times writer wrapped
+} LOG_RING;
+
+/**
+  Append binary record to log ring.
+
+  Arguments are stored as UINTN values, strings and GUIDs are stored as
+  pointers and resolved by decoder from FD image.
+
+  @param Site       Address of logging site anchor, see LOG_EMIT().
+  @param Args       Record arguments.
+  @param ArgCount   Number of arguments, up to LOG_MAX_ARGS.
+
+**/
+VOID
+LogWrite(
+  IN CONST VOID *Site,
+  IN CONST UINTN *Args,
+  IN UINT8 ArgCount
+  );
+
+/**
+  Write log ring as hex words to serial port, one "@log" line per 8 words.
+
+**/
+VOID
+LogDump(VOID);
+
+/**
+  Write words as hex to serial port, up to 8 per line, each line starting
+  with given tag, so that host scripts can pick them from console output.
+
+  @param Tag      Line tag of 4 characters, e.g. "@log".
+  @param Words    Words to write.
+  @param Count    Number of words.
+
+**/
+VOID
+DumpWords(
+  IN CONST CHAR8 Tag[4],
+  IN CONST UINT32 *Words,
+  IN UINTN Count
+  );
+
+//
+// Counts up to 16 arguments, anything above LOG_MAX_ARGS counts as
+// LOG_MAX_ARGS + 1 and is rejected by LOG_EMIT()
+//
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 9, 9, 9, 9, 9, 9, 9, 9,\
+  8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12,\
+  _13, _14, _15, _16, N, ...) N
+
+#define LOG_ARGS_0()
+#define LOG_ARGS_1(A) , (UINTN) (A)
+#define LOG_ARGS_2(A, ...) , (UINTN) (A) LOG_ARGS_1(__VA_ARGS__)
+#define LOG_ARGS_3(A, ...) , (UINTN) (A) LOG_ARGS_2(__VA_ARGS__)
+#define LOG_ARGS_4(A, ...) , (UINTN) (A) LOG_ARGS_3(__VA_ARGS__)
+#define LOG_ARGS_5(A, ...) , (UINTN) (A) LOG_ARGS_4(__VA_ARGS__)
+#define LOG_ARGS_6(A, ...) , (UINTN) (A) LOG_ARGS_5(__VA_ARGS__)
+#define LOG_ARGS_7(A, ...) , (UINTN) (A) LOG_ARGS_6(__VA_ARGS__)
+#define LOG_ARGS_8(A, ...) , (UINTN) (A) LOG_ARGS_7(__VA_ARGS__)
+#define LOG_ARGS_9(...) // Too many, only STATIC_ASSERT of LOG_EMIT() fails
+#define LOG_ARGS_(N, ...) LOG_ARGS_##N(__VA_ARGS__)
+#define LOG_ARGS(N, ...) LOG_ARGS_(N, ##__VA_ARGS__)
+
+//
+// Log levels. Statements above module's LOG_LEVEL compile to nothing, their
+// arguments are not evaluated, so formatting helpers may only be called from
+// within log statements. Modules set LOG_LEVEL in DSC, e.g.
+//
+//   GCC:DEBUG_*_*_CC_FLAGS = -DLOG_LEVEL=LOG_LEVEL_TRACE
+//
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1 // LOG()
+#define LOG_LEVEL_DEBUG 2 // DBG(), LOG_ENTER(), LOG_EXIT()
+#define LOG_LEVEL_TRACE 3 // TRACE(), per item messages of walks and lookups
+
+#ifndef LOG_LEVEL
+#if defined(VERBOSE) && defined(DEBUG)
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#elif defined(VERBOSE)
+#define LOG_LEVEL LOG_LEVEL_ERROR
+#else
+#define LOG_LEVEL LOG_LEVEL_NONE
+#endif
+#endif
+
+#ifdef LOG_TEXT
+#define LOG_EMIT(...) {\
   CHAR8 Str_[MAX_STR_LEN];\
   UINT8 StrLen_ = AsciiSPrint(Str_, sizeof(Str_), __VA_ARGS__);\
   SerialPortWrite(Str_, StrLen_);\
 }
 #else
+//
+// Each logging site has a one byte anchor in loaded image, whose address
+// keys its records. Format string goes to .logfmt section along with the
+// anchor address. Section is not loaded (see Platform/ARC/LogFmt.lds), so it
+// is only found in .debug images. Anchor is a static object, so copies of the
+// site made by inlining or cloning share it.
+//
+#define LOG_EMIT(Fmt, ...) {\
+  STATIC_ASSERT(LOG_NARGS(__VA_ARGS__) <= LOG_MAX_ARGS,\
+    "Too many log arguments");\
+  STATIC CONST UINT8 Site_ __attribute__((used)) = 0;\
+  STATIC CONST struct {\
+    CONST VOID *Site;\
+    CHAR8 Format[sizeof(Fmt)];\
+  } Fmt_ __attribute__((section(".logfmt"), used)) = { &Site_, Fmt };\
+  CONST UINTN Args_[] = { 0 LOG_ARGS(LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__) };\
+  LogWrite(&Site_, Args_ + 1, LOG_NARGS(__VA_ARGS__));\
+}
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG LOG_EMIT
+#else
 #define LOG(...) ;
 #endif
 
-#ifdef DEBUG
-#define LOG_ENTER() {\
-  CHAR8 Str_[MAX_STR_LEN];\
-  UINT8 StrLen_ = AsciiSPrint(Str_, sizeof(Str_), "Enter %a:%d | %a\n",\
-    __func__, __LINE__, __FILE__);\
-  SerialPortWrite(Str_, StrLen_);\
-}
-#define LOG_EXIT() {\
-  CHAR8 Str_[MAX_STR_LEN];\
-  UINT8 StrLen_ = AsciiSPrint(Str_, sizeof(Str_), "Exit %a:%d | %a\n",\
-    __func__, __LINE__, __FILE__);\
-  SerialPortWrite(Str_, StrLen_);\
-}
-#define DBG LOG
+#if LOG_LEVEL >= LOG_LEVEL_ERROR && !defined(LOG_TEXT)
+#define LOG_DUMP() LogDump()
+#else
+#define LOG_DUMP() ;
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define DBG LOG_EMIT
+#define LOG_ENTER() LOG_EMIT("Enter %a:%d | " __FILE__ "\n", __func__, __LINE__)
+#define LOG_EXIT() LOG_EMIT("Exit %a:%d | " __FILE__ "\n", __func__, __LINE__)
 #else
+#define DBG(...) ;
 #define LOG_ENTER() ;
 #define LOG_EXIT() ;
-#define DBG(...) ;
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_TRACE
+#define TRACE LOG_EMIT
+#else
+#define TRACE(...) ;
 #endif
 
 typedef struct {
@@ -69,6 +196,79 @@ typedef struct {
   CHAR8 Data[sizeof("0xffffffff")];
 } INT32_STR;
 
+//
+// FFS file index filled in by scripts/fv-index.py after the FD is built. It is
+// a FREEFORM file with one RAW section placed among the first files of a
+// volume. Entries are sorted by (Type, Name) with names compared byte-wise.
+//
+#define FFS_INDEX_FILE_GUID {\
+  0xa608ac97, 0xb87b, 0x4d29, {\
+    0xaa, 0x15, 0xb0, 0x74, 0x4a, 0x31, 0x81, 0xdd\
+  }\
+}
+
+#define FFS_INDEX_SIGNATURE SIGNATURE_32('F', 'F', 'S', 'X')
+
+// Number of leading files checked for the index before giving up
+#define FFS_INDEX_SEARCH_DEPTH 4
+
+typedef struct {
+  UINT32 Signature;
+  UINT16 Count; // Zero when the index has not been populated
+  UINT16 Capacity;
+} FFS_INDEX_HEADER;
+
+typedef struct {
+  EFI_GUID Name;
+  UINT32 Offset; // File header offset from volume base
+  UINT8 Type;
+  UINT8 Reserved[3];
+} FFS_INDEX_ENTRY;
+
+//
+// Boot manifest written by scripts/boot-manifest.py into a dedicated flash
+// region (see PcdBootManifestBase). It lists SEC, PEI core and PEIM images
+// with their entry points and fixups; PEIMs appear in dispatch order, i.e.
+// sorted topologically by their dependency expressions.
+//
+#define BOOT_MANIFEST_SIGNATURE SIGNATURE_32('B', 'M', 'F', 'T')
+#define BOOT_MANIFEST_REVISION 4
+
+#define BOOT_MANIFEST_HAS_FIXUP BIT0
+
+typedef struct {
+  UINT32 Signature;
+  UINT16 Revision;
+  UINT16 Count; // Number of entries following the header
+  UINT32 Size; // Header and entries size in bytes
+  UINT32 Checksum; // Makes 32-bit sum of Size bytes zero
+} BOOT_MANIFEST_HEADER;
+
+typedef struct {
+  EFI_GUID FileName;
+  UINT32 EntryPoint;
+  UINT32 FileBase; // FFS file header
+  UINT32 FileSize;
+  UINT32 Fixup;
+  UINT32 Depex; // PEI_DEPEX section data, 0 if there is no such section
+  UINT8 Type; // EFI_FV_FILETYPE_*
+  UINT8 Flags;
+  UINT16 DepexSize;
+} BOOT_MANIFEST_ENTRY;
+
+#define BOOT_MANIFEST_ENTRIES(Manifest_)\
+  ((BOOT_MANIFEST_ENTRY *) ((BOOT_MANIFEST_HEADER *) (Manifest_) + 1))
+
+//
+// Resumable walk over files of a firmware volume. Pad files are skipped and
+// the walk ends at erased free space, so enumerating all files reads each
+// file header once and never looks past the last file.
+//
+typedef struct {
+  EFI_PHYSICAL_ADDRESS Addr; // Next file header to look at
+  EFI_PHYSICAL_ADDRESS Eov; // End of volume
+} FFS_CURSOR;
+
 #define GUID_STR_MAX 36
 
 typedef struct {
@@ -120,6 +320,52 @@ FindSection(
   OUT STATUS_INFO *StatusInfo OPTIONAL
   );
 
+VOID
+InitFfsCursor(
+  OUT FFS_CURSOR *Cursor,
+  IN VOID *FvBase,
+  IN CONST EFI_FFS_FILE_HEADER *File OPTIONAL
+  );
+
+EFI_FFS_FILE_HEADER *
+NextFfsFile(
+  IN OUT FFS_CURSOR *Cursor,
+  OUT STATUS_INFO *StatusInfo OPTIONAL
+  );
+
+FFS_INDEX_HEADER *
+GetFfsIndex(
+  IN VOID *FvBase
+  );
+
+EFI_FFS_FILE_HEADER *
+FindIndexedFile(
+  IN VOID *FvBase,
+  IN CONST FFS_INDEX_HEADER *Index,
+  IN EFI_FV_FILETYPE FileType,
+  IN CONST EFI_GUID *FileName OPTIONAL
+  );
+
+CONST BOOT_MANIFEST_HEADER *
+GetBootManifest(
+  IN VOID *Base
+  );
+
+CONST BOOT_MANIFEST_ENTRY *
+FindManifestEntry(
+  IN CONST BOOT_MANIFEST_HEADER *Manifest,
+  IN EFI_FV_FILETYPE FileType,
+  IN CONST EFI_GUID *FileName OPTIONAL
+  );
+
+EFI_FFS_FILE_HEADER *
+FindFfsFile(
+  IN VOID *FvBase,
+  IN EFI_FV_FILETYPE FileType,
+  IN CONST EFI_GUID *FileName OPTIONAL,
+  OUT STATUS_INFO *StatusInfo OPTIONAL
+  );
+
 VOID *
 GetFileSection(
   IN VOID *FvBase,
@@ -129,6 +375,11 @@ GetFileSection(
   OUT STATUS_INFO *StatusInfo OPTIONAL
   );
 
+VOID *
+GetTeSectionEntryPoint(
+  IN EFI_COMMON_SECTION_HEADER *Section
+  );
+
 VOID *
 GetTeEntryPoint(
   IN VOID *FvBase,
@@ -0,0 +1,163 @@
+/** @file
+  Boot performance records.
+
+  SEC, PEI core and PEIMs append records to a buffer in temporary RAM, see
+  PERF_BUFFER in BootPerfLib.h. DXE IPL converts them to FPDT records of a
+  GUID HOB right before DXE core takes over.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <Library/BootPerfLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UtilsLib.h>
+#include <Guid/ExtendedFirmwarePerformance.h>
+
+#define PERF_BUFFER_BASE FixedPcdGet32(PcdPerfBufferBase)
+#define PERF_BUFFER_SIZE FixedPcdGet32(PcdPerfBufferSize)
+
+#define PERF_BUFFER_CAPACITY\
+  MIN((PERF_BUFFER_SIZE - sizeof(PERF_BUFFER)) / sizeof(PERF_RECORD), MAX_UINT16)
+
+STATIC
+PERF_BUFFER *
+GetPerfBuffer(VOID)
+{
+  PERF_BUFFER *Buffer;
+
+  if (PERF_BUFFER_SIZE < sizeof(PERF_BUFFER) + sizeof(PERF_RECORD)) {
+    return NULL;
+  }
+
+  Buffer = (PERF_BUFFER *) PERF_BUFFER_BASE;
+  if (Buffer->Signature != PERF_BUFFER_SIGNATURE ||
+    Buffer->Capacity != PERF_BUFFER_CAPACITY ||
+    Buffer->Count > Buffer->Capacity) {
+    PerfReset();
+  }
+
+  return Buffer;
+}
+
+VOID
+PerfReset(VOID)
+{
+  PERF_BUFFER *Buffer;
+
+  if (PERF_BUFFER_SIZE < sizeof(PERF_BUFFER) + sizeof(PERF_RECORD)) {
+    return;
+  }
+
+  Buffer = (PERF_BUFFER *) PERF_BUFFER_BASE;
+  Buffer->Signature = PERF_BUFFER_SIGNATURE;
+  Buffer->Count = 0;
+  Buffer->Capacity = PERF_BUFFER_CAPACITY;
+  Buffer->Dropped = 0;
+  Buffer->Reserved = 0;
+}
+
+VOID
+PerfRecordTicks(
+  IN UINT64 Ticks,
+  IN UINT16 ProgressId,
+  IN CONST EFI_GUID *Guid
+  )
+{
+  PERF_BUFFER *Buffer;
+  PERF_RECORD *Record;
+
+  Buffer = GetPerfBuffer();
+  if (Buffer == NULL) {
+    return;
+  }
+
+  if (Buffer->Count == Buffer->Capacity) {
+    Buffer->Dropped++;
+    return;
+  }
+
+  Record = (PERF_RECORD *) (Buffer + 1) + Buffer->Count++;
+  Record->Ticks = Ticks;
+  Record->Guid = Guid;
+  Record->ProgressId = ProgressId;
+}
+
+VOID
+PerfRecord(
+  IN UINT16 ProgressId,
+  IN CONST EFI_GUID *Guid
+  )
+{
+  if (PERF_BUFFER_SIZE != 0) {
+    PerfRecordTicks(GetPerformanceCounter(), ProgressId, Guid);
+  }
+}
+
+VOID
+PerfPhase(
+  IN UINT32 Phase,
+  IN UINT64 Ticks
+  )
+{
+  UINT32 Marker[3];
+
+  if (FixedPcdGetBool(PcdBootPhaseMarkers)) {
+    Marker[0] = Phase;
+    Marker[1] = (UINT32) RShiftU64(Ticks, 32);
+    Marker[2] = (UINT32) Ticks;
+    DumpWords("@phs", Marker, ARRAY_SIZE(Marker));
+  }
+}
+
+EFI_STATUS
+BuildPerfHob(
+  IN OUT EFI_HOB_HANDOFF_INFO_TABLE *HobList
+  )
+{
+  CONST PERF_BUFFER *Buffer;
+  CONST PERF_RECORD *Record;
+  FPDT_PEI_EXT_PERF_HEADER *Header;
+  FPDT_GUID_EVENT_RECORD *Event;
+  UINT32 Size;
+  UINT16 Idx;
+
+  Buffer = GetPerfBuffer();
+  if (Buffer == NULL || Buffer->Count == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  Size = Buffer->Count * sizeof(FPDT_GUID_EVENT_RECORD);
+  Header = AddGuidHob(HobList, &gEdkiiFpdtExtendedFirmwarePerformanceGuid,
+    sizeof(*Header) + Size);
+  if (Header == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Header->SizeOfAllEntries = Size;
+  Header->LoadImageCount = 0;
+  Header->HobIsFull = Buffer->Dropped != 0;
+
+  Record = (CONST PERF_RECORD *) (Buffer + 1);
+  Event = (FPDT_GUID_EVENT_RECORD *) (Header + 1);
+  for (Idx = 0; Idx < Buffer->Count; Idx++, Record++, Event++) {
+    Event->Header.Type = FPDT_GUID_EVENT_TYPE;
+    Event->Header.Length = sizeof(*Event);
+    Event->Header.Revision = FPDT_RECORD_REVISION_1;
+    Event->ProgressID = Record->ProgressId;
+    Event->ApicID = 0;
+    Event->Timestamp = GetTimeInNanoSecond(Record->Ticks);
+    if (Record->Guid != NULL) {
+      CopyGuid(&Event->Guid, Record->Guid);
+    } else {
+      ZeroMem(&Event->Guid, sizeof(Event->Guid));
+    }
+  }
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,88 @@
+/** @file
+  Minimal HOB list built in temporary RAM for hand off to DXE.
+
+  UEFI PI 1.8: III-5. HOB Code Definitions.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <Library/BootPerfLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+
+STATIC
+VOID
+SetEndOfHobList(
+  IN OUT EFI_HOB_HANDOFF_INFO_TABLE *HobList,
+  IN EFI_PHYSICAL_ADDRESS End
+  )
+{
+  EFI_HOB_GENERIC_HEADER *Hob;
+
+  Hob = (EFI_HOB_GENERIC_HEADER *) (UINTN) End;
+  Hob->HobType = EFI_HOB_TYPE_END_OF_HOB_LIST;
+  Hob->HobLength = sizeof(*Hob);
+  Hob->Reserved = 0;
+
+  HobList->EfiEndOfHobList = End;
+  HobList->EfiFreeMemoryBottom = End + sizeof(*Hob);
+}
+
+EFI_HOB_HANDOFF_INFO_TABLE *
+CreateHobList(
+  IN VOID *Base,
+  IN UINTN Size
+  )
+{
+  EFI_HOB_HANDOFF_INFO_TABLE *HobList;
+
+  if (Size < sizeof(*HobList) + sizeof(EFI_HOB_GENERIC_HEADER)) {
+    return NULL;
+  }
+
+  HobList = (EFI_HOB_HANDOFF_INFO_TABLE *) Base;
+  HobList->Header.HobType = EFI_HOB_TYPE_HANDOFF;
+  HobList->Header.HobLength = sizeof(*HobList);
+  HobList->Header.Reserved = 0;
+  HobList->Version = EFI_HOB_HANDOFF_TABLE_VERSION;
+  HobList->BootMode = BOOT_WITH_FULL_CONFIGURATION;
+  HobList->EfiMemoryBottom = (EFI_PHYSICAL_ADDRESS) (UINTN) Base;
+  HobList->EfiMemoryTop = HobList->EfiMemoryBottom + Size;
+  HobList->EfiFreeMemoryTop = HobList->EfiMemoryTop;
+
+  SetEndOfHobList(HobList, HobList->EfiMemoryBottom + sizeof(*HobList));
+  return HobList;
+}
+
+VOID *
+AddGuidHob(
+  IN OUT EFI_HOB_HANDOFF_INFO_TABLE *HobList,
+  IN CONST EFI_GUID *Guid,
+  IN UINTN DataLength
+  )
+{
+  EFI_HOB_GUID_TYPE *Hob;
+  UINTN Length;
+
+  //
+  // HobLength is 16-bit and HOBs are 8-byte aligned
+  //
+  Length = ALIGN_VALUE(sizeof(*Hob) + DataLength, 8);
+  if (Length > MAX_UINT16 || HobList->EfiEndOfHobList + Length +
+    sizeof(EFI_HOB_GENERIC_HEADER) > HobList->EfiFreeMemoryTop) {
+    return NULL;
+  }
+
+  Hob = (EFI_HOB_GUID_TYPE *) (UINTN) HobList->EfiEndOfHobList;
+  Hob->Header.HobType = EFI_HOB_TYPE_GUID_EXTENSION;
+  Hob->Header.HobLength = (UINT16) Length;
+  Hob->Header.Reserved = 0;
+  CopyGuid(&Hob->Name, Guid);
+
+  SetEndOfHobList(HobList, HobList->EfiEndOfHobList + Length);
+  return Hob + 1;
+}
@@ -0,0 +1,151 @@
+/** @file
+  Cache maintenance benchmark PEIM.
+
+  Measures performance counter ticks taken by range and whole cache
+  operations of CacheMaintenanceLib on a buffer of growing size and writes
+  them as "@cbn" lines, see scripts/cache-bench.py. The module is built with
+  PcdArcCacheFlushThreshold at MAX_UINT32, so range operations never fall
+  back to whole cache ones here, and the size whole cache operations start
+  to win at is the one to set the threshold to.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <PiPei.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/CacheMaintenanceLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UtilsLib.h>
+
+#define CACHE_BENCH_BUFFER_BASE FixedPcdGet32(PcdCacheBenchBufferBase)
+#define CACHE_BENCH_BUFFER_SIZE FixedPcdGet32(PcdCacheBenchBufferSize)
+
+#define CACHE_BENCH_SIGNATURE SIGNATURE_32('C', 'B', 'N', 'C')
+#define CACHE_BENCH_MIN_SIZE SIZE_1KB
+#define CACHE_BENCH_REPEAT 4 // Best of
+
+#define FOR_EACH_SIZE(Size)\
+  for (Size = CACHE_BENCH_MIN_SIZE;\
+    Size != 0 && Size <= CACHE_BENCH_BUFFER_SIZE; Size <<= 1)
+
+typedef VOID *(EFIAPI *RANGE_OP)(VOID *Address, UINTN Length);
+typedef VOID (EFIAPI *WHOLE_OP)(VOID);
+
+typedef struct {
+  RANGE_OP Range;
+  WHOLE_OP Whole;
+} CACHE_OP;
+
+//
+// Order matches OPS in scripts/cache-bench.py
+//
+STATIC CONST CACHE_OP mOps[] = {
+  { WriteBackDataCacheRange, WriteBackDataCache },
+  { WriteBackInvalidateDataCacheRange, WriteBackInvalidateDataCache },
+  { InvalidateInstructionCacheRange, InvalidateInstructionCache },
+};
+
+typedef struct {
+  UINT32 Signature;
+  UINT32 Frequency;
+  UINT32 Count; // Of CACHE_BENCH_RESULT following
+} CACHE_BENCH_HEADER;
+
+typedef struct {
+  UINT32 Op; // Index in mOps
+  UINT32 Size;
+  UINT32 RangeTicks;
+  UINT32 WholeTicks;
+} CACHE_BENCH_RESULT;
+
+STATIC
+UINT32
+Elapsed(
+  IN UINT64 Start
+  )
+{
+  UINT64 Mask;
+  UINT64 Ticks;
+
+  GetPerformanceCounterProperties(NULL, &Mask);
+  Ticks = (GetPerformanceCounter() - Start) & Mask;
+  return Ticks > MAX_UINT32 ? MAX_UINT32 : (UINT32) Ticks;
+}
+
+/**
+  Take best of a few runs of either operation with buffer dirtied before
+  each run, so there is the same data to write back every time.
+
+**/
+STATIC
+UINT32
+Measure(
+  IN CONST CACHE_OP *Op,
+  IN UINT8 *Buffer,
+  IN UINT32 Size,
+  IN BOOLEAN Whole
+  )
+{
+  UINT32 Best;
+  UINT32 Ticks;
+  UINT64 Start;
+  UINTN Run;
+
+  Best = MAX_UINT32;
+  for (Run = 0; Run < CACHE_BENCH_REPEAT; Run++) {
+    SetMem(Buffer, Size, (UINT8) Run);
+    Start = GetPerformanceCounter();
+    if (Whole) {
+      Op->Whole();
+    } else {
+      Op->Range(Buffer, Size);
+    }
+
+    Ticks = Elapsed(Start);
+    Best = MIN(Best, Ticks);
+  }
+
+  return Best;
+}
+
+EFI_STATUS
+EFIAPI
+CacheBenchMain(
+  IN       EFI_PEI_FILE_HANDLE  FileHandle,
+  IN CONST EFI_PEI_SERVICES     **PeiServices
+  )
+{
+  CACHE_BENCH_HEADER Header;
+  CACHE_BENCH_RESULT Result;
+  UINT8 *Buffer;
+  UINT32 Size;
+
+  if (CACHE_BENCH_BUFFER_SIZE < CACHE_BENCH_MIN_SIZE) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Buffer = (UINT8 *) CACHE_BENCH_BUFFER_BASE;
+  Header.Signature = CACHE_BENCH_SIGNATURE;
+  Header.Frequency = (UINT32) GetPerformanceCounterProperties(NULL, NULL);
+  Header.Count = 0;
+  FOR_EACH_SIZE(Size) {
+    Header.Count += ARRAY_SIZE(mOps);
+  }
+
+  DumpWords("@cbn", (CONST UINT32 *) &Header, sizeof(Header) / 4);
+  for (Result.Op = 0; Result.Op < ARRAY_SIZE(mOps); Result.Op++) {
+    FOR_EACH_SIZE(Size) {
+      Result.Size = Size;
+      Result.RangeTicks = Measure(&mOps[Result.Op], Buffer, Size, FALSE);
+      Result.WholeTicks = Measure(&mOps[Result.Op], Buffer, Size, TRUE);
+      DumpWords("@cbn", (CONST UINT32 *) &Result, sizeof(Result) / 4);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
@@ -1,6 +1,20 @@
 /** @file
   ARCv2 cache manipulating functions.
 
+  Line length and size of each cache are decoded by ArcCpuInfoLib from its
+  build configuration register by every call, which costs a single aux
+  register read, the same as a load of a cached value would. Range operations
+  go line by line, ranges of PcdArcCacheFlushThreshold bytes or more (cache
+  size when it is 0) are handled by whole cache operations instead, except
+  data cache invalidation, which must not touch lines outside of the range.
+
+  Instruction cache does not snoop data cache, so instruction cache
+  invalidation writes data cache back first, as ARM CacheMaintenanceLib does.
+
+  SLC operations of Include/Library/ArcCacheLib.h follow the same rules. SLC
+  does whole cache and address range operations itself, ranges are given by
+  start and end instead of line by line.
+
   Copyright (c) 2023 Basemark Oy
 
   Author: Aliaksei Katovich @ basemark.com
@@ -9,6 +23,147 @@
 **/
 
 #include <Base.h>
+#include <Library/CacheMaintenanceLib.h>
+#include <Library/ArcCacheLib.h>
+#include <Library/ArcCpuInfoLib.h>
+#include <Library/PcdLib.h>
+#include <Common/Cpu.h>
+
+#define FLUSH_THRESHOLD FixedPcdGet32(PcdArcCacheFlushThreshold)
+
+//
+// Geometry of caches that are there and enabled only
+//
+STATIC
+BOOLEAN
+GetICacheInfo(
+  OUT ARC_CACHE_INFO *Info
+  )
+{
+  return GetArcICacheInfo(Info) &&
+    (__builtin_arc_lr(ARC_AUX_IC_CTRL) & (1 << CACHE_CTRL_DC_BIT)) == 0;
+}
+
+STATIC
+BOOLEAN
+GetDCacheInfo(
+  OUT ARC_CACHE_INFO *Info
+  )
+{
+  return GetArcDCacheInfo(Info) &&
+    (__builtin_arc_lr(ARC_AUX_DC_CTRL) & (1 << CACHE_CTRL_DC_BIT)) == 0;
+}
+
+STATIC
+BOOLEAN
+GetSlcInfo(
+  OUT ARC_CACHE_INFO *Info
+  )
+{
+  return GetArcSlcInfo(Info) &&
+    (__builtin_arc_lr(ARC_AUX_SLC_CTRL) & (1 << CACHE_CTRL_DC_BIT)) == 0;
+}
+
+STATIC
+BOOLEAN
+IsLargeRange(
+  IN CONST ARC_CACHE_INFO *Info,
+  IN UINTN Length
+  )
+{
+  return Length >= (FLUSH_THRESHOLD != 0 ? FLUSH_THRESHOLD : Info->Size);
+}
+
+//
+// Line operations take any address within line, line is aligned down only
+// to find where the next one starts
+//
+#define FOR_EACH_LINE(Line, Address, Length, LineSize)\
+  for (Line = (UINTN) (Address) & ~((UINTN) (LineSize) - 1);\
+    Line < (UINTN) (Address) + (Length); Line += (LineSize))
+
+STATIC
+VOID
+WaitDCacheFlush(VOID)
+{
+  while ((__builtin_arc_lr(ARC_AUX_DC_CTRL) & (1 << DC_CTRL_FS_BIT)) != 0) {
+  }
+}
+
+/**
+  Select whether IVDC and IVDL write dirty lines back before invalidation.
+
+  @param WriteBack  Write dirty lines back.
+
+  @return DC_CTRL value to be restored once invalidation is done.
+
+**/
+STATIC
+UINT32
+SetDCacheInvalidateMode(
+  IN BOOLEAN WriteBack
+  )
+{
+  UINT32 Ctrl;
+
+  Ctrl = __builtin_arc_lr(ARC_AUX_DC_CTRL);
+  if (WriteBack) {
+    __builtin_arc_sr(Ctrl | (1 << DC_CTRL_IM_BIT), ARC_AUX_DC_CTRL);
+  } else {
+    __builtin_arc_sr(Ctrl & ~(1 << DC_CTRL_IM_BIT), ARC_AUX_DC_CTRL);
+  }
+
+  return Ctrl;
+}
+
+STATIC
+VOID
+InvalidateWholeDCache(
+  IN BOOLEAN WriteBack
+  )
+{
+  ARC_CACHE_INFO Info;
+  UINT32 Ctrl;
+
+  if (!GetDCacheInfo(&Info)) {
+    return;
+  }
+
+  Ctrl = SetDCacheInvalidateMode(WriteBack);
+  __builtin_arc_sr(1, ARC_AUX_DC_IVDC);
+  WaitDCacheFlush();
+  __builtin_arc_sr(Ctrl, ARC_AUX_DC_CTRL);
+}
+
+STATIC
+VOID
+InvalidateDCacheLines(
+  IN VOID *Address,
+  IN UINTN Length,
+  IN BOOLEAN WriteBack
+  )
+{
+  ARC_CACHE_INFO Info;
+  UINT32 Ctrl;
+  UINTN Line;
+
+  if (Length == 0 || !GetDCacheInfo(&Info)) {
+    return;
+  }
+
+  if (WriteBack && IsLargeRange(&Info, Length)) {
+    InvalidateWholeDCache(TRUE);
+    return;
+  }
+
+  Ctrl = SetDCacheInvalidateMode(WriteBack);
+  FOR_EACH_LINE(Line, Address, Length, Info.LineSize) {
+    __builtin_arc_sr(Line, ARC_AUX_DC_IVDL);
+  }
+
+  WaitDCacheFlush();
+  __builtin_arc_sr(Ctrl, ARC_AUX_DC_CTRL);
+}
 
 /**
   Invalidates the entire instruction cache in cache coherency domain of the
@@ -19,6 +174,13 @@ VOID
 EFIAPI
 InvalidateInstructionCache(VOID)
 {
+  ARC_CACHE_INFO Info;
+
+  WriteBackDataCache();
+  if (GetICacheInfo(&Info)) {
+    __builtin_arc_sr(1, ARC_AUX_IC_IVIC);
+    __builtin_arc_lr(ARC_AUX_IC_CTRL); // Blocks until IVIC is done
+  }
 }
 
 /**
@@ -53,6 +215,25 @@ InvalidateInstructionCacheRange(
   IN UINTN  Length
   )
 {
+  ARC_CACHE_INFO Info;
+  UINTN Line;
+
+  if (Length == 0 || !GetICacheInfo(&Info)) {
+    WriteBackDataCacheRange(Address, Length);
+    return Address;
+  }
+
+  if (IsLargeRange(&Info, Length)) {
+    InvalidateInstructionCache();
+    return Address;
+  }
+
+  WriteBackDataCacheRange(Address, Length);
+  FOR_EACH_LINE(Line, Address, Length, Info.LineSize) {
+    __builtin_arc_sr(Line, ARC_AUX_IC_IVIL);
+  }
+
+  __builtin_arc_lr(ARC_AUX_IC_CTRL);
   return Address;
 }
 
@@ -70,6 +251,7 @@ VOID
 EFIAPI
 WriteBackInvalidateDataCache(VOID)
 {
+  InvalidateWholeDCache(TRUE);
 }
 
 /**
@@ -105,6 +287,7 @@ WriteBackInvalidateDataCacheRange(
   IN UINTN  Length
   )
 {
+  InvalidateDCacheLines(Address, Length, TRUE);
   return Address;
 }
 
@@ -122,6 +305,12 @@ VOID
 EFIAPI
 WriteBackDataCache(VOID)
 {
+  ARC_CACHE_INFO Info;
+
+  if (GetDCacheInfo(&Info)) {
+    __builtin_arc_sr(1, ARC_AUX_DC_FLSH);
+    WaitDCacheFlush();
+  }
 }
 
 /**
@@ -156,6 +345,23 @@ WriteBackDataCacheRange(
   IN UINTN  Length
   )
 {
+  ARC_CACHE_INFO Info;
+  UINTN Line;
+
+  if (Length == 0 || !GetDCacheInfo(&Info)) {
+    return Address;
+  }
+
+  if (IsLargeRange(&Info, Length)) {
+    WriteBackDataCache();
+    return Address;
+  }
+
+  FOR_EACH_LINE(Line, Address, Length, Info.LineSize) {
+    __builtin_arc_sr(Line, ARC_AUX_DC_FLDL);
+  }
+
+  WaitDCacheFlush();
   return Address;
 }
 
@@ -174,6 +380,7 @@ VOID
 EFIAPI
 InvalidateDataCache(VOID)
 {
+  InvalidateWholeDCache(FALSE);
 }
 
 /**
@@ -210,5 +417,163 @@ InvalidateDataCacheRange (
   IN UINTN  Length
   )
 {
+  InvalidateDCacheLines(Address, Length, FALSE);
+  return Address;
+}
+
+STATIC
+VOID
+WaitSlc(VOID)
+{
+  //
+  // Busy bit may not be set yet on the first read after operation starts
+  //
+  __builtin_arc_lr(ARC_AUX_SLC_CTRL);
+  while ((__builtin_arc_lr(ARC_AUX_SLC_CTRL) & (1 << SLC_CTRL_BUSY_BIT)) != 0) {
+  }
+}
+
+/**
+  Select what SLC_INVALIDATE and region operations do.
+
+  @param WriteBack    Write dirty lines back, before invalidation if any.
+  @param Invalidate   Region operation invalidates lines.
+
+  @return SLC_CTRL value to be restored once operation is done.
+
+**/
+STATIC
+UINT32
+SetSlcMode(
+  IN BOOLEAN WriteBack,
+  IN BOOLEAN Invalidate
+  )
+{
+  UINT32 Ctrl;
+  UINT32 Mode;
+
+  Ctrl = __builtin_arc_lr(ARC_AUX_SLC_CTRL);
+  Mode = Ctrl & ~((1 << SLC_CTRL_IM_BIT) | (1 << SLC_CTRL_RGN_OP_INV_BIT));
+  if (WriteBack) {
+    Mode |= 1 << SLC_CTRL_IM_BIT;
+  }
+
+  if (Invalidate) {
+    Mode |= 1 << SLC_CTRL_RGN_OP_INV_BIT;
+  }
+
+  __builtin_arc_sr(Mode, ARC_AUX_SLC_CTRL);
+  return Ctrl;
+}
+
+STATIC
+VOID
+WholeSlcOp(
+  IN BOOLEAN WriteBack,
+  IN BOOLEAN Invalidate
+  )
+{
+  ARC_CACHE_INFO Info;
+  UINT32 Ctrl;
+
+  if (!GetSlcInfo(&Info)) {
+    return;
+  }
+
+  Ctrl = SetSlcMode(WriteBack, Invalidate);
+  if (Invalidate) {
+    __builtin_arc_sr(1, ARC_AUX_SLC_INVALIDATE);
+  } else {
+    __builtin_arc_sr(1, ARC_AUX_SLC_FLUSH);
+  }
+
+  WaitSlc();
+  __builtin_arc_sr(Ctrl, ARC_AUX_SLC_CTRL);
+}
+
+STATIC
+VOID
+SlcRangeOp(
+  IN VOID *Address,
+  IN UINTN Length,
+  IN BOOLEAN WriteBack,
+  IN BOOLEAN Invalidate
+  )
+{
+  ARC_CACHE_INFO Info;
+  UINT32 Ctrl;
+
+  if (Length == 0 || !GetSlcInfo(&Info)) {
+    return;
+  }
+
+  if (WriteBack && IsLargeRange(&Info, Length)) {
+    WholeSlcOp(WriteBack, Invalidate);
+    return;
+  }
+
+  //
+  // Writing region start starts the operation. End must not equal start, so
+  // it is moved a line less a byte further, as ARC Linux does.
+  //
+  Ctrl = SetSlcMode(WriteBack, Invalidate);
+  __builtin_arc_sr((UINTN) Address + Length + Info.LineSize - 1,
+    ARC_AUX_SLC_RGN_END);
+  __builtin_arc_sr((UINTN) Address, ARC_AUX_SLC_RGN_START);
+  WaitSlc();
+  __builtin_arc_sr(Ctrl, ARC_AUX_SLC_CTRL);
+}
+
+VOID
+EFIAPI
+WriteBackSlc(VOID)
+{
+  WholeSlcOp(TRUE, FALSE);
+}
+
+VOID
+EFIAPI
+WriteBackInvalidateSlc(VOID)
+{
+  WholeSlcOp(TRUE, TRUE);
+}
+
+VOID
+EFIAPI
+InvalidateSlc(VOID)
+{
+  WholeSlcOp(FALSE, TRUE);
+}
+
+VOID *
+EFIAPI
+WriteBackSlcRange(
+  IN VOID *Address,
+  IN UINTN Length
+  )
+{
+  SlcRangeOp(Address, Length, TRUE, FALSE);
+  return Address;
+}
+
+VOID *
+EFIAPI
+WriteBackInvalidateSlcRange(
+  IN VOID *Address,
+  IN UINTN Length
+  )
+{
+  SlcRangeOp(Address, Length, TRUE, TRUE);
+  return Address;
+}
+
+VOID *
+EFIAPI
+InvalidateSlcRange(
+  IN VOID *Address,
+  IN UINTN Length
+  )
+{
+  SlcRangeOp(Address, Length, FALSE, TRUE);
   return Address;
 }
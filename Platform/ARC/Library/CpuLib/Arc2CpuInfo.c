@@ -0,0 +1,104 @@
+/** @file
+  ARCv2 cache geometry and core topology decoding.
+
+  Build configuration registers read as 0 when the block they describe is not
+  there, so nothing needs to be probed first, except SLC_CFG, which is not a
+  build configuration register and is read only when SLC_BUILD says there is
+  SLC.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <Base.h>
+#include <Library/ArcCpuInfoLib.h>
+#include <Common/Cpu.h>
+
+STATIC
+BOOLEAN
+DecodeCacheBuild(
+  IN UINT32 Build,
+  IN UINT32 MinLineSize,
+  OUT ARC_CACHE_INFO *Info
+  )
+{
+  Info->Version = Build & CACHE_BUILD_VER_MASK;
+  if (Info->Version == 0) {
+    Info->Size = 0;
+    Info->LineSize = 0;
+    Info->Ways = 0;
+    return FALSE;
+  }
+
+  Info->Size = 512 <<
+    ((Build >> CACHE_BUILD_SIZE_SHIFT) & CACHE_BUILD_FIELD_MASK);
+  Info->LineSize = MinLineSize <<
+    ((Build >> CACHE_BUILD_LINE_SHIFT) & CACHE_BUILD_FIELD_MASK);
+  Info->Ways = 1 <<
+    ((Build >> CACHE_BUILD_WAYS_SHIFT) & CACHE_BUILD_FIELD_MASK);
+  return TRUE;
+}
+
+BOOLEAN
+GetArcICacheInfo(
+  OUT ARC_CACHE_INFO *Info
+  )
+{
+  return DecodeCacheBuild(__builtin_arc_lr(ARC_BCR_IC_BUILD), 8, Info);
+}
+
+BOOLEAN
+GetArcDCacheInfo(
+  OUT ARC_CACHE_INFO *Info
+  )
+{
+  return DecodeCacheBuild(__builtin_arc_lr(ARC_BCR_DC_BUILD), 16, Info);
+}
+
+BOOLEAN
+GetArcSlcInfo(
+  OUT ARC_CACHE_INFO *Info
+  )
+{
+  UINT32 Cfg;
+
+  Info->Version = __builtin_arc_lr(ARC_BCR_SLC) & CACHE_BUILD_VER_MASK;
+  if (Info->Version == 0) {
+    Info->Size = 0;
+    Info->LineSize = 0;
+    Info->Ways = 0;
+    return FALSE;
+  }
+
+  Cfg = __builtin_arc_lr(ARC_AUX_SLC_CFG);
+  Info->Size = SIZE_128KB << (Cfg & SLC_CFG_SIZE_MASK);
+  Info->LineSize =
+    ((Cfg >> SLC_CFG_LINE_SHIFT) & SLC_CFG_LINE_MASK) == 0 ? 128 : 64;
+  Info->Ways = 4 << ((Cfg >> SLC_CFG_WAYS_SHIFT) & SLC_CFG_WAYS_MASK);
+  return TRUE;
+}
+
+VOID
+GetArcCpuInfo(
+  OUT ARC_CPU_INFO *Info
+  )
+{
+  UINT32 Cores;
+
+  Info->Revision = ARC_CPU_INFO_REVISION;
+  Info->CoreId = (__builtin_arc_lr(ARC_AUX_IDENTITY) >> IDENTITY_CORE_SHIFT) &
+    IDENTITY_CORE_MASK;
+
+  Cores = (__builtin_arc_lr(ARC_BCR_MCIP) >> MCIP_BCR_CORES_SHIFT) &
+    MCIP_BCR_CORES_MASK;
+  Info->CoreCount = Cores != 0 ? Cores : 1;
+
+  Info->DspVersion = __builtin_arc_lr(ARC_AUX_DSP_BUILD) & DSP_BUILD_VER_MASK;
+
+  GetArcICacheInfo(&Info->ICache);
+  GetArcDCacheInfo(&Info->DCache);
+  GetArcSlcInfo(&Info->Slc);
+}
@@ -0,0 +1,229 @@
+/** @file
+  ARCv2 atomic primitives.
+
+  Read-modify-write is LLOCK, which sets a reservation on the address, and
+  SCOND, which stores only if the reservation still holds and reports it in
+  Z flag, retried until the store succeeds. LLOCK/SCOND give no ordering on
+  their own, so every primitive is bracketed with DMB 3 (loads and stores),
+  as EDK2 expects Interlocked*() to be full barriers. There are no 16-bit
+  LLOCK/SCOND, 16-bit compare exchange works on the aligned word holding the
+  value.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include "CpuSyncInternals.h"
+
+#define DMB() __asm__ __volatile__ ("dmb 3" : : : "memory")
+
+//
+// Fetch-and-op loop, Op is the instruction combining original value with
+// Data into the value stored
+//
+#define FETCH_OP(Op, Value, Data, Original)\
+  do {\
+    UINT32 Update;\
+    DMB();\
+    __asm__ __volatile__ (\
+      "1: llock  %0, [%2]   \n"\
+      "   " Op "  %1, %0, %3 \n"\
+      "   scond  %1, [%2]   \n"\
+      "   bnz    1b         \n"\
+      : "=&r" (Original), "=&r" (Update)\
+      : "r" (Value), "r" (Data)\
+      : "cc", "memory");\
+    DMB();\
+  } while (0)
+
+VOID
+EFIAPI
+InternalSyncMemoryBarrier(VOID)
+{
+  DMB();
+}
+
+UINT32
+EFIAPI
+InternalSyncCompareExchange32(
+  IN volatile UINT32 *Value,
+  IN UINT32 CompareValue,
+  IN UINT32 ExchangeValue
+  )
+{
+  UINT32 Original;
+
+  DMB();
+  __asm__ __volatile__ (
+    "1: llock  %0, [%1]   \n"
+    "   brne   %0, %2, 2f \n"
+    "   scond  %3, [%1]   \n"
+    "   bnz    1b         \n"
+    "2:                   \n"
+    : "=&r" (Original)
+    : "r" (Value), "r" (CompareValue), "r" (ExchangeValue)
+    : "cc", "memory");
+  DMB();
+
+  return Original;
+}
+
+UINT16
+EFIAPI
+InternalSyncCompareExchange16(
+  IN volatile UINT16 *Value,
+  IN UINT16 CompareValue,
+  IN UINT16 ExchangeValue
+  )
+{
+  volatile UINT32 *Word;
+  UINT32 Shift;
+  UINT32 Mask;
+  UINT32 Current;
+  UINT32 Update;
+
+  Word = (volatile UINT32 *) ((UINTN) Value & ~(UINTN) 3);
+  Shift = ((UINTN) Value & 2) * 8;
+  Mask = (UINT32) MAX_UINT16 << Shift;
+
+  DMB();
+  __asm__ __volatile__ (
+    "1: llock  %0, [%2]   \n"
+    "   and    %1, %0, %3 \n"
+    "   brne   %1, %4, 2f \n"
+    "   bic    %1, %0, %3 \n"
+    "   or     %1, %1, %5 \n"
+    "   scond  %1, [%2]   \n"
+    "   bnz    1b         \n"
+    "2:                   \n"
+    : "=&r" (Current), "=&r" (Update)
+    : "r" (Word), "r" (Mask), "r" ((UINT32) CompareValue << Shift),
+      "r" ((UINT32) ExchangeValue << Shift)
+    : "cc", "memory");
+  DMB();
+
+  return (UINT16) ((Current & Mask) >> Shift);
+}
+
+#ifdef __ARC_LL64__
+UINT64
+EFIAPI
+InternalSyncCompareExchange64(
+  IN volatile UINT64 *Value,
+  IN UINT64 CompareValue,
+  IN UINT64 ExchangeValue
+  )
+{
+  UINT64 Original;
+
+  DMB();
+  __asm__ __volatile__ (
+    "1: llockd  %0, [%1]     \n"
+    "   brne    %L0, %L2, 2f \n"
+    "   brne    %H0, %H2, 2f \n"
+    "   scondd  %3, [%1]     \n"
+    "   bnz     1b           \n"
+    "2:                      \n"
+    : "=&r" (Original)
+    : "r" (Value), "r" (CompareValue), "r" (ExchangeValue)
+    : "cc", "memory");
+  DMB();
+
+  return Original;
+}
+#else
+#error "64-bit compare exchange needs LLOCKD/SCONDD, build with -mll64"
+#endif
+
+UINT32
+EFIAPI
+InternalSyncFetchAdd32(
+  IN volatile UINT32 *Value,
+  IN UINT32 Addend
+  )
+{
+  UINT32 Original;
+
+  FETCH_OP("add", Value, Addend, Original);
+  return Original;
+}
+
+UINT32
+EFIAPI
+InternalSyncFetchAnd32(
+  IN volatile UINT32 *Value,
+  IN UINT32 AndData
+  )
+{
+  UINT32 Original;
+
+  FETCH_OP("and", Value, AndData, Original);
+  return Original;
+}
+
+UINT32
+EFIAPI
+InternalSyncFetchOr32(
+  IN volatile UINT32 *Value,
+  IN UINT32 OrData
+  )
+{
+  UINT32 Original;
+
+  FETCH_OP("or ", Value, OrData, Original);
+  return Original;
+}
+
+UINT32
+EFIAPI
+InternalSyncExchange32(
+  IN volatile UINT32 *Value,
+  IN UINT32 ExchangeValue
+  )
+{
+  UINT32 Original;
+
+  DMB();
+  __asm__ __volatile__ (
+    "1: llock  %0, [%1]   \n"
+    "   scond  %2, [%1]   \n"
+    "   bnz    1b         \n"
+    : "=&r" (Original)
+    : "r" (Value), "r" (ExchangeValue)
+    : "cc", "memory");
+  DMB();
+
+  return Original;
+}
+
+VOID *
+EFIAPI
+InternalSyncExchangePointer(
+  IN VOID *volatile *Value,
+  IN VOID *ExchangeValue
+  )
+{
+  return (VOID *) (UINTN) InternalSyncExchange32((volatile UINT32 *) Value,
+    (UINT32) (UINTN) ExchangeValue);
+}
+
+UINT32
+EFIAPI
+InternalSyncIncrement(
+  IN volatile UINT32 *Value
+  )
+{
+  return InternalSyncFetchAdd32(Value, 1) + 1;
+}
+
+UINT32
+EFIAPI
+InternalSyncDecrement(
+  IN volatile UINT32 *Value
+  )
+{
+  return InternalSyncFetchAdd32(Value, (UINT32) -1) - 1;
+}
@@ -0,0 +1,273 @@
+/** @file
+  ARCv2 timer library.
+
+  Performance counter is 64-bit RTC when TIMER_BUILD reports one, otherwise
+  free running 32-bit TIMER1 or TIMER0. Counters run at CPU clock, which has
+  no other reference to calibrate against, so frequency is taken from
+  PcdArcTimerFrequency and is not measured. Its default is QEMU's 50 MHz,
+  real boards have to set it to their CPU clock in their fdf, or every delay
+  and timestamp is off by the ratio. Counters are started on first use
+  rather than by a constructor.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <Base.h>
+#include <Library/BaseLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Common/Cpu.h>
+
+#define TIMER_FREQUENCY FixedPcdGet32(PcdArcTimerFrequency)
+
+/**
+  Read free running 32-bit timer, program it first if needed.
+
+  @param  Count     COUNTn register of the timer.
+  @param  Control   CONTROLn register of the timer.
+  @param  Limit     LIMITn register of the timer.
+
+  @return Current count.
+**/
+STATIC
+UINT64
+ReadTimer(
+  IN UINT32 Count,
+  IN UINT32 Control,
+  IN UINT32 Limit
+  )
+{
+  if (__builtin_arc_lr(Limit) != MAX_UINT32) {
+    __builtin_arc_sr(1U << TIMER_CTRL_NH_BIT, Control); // No interrupt
+    __builtin_arc_sr(MAX_UINT32, Limit);
+    __builtin_arc_sr(0, Count);
+  }
+
+  return __builtin_arc_lr(Count);
+}
+
+/**
+  Read 64-bit RTC, enable it first if needed.
+
+  @return Current count.
+**/
+STATIC
+UINT64
+ReadRtc(VOID)
+{
+  UINT32 Low;
+  UINT32 High;
+  UINT32 Ctrl;
+
+  for (;;) {
+    Low = __builtin_arc_lr(ARC_AUX_RTC_LOW);
+    High = __builtin_arc_lr(ARC_AUX_RTC_HIGH);
+    Ctrl = __builtin_arc_lr(ARC_AUX_RTC_CTRL);
+    if ((Ctrl & (1U << RTC_CTRL_E_BIT)) == 0) {
+      __builtin_arc_sr(1U << RTC_CTRL_E_BIT, ARC_AUX_RTC_CTRL);
+    } else if ((Ctrl & (1U << RTC_CTRL_A0_BIT)) != 0) {
+      break; // Interrupt or overflow did not split the pair
+    }
+  }
+
+  return LShiftU64(High, 32) | Low;
+}
+
+/**
+  Retrieves the current value of a 64-bit free running performance counter.
+
+  The counter can either count up by 1 or count down by 1. If the physical
+  performance counter counts by a larger increment, then the counter values
+  must be translated. The properties of the counter can be retrieved from
+  GetPerformanceCounterProperties().
+
+  @return The current value of the free running performance counter.
+
+**/
+UINT64
+EFIAPI
+GetPerformanceCounter(VOID)
+{
+  UINT32 Build;
+
+  Build = __builtin_arc_lr(ARC_BCR_TIMER_BUILD);
+  if ((Build & (1U << TIMER_BUILD_RTC_BIT)) != 0) {
+    return ReadRtc();
+  } else if ((Build & (1U << TIMER_BUILD_T1_BIT)) != 0) {
+    return ReadTimer(ARC_AUX_COUNT1, ARC_AUX_CONTROL1, ARC_AUX_LIMIT1);
+  } else if ((Build & (1U << TIMER_BUILD_T0_BIT)) != 0) {
+    return ReadTimer(ARC_AUX_COUNT0, ARC_AUX_CONTROL0, ARC_AUX_LIMIT0);
+  }
+
+  return 0;
+}
+
+/**
+  Retrieves the 64-bit frequency in Hz and the range of performance counter
+  values.
+
+  If StartValue is not NULL, then the value that the performance counter starts
+  with immediately after is it rolls over is returned in StartValue. If
+  EndValue is not NULL, then the value that the performance counter end with
+  immediately before it rolls over is returned in EndValue. The 64-bit
+  frequency of the performance counter in Hz is always returned. If StartValue
+  is less than EndValue, then the performance counter counts up. If StartValue
+  is greater than EndValue, then the performance counter counts down.
+
+  @param  StartValue  The value the performance counter starts with when it
+                      rolls over.
+  @param  EndValue    The value that the performance counter ends with before
+                      it rolls over.
+
+  @return The frequency in Hz.
+
+**/
+UINT64
+EFIAPI
+GetPerformanceCounterProperties(
+  OUT UINT64  *StartValue OPTIONAL,
+  OUT UINT64  *EndValue OPTIONAL
+  )
+{
+  UINT32 Build;
+
+  if (StartValue != NULL) {
+    *StartValue = 0;
+  }
+
+  if (EndValue != NULL) {
+    Build = __builtin_arc_lr(ARC_BCR_TIMER_BUILD);
+    if ((Build & (1U << TIMER_BUILD_RTC_BIT)) != 0) {
+      *EndValue = MAX_UINT64;
+    } else {
+      *EndValue = MAX_UINT32;
+    }
+  }
+
+  return TIMER_FREQUENCY;
+}
+
+/**
+  Converts elapsed ticks of performance counter to time in nanoseconds.
+
+  This function converts the elapsed ticks of running performance counter to
+  time value in unit of nanoseconds.
+
+  @param  Ticks     The number of elapsed ticks of running performance counter.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+UINT64
+EFIAPI
+GetTimeInNanoSecond(
+  IN UINT64  Ticks
+  )
+{
+  UINT64 Seconds;
+  UINT32 Remainder;
+
+  //
+  // Split to keep Ticks * 10^9 from overflowing: Remainder * 10^9 stays
+  // below 2^62 for any 32-bit frequency.
+  //
+  Seconds = DivU64x32Remainder(Ticks, TIMER_FREQUENCY, &Remainder);
+  return MultU64x32(Seconds, 1000000000) +
+    DivU64x32(MultU64x32(Remainder, 1000000000), TIMER_FREQUENCY);
+}
+
+/**
+  Busy wait until performance counter moves by given number of ticks.
+
+  Elapsed ticks are accumulated from counter deltas rather than loop
+  iterations, so delay does not drift with loop overhead and survives
+  32-bit counter wrap.
+
+  @param  Ticks   Number of ticks to wait for.
+**/
+STATIC
+VOID
+DelayTicks(
+  IN UINT64 Ticks
+  )
+{
+  UINT64 Mask;
+  UINT64 Prev;
+  UINT64 Now;
+  UINT64 Elapsed;
+
+  GetPerformanceCounterProperties(NULL, &Mask);
+  Prev = GetPerformanceCounter();
+  for (Elapsed = 0; Elapsed < Ticks; Prev = Now) {
+    Now = GetPerformanceCounter();
+    Elapsed += (Now - Prev) & Mask;
+  }
+}
+
+/**
+  Convert time to ticks, rounding up so that delays are never shorter than
+  requested.
+
+  @param  Time      Time in units of Divisor.
+  @param  Divisor   Units per second.
+
+  @return Number of ticks.
+**/
+STATIC
+UINT64
+TimeToTicks(
+  IN UINT64 Time,
+  IN UINT32 Divisor
+  )
+{
+  UINT64 Seconds;
+  UINT32 Remainder;
+
+  Seconds = DivU64x32Remainder(Time, Divisor, &Remainder);
+  return MultU64x32(Seconds, TIMER_FREQUENCY) +
+    DivU64x32(MultU64x32(Remainder, TIMER_FREQUENCY) + Divisor - 1, Divisor);
+}
+
+/**
+  Stalls the CPU for at least the given number of microseconds.
+
+  Stalls the CPU for the number of microseconds specified by MicroSeconds.
+
+  @param  MicroSeconds  The minimum number of microseconds to delay.
+
+  @return MicroSeconds
+
+**/
+UINTN
+EFIAPI
+MicroSecondDelay(
+  IN UINTN  MicroSeconds
+  )
+{
+  DelayTicks(TimeToTicks(MicroSeconds, 1000000));
+  return MicroSeconds;
+}
+
+/**
+  Stalls the CPU for at least the given number of nanoseconds.
+
+  Stalls the CPU for the number of nanoseconds specified by NanoSeconds.
+
+  @param  NanoSeconds The minimum number of nanoseconds to delay.
+
+  @return NanoSeconds
+
+**/
+UINTN
+EFIAPI
+NanoSecondDelay(
+  IN UINTN  NanoSeconds
+  )
+{
+  DelayTicks(TimeToTicks(NanoSeconds, 1000000000));
+  return NanoSeconds;
+}
@@ -4,6 +4,10 @@
   See MdeModulePkg/Include/Library/CpuExceptionHandlerLib.h for detailed
   description of each function.
 
+  Vector table and registered handlers are kept in temporary RAM
+  (PcdArcVectorBase/Size), so handlers registered in PEI stay in place until
+  DXE takes the vectors over.
+
   Copyright (c) 2023 Basemark Oy
 
   Author: Aliaksei Katovich @ basemark.com
@@ -11,7 +15,95 @@
   Released under the BSD-2-Clause License
 **/
 
-#include <Ppi/VectorHandoffInfo.h>
+#include <Library/CpuExceptionHandlerLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PcdLib.h>
+#include <Library/UtilsLib.h>
+#include <Common/Cpu.h>
+#include <Common/Exception.h>
+
+#define VECTOR_TABLE_BASE FixedPcdGet32(PcdArcVectorBase)
+#define VECTOR_TABLE_SIZE FixedPcdGet32(PcdArcVectorSize)
+
+typedef struct {
+  UINT32 Entries[ARC_VECTOR_COUNT]; // INT_VECTOR_BASE points here
+  EFI_CPU_INTERRUPT_HANDLER Handlers[ARC_VECTOR_COUNT];
+} ARC_VECTOR_TABLE;
+
+//
+// Entry code of CpuLib/Arc2Vector.S
+//
+VOID
+ArcExceptionEntry(VOID);
+
+VOID
+ArcInterruptEntry(VOID);
+
+STATIC
+ARC_VECTOR_TABLE *
+GetVectorTable(VOID)
+{
+  //
+  // INT_VECTOR_BASE ignores low 10 bits
+  //
+  if (VECTOR_TABLE_SIZE < sizeof(ARC_VECTOR_TABLE) ||
+    (VECTOR_TABLE_BASE & 0x3ff) != 0) {
+    return NULL;
+  }
+
+  return (ARC_VECTOR_TABLE *) VECTOR_TABLE_BASE;
+}
+
+STATIC
+VOID
+EnableIrq(
+  IN UINT32 Irq,
+  IN BOOLEAN Enable
+  )
+{
+  __builtin_arc_sr(Irq, ARC_AUX_IRQ_SELECT);
+  __builtin_arc_sr(ARC_IRQ_PRIORITY, ARC_AUX_IRQ_PRIORITY);
+  __builtin_arc_sr(Enable ? 1 : 0, ARC_AUX_IRQ_ENABLE);
+}
+
+/**
+  Call handler registered for exception or interrupt, called by entry code.
+
+  Unhandled exceptions stop the CPU, unhandled interrupts are disabled.
+
+  @param Vector   Exception or interrupt number.
+  @param Frame    Registers saved by entry code.
+
+**/
+VOID
+ArcDispatchVector(
+  IN UINT32 Vector,
+  IN OUT ARC_INTERRUPT_FRAME *Frame
+  )
+{
+  ARC_VECTOR_TABLE *Table;
+  EFI_SYSTEM_CONTEXT SystemContext;
+
+  Table = GetVectorTable();
+  if (Vector < ARC_VECTOR_COUNT && Table->Handlers[Vector] != NULL) {
+    ARC_FRAME_TO_CONTEXT(SystemContext, Frame);
+    Table->Handlers[Vector](Vector, SystemContext);
+    return;
+  }
+
+  if (Vector >= ARC_EXCEPTION_COUNT) {
+    LOG("Unhandled interrupt %u at %p, disabled\n", Vector, Frame->Pc);
+    EnableIrq(Vector, FALSE);
+    return;
+  }
+
+  LOG("Unhandled exception, ECR 0x%x EFA %p PC %p BLINK %p\n",
+    __builtin_arc_lr(ARC_AUX_ECR), __builtin_arc_lr(ARC_AUX_EFA), Frame->Pc,
+    Frame->Blink);
+  LOG_DUMP();
+  CpuDeadLoop();
+}
 
 EFI_STATUS
 EFIAPI
@@ -19,7 +111,64 @@ InitializeCpuExceptionHandlers(
   IN EFI_VECTOR_HANDOFF_INFO  *VectorInfo OPTIONAL
   )
 {
-  return EFI_UNSUPPORTED;
+  ARC_VECTOR_TABLE *Table;
+  UINT32 Vector;
+
+  Table = GetVectorTable();
+  if (Table == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Vector 0 is reset, taken from the table only by software
+  //
+  Table->Entries[0] = 0;
+  for (Vector = 1; Vector < ARC_EXCEPTION_COUNT; Vector++) {
+    Table->Entries[Vector] = (UINT32) (UINTN) ArcExceptionEntry;
+  }
+
+  for (; Vector < ARC_VECTOR_COUNT; Vector++) {
+    Table->Entries[Vector] = (UINT32) (UINTN) ArcInterruptEntry;
+  }
+
+  ZeroMem(Table->Handlers, sizeof(Table->Handlers));
+
+  //
+  // Hardware pushes only PC and STATUS32 on interrupt, see Arc2Vector.S
+  //
+  __builtin_arc_sr(0, ARC_AUX_IRQ_CTRL);
+  __builtin_arc_sr((UINT32) (UINTN) Table, ARC_AUX_INT_VECTOR_BASE);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+RegisterCpuInterruptHandler(
+  IN EFI_EXCEPTION_TYPE         InterruptType,
+  IN EFI_CPU_INTERRUPT_HANDLER  InterruptHandler
+  )
+{
+  ARC_VECTOR_TABLE *Table;
+
+  Table = GetVectorTable();
+  if (Table == NULL) {
+    return EFI_UNSUPPORTED;
+  } else if (InterruptType < 0 || InterruptType >= ARC_VECTOR_COUNT) {
+    return EFI_UNSUPPORTED;
+  } else if (InterruptHandler != NULL &&
+    Table->Handlers[InterruptType] != NULL) {
+    return EFI_ALREADY_STARTED;
+  } else if (InterruptHandler == NULL &&
+    Table->Handlers[InterruptType] == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Table->Handlers[InterruptType] = InterruptHandler;
+  if (InterruptType >= ARC_EXCEPTION_COUNT) {
+    EnableIrq(InterruptType, InterruptHandler != NULL);
+  }
+
+  return EFI_SUCCESS;
 }
 
 EFI_STATUS
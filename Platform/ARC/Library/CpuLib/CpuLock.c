@@ -0,0 +1,227 @@
+/** @file
+  Ticket and MCS queued spin locks, see Include/Library/ArcSyncLib.h.
+
+  Atomics give full barriers, so acquisition needs one more barrier only
+  after spinning on a plain load, and release one before the store that
+  hands the lock over.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include "CpuSyncInternals.h"
+
+UINT32
+EFIAPI
+InterlockedFetchAdd32(
+  IN OUT volatile UINT32 *Value,
+  IN UINT32 Addend
+  )
+{
+  ASSERT(Value != NULL);
+  return InternalSyncFetchAdd32(Value, Addend);
+}
+
+UINT32
+EFIAPI
+InterlockedFetchAnd32(
+  IN OUT volatile UINT32 *Value,
+  IN UINT32 AndData
+  )
+{
+  ASSERT(Value != NULL);
+  return InternalSyncFetchAnd32(Value, AndData);
+}
+
+UINT32
+EFIAPI
+InterlockedFetchOr32(
+  IN OUT volatile UINT32 *Value,
+  IN UINT32 OrData
+  )
+{
+  ASSERT(Value != NULL);
+  return InternalSyncFetchOr32(Value, OrData);
+}
+
+UINT32
+EFIAPI
+InterlockedExchange32(
+  IN OUT volatile UINT32 *Value,
+  IN UINT32 ExchangeValue
+  )
+{
+  ASSERT(Value != NULL);
+  return InternalSyncExchange32(Value, ExchangeValue);
+}
+
+VOID *
+EFIAPI
+InterlockedExchangePointer(
+  IN OUT VOID *volatile *Value,
+  IN VOID *ExchangeValue
+  )
+{
+  ASSERT(Value != NULL);
+  return InternalSyncExchangePointer(Value, ExchangeValue);
+}
+
+VOID
+EFIAPI
+SyncMemoryBarrier(VOID)
+{
+  InternalSyncMemoryBarrier();
+}
+
+TICKET_LOCK *
+EFIAPI
+InitializeTicketLock(
+  OUT TICKET_LOCK *Lock
+  )
+{
+  ASSERT(Lock != NULL);
+  Lock->Next = 0;
+  Lock->Owner = 0;
+  InternalSyncMemoryBarrier();
+  return Lock;
+}
+
+TICKET_LOCK *
+EFIAPI
+AcquireTicketLock(
+  IN OUT TICKET_LOCK *Lock
+  )
+{
+  UINT32 Ticket;
+
+  ASSERT(Lock != NULL);
+  Ticket = InternalSyncFetchAdd32(&Lock->Next, 1);
+  while (Lock->Owner != Ticket) {
+    CpuPause();
+  }
+
+  InternalSyncMemoryBarrier();
+  return Lock;
+}
+
+BOOLEAN
+EFIAPI
+AcquireTicketLockOrFail(
+  IN OUT TICKET_LOCK *Lock
+  )
+{
+  UINT32 Owner;
+
+  ASSERT(Lock != NULL);
+  Owner = Lock->Owner;
+  return InternalSyncCompareExchange32(&Lock->Next, Owner, Owner + 1) ==
+    Owner;
+}
+
+TICKET_LOCK *
+EFIAPI
+ReleaseTicketLock(
+  IN OUT TICKET_LOCK *Lock
+  )
+{
+  ASSERT(Lock != NULL);
+  ASSERT(Lock->Owner != Lock->Next);
+
+  //
+  // Only the holder writes Owner, no atomic needed
+  //
+  InternalSyncMemoryBarrier();
+  Lock->Owner = Lock->Owner + 1;
+  return Lock;
+}
+
+MCS_LOCK *
+EFIAPI
+InitializeMcsLock(
+  OUT MCS_LOCK *Lock
+  )
+{
+  ASSERT(Lock != NULL);
+  Lock->Tail = NULL;
+  InternalSyncMemoryBarrier();
+  return Lock;
+}
+
+MCS_LOCK *
+EFIAPI
+AcquireMcsLock(
+  IN OUT MCS_LOCK *Lock,
+  OUT MCS_LOCK_NODE *Node
+  )
+{
+  MCS_LOCK_NODE *Prev;
+
+  ASSERT(Lock != NULL && Node != NULL);
+  Node->Next = NULL;
+  Node->Locked = 1;
+
+  Prev = InternalSyncExchangePointer((VOID *volatile *) &Lock->Tail, Node);
+  if (Prev == NULL) {
+    return Lock;
+  }
+
+  //
+  // Exchange above orders Node initialization before this store, so the
+  // previous holder finds Locked set once it sees the node
+  //
+  Prev->Next = Node;
+  while (Node->Locked != 0) {
+    CpuPause();
+  }
+
+  InternalSyncMemoryBarrier();
+  return Lock;
+}
+
+BOOLEAN
+EFIAPI
+AcquireMcsLockOrFail(
+  IN OUT MCS_LOCK *Lock,
+  OUT MCS_LOCK_NODE *Node
+  )
+{
+  ASSERT(Lock != NULL && Node != NULL);
+  Node->Next = NULL;
+  Node->Locked = 1;
+
+  return InterlockedCompareExchangePointer((VOID *volatile *) &Lock->Tail,
+    NULL, Node) == NULL;
+}
+
+MCS_LOCK *
+EFIAPI
+ReleaseMcsLock(
+  IN OUT MCS_LOCK *Lock,
+  IN OUT MCS_LOCK_NODE *Node
+  )
+{
+  MCS_LOCK_NODE *Next;
+
+  ASSERT(Lock != NULL && Node != NULL);
+  Next = Node->Next;
+  if (Next == NULL) {
+    if (InterlockedCompareExchangePointer((VOID *volatile *) &Lock->Tail, Node,
+      NULL) == Node) {
+      return Lock;
+    }
+
+    //
+    // Somebody swapped Tail but has not linked its node yet
+    //
+    while ((Next = Node->Next) == NULL) {
+      CpuPause();
+    }
+  }
+
+  InternalSyncMemoryBarrier();
+  Next->Locked = 0;
+  return Lock;
+}
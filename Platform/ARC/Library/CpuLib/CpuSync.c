@@ -6,7 +6,8 @@
 
 **/
 
-#include "BaseSynchronizationLibInternals.h"
+#include "CpuSyncInternals.h"
+#include <Library/ArcCpuInfoLib.h>
 
 #define SPIN_LOCK_RELEASED  ((UINTN) 1)
 #define SPIN_LOCK_ACQUIRED  ((UINTN) 2)
@@ -24,6 +25,9 @@
   consumers of the spin lock synchronization functions to obtain optimal spin
   lock performance.
 
+  Locks sharing a data cache line would be written back and forth between
+  cores, so the alignment is the line size of the data cache actually there.
+
   @return The architecture specific spin lock alignment.
 
 **/
@@ -33,7 +37,13 @@ GetSpinLockProperties (
   VOID
   )
 {
-  return 32;
+  ARC_CACHE_INFO  Info;
+
+  if (!GetArcDCacheInfo (&Info)) {
+    return sizeof (SPIN_LOCK);
+  }
+
+  return Info.LineSize;
 }
 
 /**
@@ -99,8 +109,14 @@ AcquireSpinLock (
   INT64   Delta;
 
   if (PcdGet32 (PcdSpinLockTimeout) == 0) {
+    //
+    // Wait on plain loads, which keep the line shared, and try to take the
+    // lock only once it is seen released
+    //
     while (!AcquireSpinLockOrFail (SpinLock)) {
-      CpuPause ();
+      while (*SpinLock == SPIN_LOCK_ACQUIRED) {
+        CpuPause ();
+      }
     }
   } else if (!AcquireSpinLockOrFail (SpinLock)) {
     //
@@ -220,6 +236,10 @@ ReleaseSpinLock (
   LockValue = *SpinLock;
   ASSERT (SPIN_LOCK_ACQUIRED == LockValue || SPIN_LOCK_RELEASED == LockValue);
 
+  //
+  // Accesses made under the lock must be seen before the lock is seen free
+  //
+  InternalSyncMemoryBarrier ();
   *SpinLock = SPIN_LOCK_RELEASED;
   return SpinLock;
 }
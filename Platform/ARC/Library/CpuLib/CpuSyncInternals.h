@@ -0,0 +1,132 @@
+/** @file
+  Atomic primitives SynchronizationLib is built on.
+
+  Implemented with LLOCK/SCOND for ARCv2 by Arc2Sync.c, and with compiler
+  atomics for the host by scripts/host-bench/Shim/HostSync.c, so that the
+  lock code above them can be benchmarked with host threads. All of them
+  are full barriers, memory accesses before them complete before the atomic
+  access and accesses after them start after it.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef CPU_SYNC_INTERNALS_H_
+#define CPU_SYNC_INTERNALS_H_
+
+#include <Base.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/ArcSyncLib.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+
+UINT32
+EFIAPI
+InternalSyncIncrement(
+  IN volatile UINT32 *Value
+  );
+
+UINT32
+EFIAPI
+InternalSyncDecrement(
+  IN volatile UINT32 *Value
+  );
+
+UINT16
+EFIAPI
+InternalSyncCompareExchange16(
+  IN volatile UINT16 *Value,
+  IN UINT16 CompareValue,
+  IN UINT16 ExchangeValue
+  );
+
+UINT32
+EFIAPI
+InternalSyncCompareExchange32(
+  IN volatile UINT32 *Value,
+  IN UINT32 CompareValue,
+  IN UINT32 ExchangeValue
+  );
+
+UINT64
+EFIAPI
+InternalSyncCompareExchange64(
+  IN volatile UINT64 *Value,
+  IN UINT64 CompareValue,
+  IN UINT64 ExchangeValue
+  );
+
+/**
+  Atomically add Addend to Value.
+
+  @return Value before addition.
+
+**/
+UINT32
+EFIAPI
+InternalSyncFetchAdd32(
+  IN volatile UINT32 *Value,
+  IN UINT32 Addend
+  );
+
+/**
+  Atomically and Value with AndData.
+
+  @return Value before the operation.
+
+**/
+UINT32
+EFIAPI
+InternalSyncFetchAnd32(
+  IN volatile UINT32 *Value,
+  IN UINT32 AndData
+  );
+
+/**
+  Atomically or Value with OrData.
+
+  @return Value before the operation.
+
+**/
+UINT32
+EFIAPI
+InternalSyncFetchOr32(
+  IN volatile UINT32 *Value,
+  IN UINT32 OrData
+  );
+
+/**
+  Atomically replace Value with ExchangeValue.
+
+  @return Value before exchange.
+
+**/
+UINT32
+EFIAPI
+InternalSyncExchange32(
+  IN volatile UINT32 *Value,
+  IN UINT32 ExchangeValue
+  );
+
+VOID *
+EFIAPI
+InternalSyncExchangePointer(
+  IN VOID *volatile *Value,
+  IN VOID *ExchangeValue
+  );
+
+/**
+  Order memory accesses before the barrier against accesses after it, as
+  seen by other cores.
+
+**/
+VOID
+EFIAPI
+InternalSyncMemoryBarrier(VOID);
+
+#endif // CPU_SYNC_INTERNALS_H_
@@ -0,0 +1,278 @@
+/** @file
+  Lock free rings and sequence lock, see Include/Library/LockFreeLib.h.
+
+  Atomics of SynchronizationLib are full barriers, plain loads and stores
+  that publish or consume data are ordered with SyncMemoryBarrier(). Ring
+  positions are free running 32-bit counters, masked to get the slot, and
+  compared by difference so that they may wrap.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <Base.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/LockFreeLib.h>
+
+#define IS_POW2(Count) ((Count) != 0 && ((Count) & ((Count) - 1)) == 0)
+
+EFI_STATUS
+EFIAPI
+InitializeSpscRing(
+  OUT SPSC_RING *Ring,
+  IN UINTN *Entries,
+  IN UINT32 Count
+  )
+{
+  ASSERT(Ring != NULL && Entries != NULL);
+  if (!IS_POW2(Count)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Ring->Head = 0;
+  Ring->TailCache = 0;
+  Ring->Tail = 0;
+  Ring->HeadCache = 0;
+  Ring->Mask = Count - 1;
+  Ring->Entries = Entries;
+  SyncMemoryBarrier();
+  return EFI_SUCCESS;
+}
+
+BOOLEAN
+EFIAPI
+SpscRingPush(
+  IN OUT SPSC_RING *Ring,
+  IN UINTN Value
+  )
+{
+  UINT32 Tail;
+
+  Tail = Ring->Tail;
+  if (Tail - Ring->HeadCache > Ring->Mask) {
+    Ring->HeadCache = Ring->Head;
+    if (Tail - Ring->HeadCache > Ring->Mask) {
+      return FALSE;
+    }
+
+    //
+    // Consumer read the entry before moving Head, see SpscRingPop()
+    //
+    SyncMemoryBarrier();
+  }
+
+  Ring->Entries[Tail & Ring->Mask] = Value;
+  SyncMemoryBarrier(); // Entry before Tail
+  Ring->Tail = Tail + 1;
+  return TRUE;
+}
+
+BOOLEAN
+EFIAPI
+SpscRingPop(
+  IN OUT SPSC_RING *Ring,
+  OUT UINTN *Value
+  )
+{
+  UINT32 Head;
+
+  Head = Ring->Head;
+  if (Head == Ring->TailCache) {
+    Ring->TailCache = Ring->Tail;
+    if (Head == Ring->TailCache) {
+      return FALSE;
+    }
+
+    SyncMemoryBarrier(); // Tail before entry
+  }
+
+  *Value = Ring->Entries[Head & Ring->Mask];
+  SyncMemoryBarrier(); // Entry read before it can be reused
+  Ring->Head = Head + 1;
+  return TRUE;
+}
+
+EFI_STATUS
+EFIAPI
+InitializeMpmcRing(
+  OUT MPMC_RING *Ring,
+  IN MPMC_RING_CELL *Cells,
+  IN UINT32 Count
+  )
+{
+  UINT32 Idx;
+
+  ASSERT(Ring != NULL && Cells != NULL);
+  if (!IS_POW2(Count)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Idx = 0; Idx < Count; Idx++) {
+    Cells[Idx].Sequence = Idx;
+  }
+
+  Ring->Tail = 0;
+  Ring->Head = 0;
+  Ring->Mask = Count - 1;
+  Ring->Cells = Cells;
+  SyncMemoryBarrier();
+  return EFI_SUCCESS;
+}
+
+//
+// Cell at Pos is free for push when its sequence is Pos, and holds a value
+// for pop when it is Pos + 1. Pop makes it free for the push one lap later,
+// Pos + Count.
+//
+BOOLEAN
+EFIAPI
+MpmcRingPush(
+  IN OUT MPMC_RING *Ring,
+  IN UINTN Value
+  )
+{
+  MPMC_RING_CELL *Cell;
+  UINT32 Pos;
+  UINT32 Seen;
+  INT32 Diff;
+
+  Pos = Ring->Tail;
+  for (;;) {
+    Cell = &Ring->Cells[Pos & Ring->Mask];
+    Diff = (INT32) (Cell->Sequence - Pos);
+    if (Diff == 0) {
+      Seen = InterlockedCompareExchange32(&Ring->Tail, Pos, Pos + 1);
+      if (Seen == Pos) {
+        break;
+      }
+
+      Pos = Seen;
+    } else if (Diff < 0) {
+      return FALSE; // Cell of the previous lap is not popped yet
+    } else {
+      Pos = Ring->Tail;
+    }
+  }
+
+  Cell->Value = Value;
+  SyncMemoryBarrier(); // Value before sequence
+  Cell->Sequence = Pos + 1;
+  return TRUE;
+}
+
+BOOLEAN
+EFIAPI
+MpmcRingPop(
+  IN OUT MPMC_RING *Ring,
+  OUT UINTN *Value
+  )
+{
+  MPMC_RING_CELL *Cell;
+  UINT32 Pos;
+  UINT32 Seen;
+  INT32 Diff;
+
+  Pos = Ring->Head;
+  for (;;) {
+    Cell = &Ring->Cells[Pos & Ring->Mask];
+    Diff = (INT32) (Cell->Sequence - (Pos + 1));
+    if (Diff == 0) {
+      Seen = InterlockedCompareExchange32(&Ring->Head, Pos, Pos + 1);
+      if (Seen == Pos) {
+        break;
+      }
+
+      Pos = Seen;
+    } else if (Diff < 0) {
+      return FALSE; // Cell is not pushed yet
+    } else {
+      Pos = Ring->Head;
+    }
+  }
+
+  //
+  // Compare exchange above orders sequence load before value load
+  //
+  *Value = Cell->Value;
+  SyncMemoryBarrier(); // Value read before cell is handed to next lap
+  Cell->Sequence = Pos + Ring->Mask + 1;
+  return TRUE;
+}
+
+VOID
+EFIAPI
+InitializeSeqLock(
+  OUT SEQ_LOCK *Lock
+  )
+{
+  ASSERT(Lock != NULL);
+  Lock->Sequence = 0;
+  SyncMemoryBarrier();
+}
+
+UINT32
+EFIAPI
+SeqLockReadBegin(
+  IN SEQ_LOCK *Lock
+  )
+{
+  UINT32 Sequence;
+
+  while (((Sequence = Lock->Sequence) & 1) != 0) {
+    CpuPause();
+  }
+
+  SyncMemoryBarrier(); // Sequence before data
+  return Sequence;
+}
+
+BOOLEAN
+EFIAPI
+SeqLockReadRetry(
+  IN SEQ_LOCK *Lock,
+  IN UINT32 Sequence
+  )
+{
+  SyncMemoryBarrier(); // Data before sequence
+  return Lock->Sequence != Sequence;
+}
+
+VOID
+EFIAPI
+SeqLockWriteBegin(
+  IN OUT SEQ_LOCK *Lock
+  )
+{
+  UINT32 Sequence;
+
+  //
+  // Making sequence odd locks out other writers too, compare exchange is
+  // a barrier, so data stores do not pass it
+  //
+  for (;;) {
+    Sequence = Lock->Sequence;
+    if ((Sequence & 1) == 0 &&
+      InterlockedCompareExchange32(&Lock->Sequence, Sequence, Sequence + 1) ==
+      Sequence) {
+      break;
+    }
+
+    CpuPause();
+  }
+}
+
+VOID
+EFIAPI
+SeqLockWriteEnd(
+  IN OUT SEQ_LOCK *Lock
+  )
+{
+  ASSERT((Lock->Sequence & 1) != 0);
+  SyncMemoryBarrier(); // Data before sequence
+  Lock->Sequence = Lock->Sequence + 1;
+}
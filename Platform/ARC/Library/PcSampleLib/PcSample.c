@@ -0,0 +1,174 @@
+/** @file
+  Statistical profiler sampling interrupted PC on TIMER0 interrupt.
+
+  TIMER0 interrupts at PcdPcSampleRate and its handler counts interrupted
+  PC and BLINK in a histogram in temporary RAM, see PC_SAMPLE_BUFFER in
+  PcSampleLib.h. Only starting the sampler needs CpuExceptionHandlerLib,
+  stopping and dumping it work from any module.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <Library/PcSampleLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/CpuExceptionHandlerLib.h>
+#include <Library/PcdLib.h>
+#include <Library/UtilsLib.h>
+#include <Common/Cpu.h>
+#include <Common/Exception.h>
+
+#define PC_SAMPLE_RATE FixedPcdGet32(PcdPcSampleRate)
+#define PC_SAMPLE_BUFFER_BASE FixedPcdGet32(PcdPcSampleBufferBase)
+#define PC_SAMPLE_BUFFER_SIZE FixedPcdGet32(PcdPcSampleBufferSize)
+
+// Entries tried before sample is dropped
+#define PC_SAMPLE_PROBES 8
+
+#define TIMER0_CTRL ((1U << TIMER_CTRL_IE_BIT) | (1U << TIMER_CTRL_NH_BIT))
+
+STATIC
+PC_SAMPLE_BUFFER *
+GetSampleBuffer(VOID)
+{
+  PC_SAMPLE_BUFFER *Buffer;
+
+  if (PC_SAMPLE_BUFFER_SIZE < sizeof(PC_SAMPLE_BUFFER) + sizeof(PC_SAMPLE)) {
+    return NULL;
+  }
+
+  Buffer = (PC_SAMPLE_BUFFER *) PC_SAMPLE_BUFFER_BASE;
+  if (Buffer->Signature != PC_SAMPLE_SIGNATURE || Buffer->Capacity == 0 ||
+    Buffer->Capacity > (PC_SAMPLE_BUFFER_SIZE - sizeof(*Buffer)) /
+    sizeof(PC_SAMPLE)) {
+    return NULL;
+  }
+
+  return Buffer;
+}
+
+STATIC
+VOID
+EFIAPI
+SampleHandler(
+  IN CONST EFI_EXCEPTION_TYPE InterruptType,
+  IN CONST EFI_SYSTEM_CONTEXT SystemContext
+  )
+{
+  CONST ARC_INTERRUPT_FRAME *Frame;
+  PC_SAMPLE_BUFFER *Buffer;
+  PC_SAMPLE *Entry;
+  UINT32 Mask;
+  UINT32 Idx;
+  UINT8 Probe;
+
+  //
+  // Writing CONTROL0 clears interrupt pending bit and re-arms the timer
+  //
+  __builtin_arc_sr(TIMER0_CTRL, ARC_AUX_CONTROL0);
+
+  Buffer = (PC_SAMPLE_BUFFER *) PC_SAMPLE_BUFFER_BASE;
+  Frame = ARC_CONTEXT_TO_FRAME(SystemContext);
+  Buffer->Samples++;
+
+  Mask = Buffer->Capacity - 1;
+  Idx = (((Frame->Pc ^ (Frame->Blink * 0x85ebca6b)) * 0x9e3779b1) >> 16) & Mask;
+  for (Probe = 0; Probe < PC_SAMPLE_PROBES; Probe++, Idx = (Idx + 1) & Mask) {
+    Entry = (PC_SAMPLE *) (Buffer + 1) + Idx;
+    if (Entry->Count == 0) {
+      Entry->Pc = Frame->Pc;
+      Entry->Blink = Frame->Blink;
+      Entry->Count = 1;
+      return;
+    } else if (Entry->Pc == Frame->Pc && Entry->Blink == Frame->Blink) {
+      Entry->Count++;
+      return;
+    }
+  }
+
+  Buffer->Dropped++;
+}
+
+EFI_STATUS
+PcSampleStart(VOID)
+{
+  PC_SAMPLE_BUFFER *Buffer;
+  EFI_STATUS Status;
+  UINT32 Capacity;
+  UINT32 Build;
+
+  if (PC_SAMPLE_RATE == 0 ||
+    PC_SAMPLE_BUFFER_SIZE < sizeof(PC_SAMPLE_BUFFER) + sizeof(PC_SAMPLE)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // TimerLib counts on TIMER0 when there is neither RTC nor TIMER1
+  //
+  Build = __builtin_arc_lr(ARC_BCR_TIMER_BUILD);
+  if ((Build & (1U << TIMER_BUILD_T0_BIT)) == 0 ||
+    (Build & ((1U << TIMER_BUILD_RTC_BIT) | (1U << TIMER_BUILD_T1_BIT))) == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Buffer = (PC_SAMPLE_BUFFER *) PC_SAMPLE_BUFFER_BASE;
+  Capacity = GetPowerOfTwo32((PC_SAMPLE_BUFFER_SIZE - sizeof(*Buffer)) /
+    sizeof(PC_SAMPLE));
+
+  Buffer->Signature = PC_SAMPLE_SIGNATURE;
+  Buffer->Capacity = Capacity;
+  Buffer->Samples = 0;
+  Buffer->Dropped = 0;
+  Buffer->Rate = PC_SAMPLE_RATE;
+  Buffer->Reserved = 0;
+  ZeroMem(Buffer + 1, Capacity * sizeof(PC_SAMPLE));
+
+  Status = RegisterCpuInterruptHandler(ARC_IRQ_TIMER0, SampleHandler);
+  if (Status != EFI_SUCCESS) {
+    return Status;
+  }
+
+  __builtin_arc_sr(0, ARC_AUX_CONTROL0);
+  __builtin_arc_sr(MAX(FixedPcdGet32(PcdArcTimerFrequency) / PC_SAMPLE_RATE, 1),
+    ARC_AUX_LIMIT0);
+  __builtin_arc_sr(0, ARC_AUX_COUNT0);
+  __builtin_arc_sr(TIMER0_CTRL, ARC_AUX_CONTROL0);
+
+  __builtin_arc_seti((1U << SETI_USE_OPERAND_BIT) | (1U << SETI_IE_BIT) |
+    ARC_IRQ_PRIORITY);
+  return EFI_SUCCESS;
+}
+
+VOID
+PcSampleStop(VOID)
+{
+  if (PC_SAMPLE_RATE != 0) {
+    __builtin_arc_sr(0, ARC_AUX_CONTROL0);
+  }
+}
+
+VOID
+PcSampleDump(VOID)
+{
+  CONST PC_SAMPLE_BUFFER *Buffer;
+  CONST PC_SAMPLE *Entry;
+  UINT32 Idx;
+
+  Buffer = GetSampleBuffer();
+  if (Buffer == NULL) {
+    return;
+  }
+
+  DumpWords("@pcs", (CONST UINT32 *) Buffer, sizeof(*Buffer) / sizeof(UINT32));
+
+  Entry = (CONST PC_SAMPLE *) (Buffer + 1);
+  for (Idx = 0; Idx < Buffer->Capacity; Idx++, Entry++) {
+    if (Entry->Count != 0) {
+      DumpWords("@pcs", (CONST UINT32 *) Entry, sizeof(*Entry) / sizeof(UINT32));
+    }
+  }
+}
@@ -0,0 +1,339 @@
+/** @file
+  PEIM dependency expression evaluation and dispatching.
+
+  PEIMs are registered in dispatch order computed by scripts/boot-manifest.py,
+  and evaluated in that order. A PEIM whose dependency expression is not met
+  is not looked at again until one of the PPIs it pushes gets installed.
+
+  UEFI PI 1.8: I-14. Dependency Expression Grammar.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include "PeiCoreMain.h"
+#include <Pi/PiDependency.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+
+// Evaluation stack is kept in bits of a single word
+#define DEPEX_STACK_DEPTH 32
+
+STATIC
+VOID
+MarkReady(
+  IN OUT PEIM_DISPATCHER *Disp,
+  IN UINT16 Idx
+  )
+{
+  Disp->Ready[Idx >> 5] |= 1U << (Idx & 31);
+}
+
+STATIC
+UINT16
+TakeReady(
+  IN OUT PEIM_DISPATCHER *Disp
+  )
+{
+  UINT16 Word;
+  UINT16 Idx;
+
+  //
+  // Lowest index first, so PEIMs woken up by the last installation keep
+  // their place in dispatch order.
+  //
+  for (Word = 0; Word < (Disp->PeimCount + 31) >> 5; Word++) {
+    if (Disp->Ready[Word] != 0) {
+      Idx = LowBitSet32(Disp->Ready[Word]);
+      Disp->Ready[Word] &= ~(1U << Idx);
+      return (Word << 5) + Idx;
+    }
+  }
+
+  return PEIM_NIL;
+}
+
+STATIC
+BOOLEAN
+IsPpiInstalled(
+  IN PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN CONST EFI_GUID *Guid
+  )
+{
+  EFI_GUID AlignedGuid;
+  VOID *Ppi;
+
+  CopyGuid(&AlignedGuid, Guid); // Operands are not aligned within DEPEX
+  return PeiLocatePpi((CONST EFI_PEI_SERVICES **) &PeiCoreCtx->PsPtr,
+    &AlignedGuid, 0, NULL, &Ppi) == EFI_SUCCESS;
+}
+
+/**
+  Evaluate PEI dependency expression.
+
+  @param PeiCoreCtx   PEI core context.
+  @param Depex        Dependency expression.
+  @param DepexSize    Dependency expression size in bytes.
+  @param Result       Expression value.
+
+  @return EFI_SUCCESS           Expression evaluated.
+  @return EFI_INVALID_PARAMETER Malformed expression.
+
+**/
+STATIC
+EFI_STATUS
+EvalDepex(
+  IN PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN CONST UINT8 *Depex,
+  IN UINT16 DepexSize,
+  OUT BOOLEAN *Result
+  )
+{
+  CONST UINT8 *Ptr;
+  CONST UINT8 *End;
+  UINT32 Stack;
+  UINT8 Top;
+  UINT8 Val;
+
+  Stack = 0;
+  Top = 0;
+  End = Depex + DepexSize;
+
+  for (Ptr = Depex; Ptr < End; Ptr++) {
+    switch (*Ptr) {
+    case EFI_DEP_PUSH:
+      if (Ptr + sizeof(EFI_GUID) >= End || Top == DEPEX_STACK_DEPTH) {
+        return EFI_INVALID_PARAMETER;
+      }
+      Val = IsPpiInstalled(PeiCoreCtx, (CONST EFI_GUID *) (Ptr + 1));
+      Stack = (Stack << 1) | Val;
+      Top++;
+      Ptr += sizeof(EFI_GUID);
+      break;
+    case EFI_DEP_AND:
+    case EFI_DEP_OR:
+      if (Top < 2) {
+        return EFI_INVALID_PARAMETER;
+      }
+      if (*Ptr == EFI_DEP_AND) {
+        Val = (Stack & (Stack >> 1)) & 1;
+      } else {
+        Val = (Stack | (Stack >> 1)) & 1;
+      }
+      Stack = (Stack >> 2 << 1) | Val;
+      Top--;
+      break;
+    case EFI_DEP_NOT:
+      if (Top < 1) {
+        return EFI_INVALID_PARAMETER;
+      }
+      Stack ^= 1;
+      break;
+    case EFI_DEP_TRUE:
+    case EFI_DEP_FALSE:
+      if (Top == DEPEX_STACK_DEPTH) {
+        return EFI_INVALID_PARAMETER;
+      }
+      Stack = (Stack << 1) | (*Ptr == EFI_DEP_TRUE);
+      Top++;
+      break;
+    case EFI_DEP_END:
+      if (Top != 1) {
+        return EFI_INVALID_PARAMETER;
+      }
+      *Result = Stack & 1;
+      return EFI_SUCCESS;
+    default: // BEFORE, AFTER and SOR are not allowed in PEI
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  return EFI_INVALID_PARAMETER;
+}
+
+/**
+  Register PEIM for dispatching.
+
+  PEIMs must be added in dispatch order. Every GUID pushed by dependency
+  expression is linked to the PEIM, so WakePeims() can find it later.
+
+  @param PeiCoreCtx   PEI core context.
+  @param Entry        PEIM entry point.
+  @param FileName     PEIM file name.
+  @param Depex        Dependency expression, NULL if PEIM has none.
+  @param DepexSize    Dependency expression size in bytes.
+
+  @return EFI_SUCCESS           PEIM added.
+  @return EFI_OUT_OF_RESOURCES  No room left for PEIM.
+
+**/
+EFI_STATUS
+AddPeim(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN EFI_PEIM_ENTRY_POINT2 Entry,
+  IN CONST EFI_GUID *FileName,
+  IN CONST UINT8 *Depex OPTIONAL,
+  IN UINT16 DepexSize
+  )
+{
+  PEIM_DISPATCHER *Disp;
+  PEIM_INFO *Peim;
+  PEIM_WAITER *Waiter;
+  EFI_GUID Guid;
+  CONST UINT8 *Ptr;
+  CONST UINT8 *End;
+  UINT16 *Bucket;
+  UINT16 Idx;
+
+  Disp = &PeiCoreCtx->Dispatcher;
+  if (Disp->PeimCount >= Disp->PeimCapacity) {
+    LOG("No room for PEIM %g\n", FileName);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Idx = Disp->PeimCount++;
+  Peim = &Disp->Peims[Idx];
+  Peim->Entry = Entry;
+  Peim->FileName = FileName;
+  Peim->Depex = Depex;
+  Peim->DepexSize = DepexSize;
+  Peim->State = PEIM_STATE_PENDING;
+  Peim->Flags = 0;
+
+  Ptr = Depex;
+  End = Depex + DepexSize;
+  while (Ptr != NULL && Ptr < End && *Ptr != EFI_DEP_END) {
+    if (*Ptr != EFI_DEP_PUSH) {
+      Ptr++;
+      continue;
+    }
+
+    if (Disp->WaiterCount >= Disp->WaiterCapacity) {
+      DBG("| PEIM %g is out of waiters\n", FileName);
+      Peim->Flags |= PEIM_WAKE_ON_ANY;
+      Disp->WakeOnAnyCount++;
+      break;
+    }
+
+    CopyGuid(&Guid, (CONST EFI_GUID *) (Ptr + 1));
+    Bucket = &Disp->Buckets[HashGuid(&Guid) & Disp->BucketMask];
+    Waiter = &Disp->Waiters[Disp->WaiterCount];
+    Waiter->Guid = (CONST EFI_GUID *) (Ptr + 1);
+    Waiter->Peim = Idx;
+    Waiter->Next = *Bucket;
+    *Bucket = Disp->WaiterCount++;
+    Ptr += 1 + sizeof(EFI_GUID);
+  }
+
+  MarkReady(Disp, Idx);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mark pending PEIMs depending on given PPI for re-evaluation.
+
+  @param PeiCoreCtx   PEI core context.
+  @param Guid         GUID of installed PPI.
+
+**/
+VOID
+WakePeims(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN CONST EFI_GUID *Guid
+  )
+{
+  PEIM_DISPATCHER *Disp;
+  PEIM_WAITER *Waiter;
+  UINT16 Idx;
+
+  Disp = &PeiCoreCtx->Dispatcher;
+  Idx = Disp->Buckets[HashGuid(Guid) & Disp->BucketMask];
+
+  while (Idx != PEIM_NIL) {
+    Waiter = &Disp->Waiters[Idx];
+    if (Disp->Peims[Waiter->Peim].State == PEIM_STATE_PENDING &&
+      CompareGuid(Waiter->Guid, Guid)) {
+      MarkReady(Disp, Waiter->Peim);
+    }
+
+    Idx = Waiter->Next;
+  }
+
+  if (Disp->WakeOnAnyCount == 0) {
+    return;
+  }
+
+  for (Idx = 0; Idx < Disp->PeimCount; Idx++) {
+    if ((Disp->Peims[Idx].Flags & PEIM_WAKE_ON_ANY) != 0 &&
+      Disp->Peims[Idx].State == PEIM_STATE_PENDING) {
+      MarkReady(Disp, Idx);
+    }
+  }
+}
+
+/**
+  Dispatch registered PEIMs.
+
+  Returns when no PEIM is left to evaluate, i.e. all PEIMs are dispatched or
+  wait for PPIs nobody has installed.
+
+  @param PeiCoreCtx   PEI core context.
+
+**/
+VOID
+DispatchPeims(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx
+  )
+{
+  PEIM_DISPATCHER *Disp;
+  PEIM_INFO *Peim;
+  EFI_STATUS Status;
+  BOOLEAN Result;
+  UINT16 Idx;
+  UINT16 Dispatched;
+
+  Disp = &PeiCoreCtx->Dispatcher;
+  ProcessDispatchNotifies(PeiCoreCtx); // PPIs installed by SEC and apriori
+
+  while ((Idx = TakeReady(Disp)) != PEIM_NIL) {
+    Peim = &Disp->Peims[Idx];
+    if (Peim->State != PEIM_STATE_PENDING) {
+      continue;
+    }
+
+    Result = TRUE;
+    if (Peim->Depex != NULL) {
+      Status = EvalDepex(PeiCoreCtx, Peim->Depex, Peim->DepexSize, &Result);
+      if (Status != EFI_SUCCESS) {
+        LOG("Bad dependency expression of PEIM %g\n", Peim->FileName);
+        Peim->State = PEIM_STATE_FAILED;
+        continue;
+      }
+    }
+
+    if (!Result) {
+      DBG("[%u] PEIM %g waits for dependencies\n", Idx, Peim->FileName);
+      continue;
+    }
+
+    DBG("[%u] Dispatch PEIM %g\n", Idx, Peim->FileName);
+    Peim->State = PEIM_STATE_DISPATCHED;
+    PEI_STATS_SET_CALLER(PeiCoreCtx, Idx);
+    CallPeim(Peim->Entry, Peim->FileName);
+    PEI_STATS_SET_CALLER(PeiCoreCtx, PEIM_NIL);
+    ProcessDispatchNotifies(PeiCoreCtx);
+  }
+
+  for (Dispatched = 0, Idx = 0; Idx < Disp->PeimCount; Idx++) {
+    if (Disp->Peims[Idx].State == PEIM_STATE_DISPATCHED) {
+      Dispatched++;
+    } else if (Disp->Peims[Idx].State == PEIM_STATE_PENDING) {
+      LOG("PEIM %g is not dispatched\n", Disp->Peims[Idx].FileName);
+    }
+  }
+
+  DBG("Dispatched %u of %u PEIMs\n", Dispatched, Disp->PeimCount);
+}
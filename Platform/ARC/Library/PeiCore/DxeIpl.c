@@ -11,6 +11,12 @@
 **/
 
 #include <Library/UtilsLib.h>
+#include <Library/BootPerfLib.h>
+#include <Library/TimerLib.h>
+#include <Library/CacheMaintenanceLib.h>
+#include <Library/ArcCacheLib.h>
+#include <Library/PcSampleLib.h>
+#include <Library/SerialPortExtLib.h>
 #include <Ppi/DxeIpl.h>
 #include <Core/Pei/PeiMain.h>
 
@@ -115,7 +121,8 @@ PeiLoadFile(
 
 VOID
 LoadAndRunDxeCore(
-  IN EFI_PEI_FILE_HANDLE File
+  IN EFI_PEI_FILE_HANDLE File,
+  IN EFI_PEI_HOB_POINTERS HobList
   )
 {
   SWITCH_STACK_ENTRY_POINT DxeCoreMain;
@@ -132,6 +139,35 @@ LoadAndRunDxeCore(
   }
 
   LOG("DXE core entry point %x\n", Entry);
+
+  //
+  // Last record before DXE core takes over, so HOB has them all
+  //
+  PerfRecord(MODULE_END_ID, &gEfiCallerIdGuid);
+  if (HobList.Raw != NULL) {
+    Status = BuildPerfHob(HobList.HandoffInformationTable);
+    if (Status != EFI_SUCCESS) {
+      LOG("Failed to build performance HOB, %a\n", StatusToAsciiStr(Status));
+    }
+  }
+
+  PcSampleStop();
+  PcSampleDump();
+
+  //
+  // DXE core polls the UART, received bytes left in the ring are dropped
+  //
+  SerialPortEnableRxInterrupt(FALSE);
+
+  //
+  // DXE core image and HOB list have to be in memory, and no stale lines of
+  // the area DXE core got loaded to in instruction cache. SLC is behind data
+  // cache, so it goes second.
+  //
+  WriteBackInvalidateDataCache();
+  WriteBackInvalidateSlc();
+  InvalidateInstructionCache();
+  PerfPhase(BOOT_PHASE_DXE, GetPerformanceCounter());
 #if 0
   BuildModuleHob(&FileInfo.FileName, Addr, ALIGN_VALUE(Size, EFI_PAGE_SIZE),
     Entry);
@@ -165,6 +201,8 @@ DxeIplMain(
   EFI_FV_FILE_INFO FileInfo;
   CONST EFI_PEI_SERVICES **Ps = (CONST EFI_PEI_SERVICES **) PeiServices;
 
+  PerfRecord(MODULE_START_ID, &gEfiCallerIdGuid);
+  PerfPhase(BOOT_PHASE_DXE_IPL, GetPerformanceCounter());
   LOG("Enter DXE IPL\n");
 
   Status = (*Ps)->FfsFindNextVolume(Ps, DXE_FV_INSTANCE, &Fv);
@@ -184,7 +222,7 @@ DxeIplMain(
   if (Status == EFI_SUCCESS) {
     // Should never return.
     LOG("Load DXE file %g\n", &FileInfo.FileName);
-    LoadAndRunDxeCore(File);
+    LoadAndRunDxeCore(File, HobList);
   }
 
   return EFI_LOAD_ERROR;
@@ -11,43 +11,90 @@
 #include "PeiCoreMain.h"
 #include <Library/UtilsLib.h>
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/PeiServicesTablePointerLib.h>
-
-#ifndef MAX_PEI_PPIS
-#define MAX_PEI_PPIS 256
+#include <Library/SerialPortExtLib.h>
+#include <Library/BootPerfLib.h>
+#include <Library/TimerLib.h>
+#include <Library/CpuExceptionHandlerLib.h>
+#include <Library/PcSampleLib.h>
+#include <Library/ArcCpuInfoLib.h>
+#include <Ppi/DxeIpl.h>
+#include <Common/Exception.h>
+
+#define PEI_PPI_CAPACITY FixedPcdGet32(PcdPeiPpiCapacity)
+#define PEI_PPI_BUCKETS PPI_HASH_BUCKETS(PEI_PPI_CAPACITY)
+
+STATIC_ASSERT(PEI_PPI_CAPACITY < PPI_HASH_NIL, "PPI capacity is too big");
+
+#define PEI_NOTIFY_CAPACITY FixedPcdGet32(PcdPeiNotifyCapacity)
+#define PEI_NOTIFY_BUCKETS PPI_HASH_BUCKETS(PEI_NOTIFY_CAPACITY)
+
+STATIC_ASSERT(PEI_NOTIFY_CAPACITY < PPI_HASH_NIL, "Notify capacity is too big");
+
+#define PEI_PEIM_CAPACITY FixedPcdGet32(PcdPeiPeimCapacity)
+#define PEI_WAITER_CAPACITY (PEI_PEIM_CAPACITY * PEIM_DEPEX_WAITERS)
+#define PEI_WAITER_BUCKETS PPI_HASH_BUCKETS(PEI_WAITER_CAPACITY)
+
+STATIC_ASSERT(PEI_WAITER_CAPACITY < PEIM_NIL, "PEIM capacity is too big");
+
+//
+// PEI core context, the pools it points to, CPU info PPI and PEI service
+// statistics. They are laid out in temporary RAM at PcdPeiCoreDataBase on
+// entry rather than kept in image data, which is in flash, so that no dirty
+// line of D$ is ever written back over it.
+//
+typedef struct {
+  PEI_CORE_CONTEXT Ctx;
+  PEI_PPI_LIST_POINTERS PpiList[PEI_PPI_CAPACITY];
+  PPI_HASH_LINK PpiLinks[PEI_PPI_CAPACITY];
+  UINT16 PpiBuckets[PEI_PPI_BUCKETS];
+  PEI_PPI_LIST_POINTERS CallbackList[PEI_NOTIFY_CAPACITY];
+  PPI_HASH_LINK CallbackLinks[PEI_NOTIFY_CAPACITY];
+  UINT16 CallbackBuckets[PEI_NOTIFY_BUCKETS];
+  PEI_PPI_LIST_POINTERS DispatchList[PEI_NOTIFY_CAPACITY];
+  PPI_HASH_LINK DispatchLinks[PEI_NOTIFY_CAPACITY];
+  UINT16 DispatchBuckets[PEI_NOTIFY_BUCKETS];
+  PEIM_INFO Peims[PEI_PEIM_CAPACITY];
+  PEIM_WAITER Waiters[PEI_WAITER_CAPACITY];
+  UINT16 WaiterBuckets[PEI_WAITER_BUCKETS];
+  UINT32 Ready[(PEI_PEIM_CAPACITY + 31) / 32];
+  PEIM_FIXUP Fixups[PEI_PEIM_CAPACITY];
+  ARC_CPU_INFO CpuInfo;
+  EFI_PEI_PPI_DESCRIPTOR CpuInfoPpiList;
+#ifdef PEI_SERVICE_STATS
+  PEI_SERVICE_STAT Stats[PEI_STATS_CALLERS][PEI_SERVICE_COUNT];
 #endif
-
-#define MAX_CORE_FV 2
-
-PEI_PPI_LIST_POINTERS mPpiListPool[MAX_PEI_PPIS];
-
-PEI_CORE_CONTEXT mPeiCoreCtx = {
-  .Ps = {
-    .Hdr = {
-      .Signature = PEI_SERVICES_SIGNATURE,
-      .Revision = PEI_SERVICES_REVISION,
-      .HeaderSize = sizeof(EFI_PEI_SERVICES),
-      .CRC32 = 0,
-      .Reserved = 0,
-    },
-    .InstallPpi = PeiInstallPpi,
-    .LocatePpi = PeiLocatePpi,
-    .NotifyPpi = PeiNotifyPpi,
-    .FfsFindNextVolume = PeiFfsFindNextVolume,
-    .FfsFindNextFile = PeiFfsFindNextFile,
-    .FfsFindSectionData = PeiFfsFindSectionData,
-    .FfsGetFileInfo = PeiFfsGetFileInfo,
-  },
-  .PpiData.PpiList = {
-    .CurrentCount = 0,
-    .MaxCount = ARRAY_SIZE(mPpiListPool),
-    .LastDispatchedCount = 0,
-    .PpiPtrs = mPpiListPool,
+} PEI_CORE_DATA;
+
+#define PEI_CORE_DATA_BASE FixedPcdGet32(PcdPeiCoreDataBase)
+#define PEI_CORE_DATA_SIZE FixedPcdGet32(PcdPeiCoreDataSize)
+
+STATIC_ASSERT(sizeof(PEI_CORE_DATA) <= PEI_CORE_DATA_SIZE,
+  "PEI core data does not fit PcdPeiCoreDataSize");
+
+#define PEI_CORE_DATA_PTR ((PEI_CORE_DATA *) PEI_CORE_DATA_BASE)
+
+//
+// Copied to PEI core context and fixed up on entry
+//
+STATIC CONST EFI_PEI_SERVICES mPeiServices = {
+  .Hdr = {
+    .Signature = PEI_SERVICES_SIGNATURE,
+    .Revision = PEI_SERVICES_REVISION,
+    .HeaderSize = sizeof(EFI_PEI_SERVICES),
+    .CRC32 = 0,
+    .Reserved = 0,
   },
+  .InstallPpi = PEI_SERVICE(PeiInstallPpi),
+  .LocatePpi = PEI_SERVICE(PeiLocatePpi),
+  .NotifyPpi = PeiNotifyPpi,
+  .FfsFindNextVolume = PEI_SERVICE(PeiFfsFindNextVolume),
+  .FfsFindNextFile = PEI_SERVICE(PeiFfsFindNextFile),
+  .FfsFindSectionData = PEI_SERVICE(PeiFfsFindSectionData),
+  .FfsGetFileInfo = PEI_SERVICE(PeiFfsGetFileInfo),
 };
 
-STATIC UINT32 mPeiFixup;
-
 inline
 EFI_FIRMWARE_VOLUME_HEADER *
 VoidToFvHdr(
@@ -68,9 +115,19 @@ IntToFvHdr(
 
 UINT32
 CalcPeiFixup(
+  IN CONST BOOT_MANIFEST_HEADER *Manifest OPTIONAL,
   IN VOID *FvBase
   )
 {
+  CONST BOOT_MANIFEST_ENTRY *Entry;
+
+  if (Manifest != NULL) {
+    Entry = FindManifestEntry(Manifest, EFI_FV_FILETYPE_PEI_CORE, NULL);
+    if (Entry != NULL) {
+      return Entry->Fixup;
+    }
+  }
+
   return (UINT32) GetFileSection(FvBase, EFI_SECTION_FREEFORM_SUBTYPE_GUID,
     EFI_FV_FILETYPE_PEI_CORE, NULL, NULL);
 }
@@ -82,66 +139,392 @@ GetCorePeiInstance(
 {
   //VOID *Ptr = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
   //return (PEI_CORE_INSTANCE *) (Ptr + mPeiFixup);
-  return &mPeiCoreCtx;
+  return &PEI_CORE_DATA_PTR->Ctx;
+}
+
+/**
+  Lay out PEI core context and its pools in temporary RAM, and fill in PEI
+  services table.
+
+  @param Fixup  Offset PEI core runs at from its link address.
+
+  @return PEI core context.
+
+**/
+STATIC
+PEI_CORE_CONTEXT *
+InitPeiCoreData(
+  IN UINT32 Fixup
+  )
+{
+  PEI_CORE_DATA *Data;
+  PEI_CORE_CONTEXT *Ctx;
+
+  Data = PEI_CORE_DATA_PTR;
+  ZeroMem(Data, sizeof(*Data));
+  SetMem16(Data->PpiBuckets, sizeof(Data->PpiBuckets), PPI_HASH_NIL);
+  SetMem16(Data->CallbackBuckets, sizeof(Data->CallbackBuckets), PPI_HASH_NIL);
+  SetMem16(Data->DispatchBuckets, sizeof(Data->DispatchBuckets), PPI_HASH_NIL);
+  SetMem16(Data->WaiterBuckets, sizeof(Data->WaiterBuckets), PEIM_NIL);
+
+  Ctx = &Data->Ctx;
+  Ctx->PpiData.PpiList.MaxCount = PEI_PPI_CAPACITY;
+  Ctx->PpiData.PpiList.PpiPtrs = Data->PpiList;
+  Ctx->PpiHash.Buckets = Data->PpiBuckets;
+  Ctx->PpiHash.Links = Data->PpiLinks;
+  Ctx->PpiHash.BucketMask = PEI_PPI_BUCKETS - 1;
+
+  Ctx->PpiData.CallbackNotifyList.MaxCount = PEI_NOTIFY_CAPACITY;
+  Ctx->PpiData.CallbackNotifyList.NotifyPtrs = Data->CallbackList;
+  Ctx->CallbackHash.Buckets = Data->CallbackBuckets;
+  Ctx->CallbackHash.Links = Data->CallbackLinks;
+  Ctx->CallbackHash.BucketMask = PEI_NOTIFY_BUCKETS - 1;
+
+  Ctx->PpiData.DispatchNotifyList.MaxCount = PEI_NOTIFY_CAPACITY;
+  Ctx->PpiData.DispatchNotifyList.NotifyPtrs = Data->DispatchList;
+  Ctx->DispatchHash.Buckets = Data->DispatchBuckets;
+  Ctx->DispatchHash.Links = Data->DispatchLinks;
+  Ctx->DispatchHash.BucketMask = PEI_NOTIFY_BUCKETS - 1;
+
+  Ctx->Dispatcher.Peims = Data->Peims;
+  Ctx->Dispatcher.PeimCapacity = PEI_PEIM_CAPACITY;
+  Ctx->Dispatcher.Waiters = Data->Waiters;
+  Ctx->Dispatcher.WaiterCapacity = PEI_WAITER_CAPACITY;
+  Ctx->Dispatcher.Buckets = Data->WaiterBuckets;
+  Ctx->Dispatcher.BucketMask = PEI_WAITER_BUCKETS - 1;
+  Ctx->Dispatcher.Ready = Data->Ready;
+
+  Ctx->Fixups.Entries = Data->Fixups;
+  Ctx->Fixups.Capacity = PEI_PEIM_CAPACITY;
+
+#ifdef PEI_SERVICE_STATS
+  Ctx->Stats = Data->Stats;
+  Ctx->StatsCaller = PEIM_NIL;
+#endif
+
+  CopyMem(&Ctx->Ps, &mPeiServices, sizeof(Ctx->Ps));
+  Ctx->PsPtr = &Ctx->Ps;
+
+  //
+  // Fix up addresses of PEI services, unless PEI core was relocated at build
+  // time (see scripts/xip-relocate.py)
+  //
+  if (Fixup != 0) {
+    Ctx->PsPtr->InstallPpi += Fixup;
+    Ctx->PsPtr->LocatePpi += Fixup;
+    Ctx->PsPtr->NotifyPpi += Fixup;
+    Ctx->PsPtr->FfsFindNextVolume += Fixup;
+    Ctx->PsPtr->FfsFindNextFile += Fixup;
+    Ctx->PsPtr->FfsFindSectionData += Fixup;
+    Ctx->PsPtr->FfsGetFileInfo += Fixup;
+  }
+
+  return Ctx;
 }
 
-#define GET_ENTRY_POINT(FileName)\
-  GetTeEntryPoint(FvBase, EFI_FV_FILETYPE_PEIM, FileName, &StatusInfo);
+VOID
+CallPeim(
+  IN EFI_PEIM_ENTRY_POINT2 PeimInit,
+  IN CONST EFI_GUID *FileName
+  )
+{
+  PEI_CORE_CONTEXT *PeiCoreCtx;
+  EFI_STATUS Status;
+
+  PeiCoreCtx = GetCorePeiInstance(NULL);
+  DBG("| Call PEIM's init at %p\n", PeimInit);
+  PerfRecord(MODULE_START_ID, FileName);
+  Status = PeimInit(NULL, (CONST EFI_PEI_SERVICES **) &PeiCoreCtx->PsPtr);
+  PerfRecord(MODULE_END_ID, FileName);
+  DBG("| Status %a\n", StatusToAsciiStr(Status));
+  SerialPortDrain(FALSE); // Keep transmitter busy between PEIMs
+}
 
 VOID
-InitPeims(
-  IN VOID *FvBase
+InitPeimsFromManifest(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN CONST BOOT_MANIFEST_HEADER *Manifest
   )
 {
+  CONST BOOT_MANIFEST_ENTRY *Entry;
   EFI_STATUS Status;
+  UINT16 Idx;
+
+  //
+  // PEIM entries are stored in dispatch order, apriori files first.
+  //
+  Entry = BOOT_MANIFEST_ENTRIES(Manifest);
+  for (Idx = 0; Idx < Manifest->Count; Idx++, Entry++) {
+    if (Entry->Type != EFI_FV_FILETYPE_PEIM) {
+      continue;
+    }
+
+    DBG("> Add PEIM file %g\n", &Entry->FileName);
+    if ((Entry->Flags & BOOT_MANIFEST_HAS_FIXUP) != 0) {
+      Status = AddPeimFixup(PeiCoreCtx, Entry->FileBase,
+        Entry->FileBase + Entry->FileSize, Entry->Fixup);
+      if (EFI_ERROR(Status)) {
+        LOG("Failed to add PEIM %g fixup, %a\n", &Entry->FileName,
+          StatusToAsciiStr(Status));
+      }
+    }
+
+    AddPeim(PeiCoreCtx, (EFI_PEIM_ENTRY_POINT2) (UINTN) Entry->EntryPoint,
+      &Entry->FileName, (CONST UINT8 *) (UINTN) Entry->Depex,
+      Entry->DepexSize);
+  }
+}
+
+VOID
+AddPeimFile(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN EFI_FFS_FILE_HEADER *File
+  )
+{
   STATUS_INFO StatusInfo;
   EFI_PEIM_ENTRY_POINT2 PeimInit;
+  EFI_COMMON_SECTION_HEADER *Section;
+  EFI_PHYSICAL_ADDRESS Sections;
+  EFI_PHYSICAL_ADDRESS Eof; // End of file
+  EFI_STATUS Status;
+
+  DBG("> Add PEIM file %g\n", &File->Name);
+
+  //
+  // Sections are looked up within the file, and its fixup is resolved once
+  // here instead of on every PPI installation.
+  //
+  Sections = ToPhysAddr(File + 1);
+  Eof = ToPhysAddr(File) + FFS_FILE_SIZE(File);
+
+  Section = FindSection(EFI_SECTION_TE, Sections, Eof, &StatusInfo);
+  if (Section == NULL) {
+    LOG("Failed to find PEIM entry point, %a | %u\n",
+      StatusToAsciiStr(StatusInfo.Status), StatusInfo.Line);
+    return;
+  }
+
+  PeimInit = GetTeSectionEntryPoint(Section);
+
+  Section = FindSection(EFI_SECTION_FREEFORM_SUBTYPE_GUID, Sections, Eof, NULL);
+  if (Section != NULL) {
+    Status = AddPeimFixup(PeiCoreCtx, (UINT32) ToPhysAddr(File),
+      (UINT32) Eof, (UINT32) ToPhysAddr(Section));
+    if (EFI_ERROR(Status)) {
+      LOG("Failed to add PEIM %g fixup, %a\n", &File->Name,
+        StatusToAsciiStr(Status));
+    }
+  }
+
+  Section = FindSection(EFI_SECTION_PEI_DEPEX, Sections, Eof, NULL);
+  if (Section == NULL) {
+    AddPeim(PeiCoreCtx, PeimInit, &File->Name, NULL, 0);
+  } else {
+    AddPeim(PeiCoreCtx, PeimInit, &File->Name, (CONST UINT8 *) (Section + 1),
+      SECTION_SIZE(Section) - sizeof(*Section));
+  }
+}
+
+BOOLEAN
+IsAprioriFile(
+  IN CONST PEI_APRIORI_FILE_CONTENTS *AprioriFile OPTIONAL,
+  IN UINTN AprioriCount,
+  IN CONST EFI_GUID *FileName
+  )
+{
+  UINTN Idx;
+
+  for (Idx = 0; Idx < AprioriCount; Idx++) {
+    if (CompareGuids(&AprioriFile->FileNamesWithinVolume[Idx], FileName)) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+VOID
+InitPeims(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN VOID *FvBase
+  )
+{
+  STATUS_INFO StatusInfo;
   PEI_APRIORI_FILE_CONTENTS *AprioriFile;
-  EFI_GUID *FileName;
+  EFI_COMMON_SECTION_HEADER *Section;
+  EFI_FFS_FILE_HEADER *File;
+  FFS_CURSOR Cursor;
+  UINTN AprioriCount;
+  UINTN Idx;
 
+  //
+  // Without manifest there is no precomputed order: apriori PEIMs go first,
+  // then the rest in volume order, dispatcher sorts out dependencies.
+  //
+  AprioriCount = 0;
   AprioriFile = GetAprioriFile(FvBase, &StatusInfo);
   if (AprioriFile == NULL) {
     LOG("Failed to find apriori file, %a | %u\n",
       StatusToAsciiStr(StatusInfo.Status), StatusInfo.Line);
-    return;
+  } else {
+    Section = ((EFI_COMMON_SECTION_HEADER *) AprioriFile) - 1;
+    AprioriCount = (SECTION_SIZE(Section) - sizeof(*Section)) /
+      sizeof(EFI_GUID);
   }
 
+  for (Idx = 0; Idx < AprioriCount; Idx++) {
+    File = FindFfsFile(FvBase, EFI_FV_FILETYPE_PEIM,
+      &AprioriFile->FileNamesWithinVolume[Idx], &StatusInfo);
+    if (File == NULL) {
+      LOG("Failed to find apriori PEIM %g, %a\n",
+        &AprioriFile->FileNamesWithinVolume[Idx],
+        StatusToAsciiStr(StatusInfo.Status));
+      continue;
+    }
+
+    AddPeimFile(PeiCoreCtx, File);
+  }
+
+  InitFfsCursor(&Cursor, FvBase, NULL);
+
+  while ((File = NextFfsFile(&Cursor, &StatusInfo)) != NULL) {
+    if (File->Type == EFI_FV_FILETYPE_PEIM &&
+      !IsAprioriFile(AprioriFile, AprioriCount, &File->Name)) {
+      AddPeimFile(PeiCoreCtx, File);
+    }
+  }
+
+  if (StatusInfo.Status != EFI_NOT_FOUND) {
+    LOG("Failed to walk boot volume, %a | %u\n",
+      StatusToAsciiStr(StatusInfo.Status), StatusInfo.Line);
+  }
+}
+
+/**
+  Decode CPU info once and install it as ARC CPU info PPI, so that PEIMs
+  size caches and locks without decoding build configuration registers
+  themselves.
+
+**/
+STATIC
+VOID
+InstallCpuInfoPpi(
+  IN PEI_CORE_CONTEXT *PeiCoreCtx
+  )
+{
+  EFI_STATUS Status;
+  ARC_CPU_INFO *CpuInfo;
+  EFI_PEI_PPI_DESCRIPTOR *PpiList;
+
+  CpuInfo = &PEI_CORE_DATA_PTR->CpuInfo;
+  PpiList = &PEI_CORE_DATA_PTR->CpuInfoPpiList;
+
+  GetArcCpuInfo(CpuInfo);
+  DBG("Core %u of %u, I$ %u/%u D$ %u/%u SLC %u/%u, DSP %u\n",
+    CpuInfo->CoreId, CpuInfo->CoreCount, CpuInfo->ICache.Size,
+    CpuInfo->ICache.LineSize, CpuInfo->DCache.Size, CpuInfo->DCache.LineSize,
+    CpuInfo->Slc.Size, CpuInfo->Slc.LineSize, CpuInfo->DspVersion);
+
   //
-  // TODO: Handle all GUIDs from apriori file
+  // Filled in here rather than statically, GUID is in the image and would
+  // need PEI core fixup
   //
-  FileName = &AprioriFile->FileNamesWithinVolume[0];
-  DBG("> Handle PEIM file %g\n", FileName);
+  PpiList->Flags = EFI_PEI_PPI_DESCRIPTOR_PPI |
+    EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
+  PpiList->Guid = &gArcCpuInfoPpiGuid;
+  PpiList->Ppi = CpuInfo;
+
+  Status = PeiInstallPpi((CONST EFI_PEI_SERVICES **) &PeiCoreCtx->PsPtr,
+    PpiList);
+  if (Status != EFI_SUCCESS) {
+    LOG("Failed to install CPU info PPI, %a\n", StatusToAsciiStr(Status));
+  }
+}
 
-  PeimInit = GET_ENTRY_POINT(FileName);
-  if (PeimInit != NULL) {
-    DBG("| Call PEIM's init at %p, %a | %u\n", PeimInit,
-      StatusToAsciiStr(StatusInfo.Status), StatusInfo.Line);
-    Status = PeimInit(NULL, (CONST EFI_PEI_SERVICES **) &mPeiCoreCtx.PsPtr);
-    DBG("| Status %a\n", StatusToAsciiStr(Status));
+STATIC
+VOID
+EFIAPI
+SerialRxHandler(
+  IN CONST EFI_EXCEPTION_TYPE InterruptType,
+  IN CONST EFI_SYSTEM_CONTEXT SystemContext
+  )
+{
+  SerialPortInterruptHandler();
+}
+
+/**
+  Route UART interrupt to serial port library, so that received bytes are
+  queued in its receive ring rather than lost while nobody polls the UART.
+  Nothing is routed if serial port library has no receive ring.
+
+**/
+STATIC
+VOID
+StartSerialRx(VOID)
+{
+  EFI_STATUS Status;
+
+  Status = RegisterCpuInterruptHandler(FixedPcdGet32(PcdSerialInterrupt),
+    SerialRxHandler);
+  if (Status != EFI_SUCCESS) {
+    LOG("Failed to register serial interrupt, %a\n",
+      StatusToAsciiStr(Status));
+    return;
   }
+
+  if (SerialPortEnableRxInterrupt(TRUE) != EFI_SUCCESS) {
+    RegisterCpuInterruptHandler(FixedPcdGet32(PcdSerialInterrupt), NULL);
+    return;
+  }
+
+  __builtin_arc_seti((1U << SETI_USE_OPERAND_BIT) | (1U << SETI_IE_BIT) |
+    ARC_IRQ_PRIORITY);
+  DBG("Serial receive on IRQ %u\n", FixedPcdGet32(PcdSerialInterrupt));
 }
 
 VOID
-DispatchPeims(VOID)
+RunDxeIpl(
+  IN PEI_CORE_CONTEXT *PeiCoreCtx
+  )
 {
+  ARC_CPU_INFO *CpuInfo;
   EFI_STATUS Status;
-  UINTN Idx;
-  EFI_PEI_PPI_DESCRIPTOR *TmpPpiDesc;
-  CONST EFI_DXE_IPL_PPI *Ppi;
+  EFI_DXE_IPL_PPI *Ppi;
   EFI_PEI_HOB_POINTERS HobList;
 
-  DBG("Available %u PPIs\n", mPeiCoreCtx.PpiData.PpiList.CurrentCount);
-
-  // TODO: make sure DXE IPL called last
+  Status = PeiLocatePpi((CONST EFI_PEI_SERVICES **) &PeiCoreCtx->PsPtr,
+    &gEfiDxeIplPpiGuid, 0, NULL, (VOID **) &Ppi);
+  if (Status != EFI_SUCCESS) {
+    LOG("No DXE IPL PPI, %a\n", StatusToAsciiStr(Status));
+    return;
+  }
 
-  for (Idx = 0; Idx < mPeiCoreCtx.PpiData.PpiList.CurrentCount; Idx++) {
-    TmpPpiDesc = mPeiCoreCtx.PpiData.PpiList.PpiPtrs[Idx].Ppi;
+  HobList.HandoffInformationTable = CreateHobList(
+    (VOID *) FixedPcdGet32(PcdHobListBase), FixedPcdGet32(PcdHobListSize));
+
+  if (HobList.Raw != NULL) {
+    CpuInfo = AddGuidHob(HobList.HandoffInformationTable, &gArcCpuInfoHobGuid,
+      sizeof(*CpuInfo));
+    if (CpuInfo != NULL) {
+      CopyMem(CpuInfo, &PEI_CORE_DATA_PTR->CpuInfo, sizeof(*CpuInfo));
+    } else {
+      LOG("Failed to add CPU info HOB\n");
+    }
+  }
 
-    Ppi = TmpPpiDesc->Ppi;
-    DBG("[%u] Run PPI GUID %g entry %p\n", Idx, TmpPpiDesc->Guid, Ppi->Entry);
-    Status = Ppi->Entry(TmpPpiDesc->Ppi, &mPeiCoreCtx.PsPtr, HobList);
-    DBG("| Status %a\n", StatusToAsciiStr(Status));
+#ifdef PEI_SERVICE_STATS
+  if (HobList.Raw != NULL) {
+    Status = PeiServiceStatsHob(PeiCoreCtx, HobList.HandoffInformationTable);
+    if (Status != EFI_SUCCESS) {
+      LOG("Failed to add PEI service stats HOB, %a\n",
+        StatusToAsciiStr(Status));
+    }
   }
+#endif
+
+  DBG("Run DXE IPL entry %p\n", Ppi->Entry);
+  Status = Ppi->Entry(Ppi, &PeiCoreCtx->PsPtr, HobList);
+  DBG("| Status %a\n", StatusToAsciiStr(Status));
 }
 
 /**
@@ -172,36 +555,60 @@ PeiCoreMain(
   VOID *TmpPtr;
   EFI_STATUS Status;
   EFI_DXE_IPL_PPI DxeIpl;
+  PEI_CORE_CONTEXT *PeiCoreCtx;
+  CONST BOOT_MANIFEST_HEADER *Manifest;
+  UINT32 Fixup;
 
-  mPeiFixup = CalcPeiFixup(SecCoreData->BootFirmwareVolumeBase);
+  PerfRecord(MODULE_START_ID, &gEfiCallerIdGuid);
+  PerfPhase(BOOT_PHASE_PEI, GetPerformanceCounter());
 
-  LOG("Enter PEI CORE, instance %p, fixup 0x%x\n", &mPeiCoreCtx, mPeiFixup);
+  Manifest = GetBootManifest((VOID *) FixedPcdGet32(PcdBootManifestBase));
+  Fixup = CalcPeiFixup(Manifest, SecCoreData->BootFirmwareVolumeBase);
+  PeiCoreCtx = InitPeiCoreData(Fixup);
+  PeiCoreCtx->Manifest = Manifest;
 
-  mPeiCoreCtx.PsPtr = &mPeiCoreCtx.Ps;
-
-  //
-  // Fix up addresses of PEI services
-  //
-  mPeiCoreCtx.PsPtr->InstallPpi += mPeiFixup;
-  mPeiCoreCtx.PsPtr->LocatePpi += mPeiFixup;
-  mPeiCoreCtx.PsPtr->NotifyPpi += mPeiFixup;
-  mPeiCoreCtx.PsPtr->FfsFindNextVolume += mPeiFixup;
-  mPeiCoreCtx.PsPtr->FfsFindNextFile += mPeiFixup;
-  mPeiCoreCtx.PsPtr->FfsFindSectionData += mPeiFixup;
-  mPeiCoreCtx.PsPtr->FfsGetFileInfo += mPeiFixup;
+  LOG("Enter PEI CORE, instance %p, fixup 0x%x\n", PeiCoreCtx, Fixup);
 
   //
   // Fill in BOOT and DXE FV info
   //
-  mPeiCoreCtx.Fv[0].FvHeader = VoidToFvHdr(SecCoreData->BootFirmwareVolumeBase);
-  mPeiCoreCtx.Fv[0].FvHandle = (VOID *) mPeiCoreCtx.Fv[0].FvHeader;
+  PeiCoreCtx->Fv[0].FvHeader = VoidToFvHdr(SecCoreData->BootFirmwareVolumeBase);
+  PeiCoreCtx->Fv[0].FvHandle = (VOID *) PeiCoreCtx->Fv[0].FvHeader;
+
+  PeiCoreCtx->Fv[1].FvHeader = IntToFvHdr(FixedPcdGet32(PcdDxeFvBase));
+  PeiCoreCtx->Fv[1].FvHandle = (VOID *) PeiCoreCtx->Fv[1].FvHeader;
 
-  mPeiCoreCtx.Fv[1].FvHeader = IntToFvHdr(FixedPcdGet32(PcdDxeFvBase));
-  mPeiCoreCtx.Fv[1].FvHandle = (VOID *) mPeiCoreCtx.Fv[1].FvHeader;
+  SetPeiServicesTablePointer((CONST EFI_PEI_SERVICES **) &PeiCoreCtx->PsPtr);
+  InstallCpuInfoPpi(PeiCoreCtx);
 
-  SetPeiServicesTablePointer((CONST EFI_PEI_SERVICES **) &mPeiCoreCtx.PsPtr);
-  InitPeims(SecCoreData->BootFirmwareVolumeBase);
-  DispatchPeims();
+  Status = InitializeCpuExceptionHandlers(NULL);
+  if (Status != EFI_SUCCESS) {
+    LOG("No exception vectors, %a\n", StatusToAsciiStr(Status));
+  } else {
+    if (PcSampleStart() == EFI_SUCCESS) {
+      DBG("Sample PC at %u Hz\n", FixedPcdGet32(PcdPcSampleRate));
+    }
+
+    StartSerialRx();
+  }
+
+  if (Manifest != NULL) {
+    InitPeimsFromManifest(PeiCoreCtx, Manifest);
+  } else {
+    LOG("No valid boot manifest, search boot FV\n");
+    InitPeims(PeiCoreCtx, SecCoreData->BootFirmwareVolumeBase);
+  }
+
+  DispatchPeims(PeiCoreCtx);
+  PerfRecord(MODULE_END_ID, &gEfiCallerIdGuid);
+  PEI_STATS_REPORT(PeiCoreCtx);
+
+  //
+  // DXE IPL PPI is called only after all PEIMs had their chance to run.
+  //
+  LOG_DUMP();
+  SerialPortDrain(TRUE);
+  RunDxeIpl(PeiCoreCtx);
 
   CpuDeadLoop();
 }
@@ -9,14 +9,116 @@
 **/
 
 #include <Core/Pei/PeiMain.h>
+#include <Library/UtilsLib.h>
+#ifdef PEI_SERVICE_STATS
+#include <Guid/PeiServiceStats.h>
+#endif
 
 #define MAX_CORE_FV 2
 
+//
+// PPI database hash. Descriptors are kept in PpiList in installation order,
+// the hash only links their indices: each bucket chains first instances of
+// distinct GUIDs, and each first instance chains the rest of its instances.
+// Callback and dispatch notify lists are hashed the same way, so instances of
+// a notify GUID are its listeners in registration order.
+//
+#define PPI_HASH_NIL 0xffff
+
+#define PPI_HASH_BUCKETS(Capacity)\
+  ((Capacity) <= 8 ? 8 : (Capacity) <= 16 ? 16 : (Capacity) <= 32 ? 32 :\
+   (Capacity) <= 64 ? 64 : (Capacity) <= 128 ? 128 : 256)
+
+typedef struct {
+  UINT16 NextGuid; // Next GUID in the same bucket
+  UINT16 NextInstance; // Next instance of the same GUID
+  UINT16 LastInstance; // Tail of instance chain, valid in first instance only
+  UINT16 Reserved;
+} PPI_HASH_LINK;
+
+typedef struct {
+  UINT16 *Buckets;
+  PPI_HASH_LINK *Links; // One per list entry
+  UINT32 BucketMask;
+} PPI_HASH;
+
+//
+// PEIM dispatcher. PEIMs are kept in dispatch order, and every GUID pushed by
+// their dependency expressions is linked into a GUID hash of waiters, so a PPI
+// installation marks only PEIMs depending on it for re-evaluation.
+//
+#define PEIM_NIL 0xffff
+
+// Waiter entries reserved per PEIM, PEIMs pushing more GUIDs than that are
+// re-evaluated on every PPI installation
+#define PEIM_DEPEX_WAITERS 4
+
+#define PEIM_STATE_PENDING 0
+#define PEIM_STATE_DISPATCHED 1
+#define PEIM_STATE_FAILED 2 // Malformed dependency expression
+
+#define PEIM_WAKE_ON_ANY BIT0
+
+typedef struct {
+  EFI_PEIM_ENTRY_POINT2 Entry;
+  CONST EFI_GUID *FileName;
+  CONST UINT8 *Depex; // NULL if PEIM has no dependencies
+  UINT16 DepexSize;
+  UINT8 State;
+  UINT8 Flags;
+} PEIM_INFO;
+
+typedef struct {
+  CONST EFI_GUID *Guid; // PUSH operand, may be unaligned
+  UINT16 Peim;
+  UINT16 Next; // Next waiter in the same bucket
+} PEIM_WAITER;
+
+typedef struct {
+  PEIM_INFO *Peims;
+  UINT16 PeimCount;
+  UINT16 PeimCapacity;
+  PEIM_WAITER *Waiters;
+  UINT16 WaiterCount;
+  UINT16 WaiterCapacity;
+  UINT16 *Buckets;
+  UINT32 BucketMask;
+  UINT32 *Ready; // Bitmap of PEIMs to evaluate, one bit per PEIM
+  UINT16 WakeOnAnyCount;
+} PEIM_DISPATCHER;
+
+//
+// Fixups of PIC PEIM images, resolved when PEIMs are registered. Entries are
+// kept sorted by image start, so descriptors passed to PEI services are
+// matched to the image they live in by binary search over address ranges.
+//
+typedef struct {
+  UINT32 Start;
+  UINT32 End;
+  UINT32 Fixup;
+} PEIM_FIXUP;
+
+typedef struct {
+  PEIM_FIXUP *Entries;
+  UINT16 Count;
+  UINT16 Capacity;
+} PEIM_FIXUP_TABLE;
+
 typedef struct {
   EFI_PEI_SERVICES    *PsPtr;
   EFI_PEI_SERVICES    Ps;
   PEI_PPI_DATABASE    PpiData;
+  PPI_HASH            PpiHash;
+  PPI_HASH            CallbackHash;
+  PPI_HASH            DispatchHash;
+  PEIM_DISPATCHER     Dispatcher;
+  PEIM_FIXUP_TABLE    Fixups;
   PEI_CORE_FV_HANDLE  Fv[MAX_CORE_FV];
+  CONST BOOT_MANIFEST_HEADER *Manifest; // NULL if manifest is not valid
+#ifdef PEI_SERVICE_STATS
+  PEI_SERVICE_STAT    (*Stats)[PEI_SERVICE_COUNT]; // PEI_STATS_CALLERS rows
+  UINT16              StatsCaller; // PEIM being dispatched or PEIM_NIL
+#endif
 } PEI_CORE_CONTEXT;
 
 #define PS_TO_PEI_CONTEXT_PTR(PsPtr_) BASE_CR(PsPtr_, PEI_CORE_CONTEXT, PsPtr)
@@ -25,3 +127,152 @@ PEI_CORE_CONTEXT *
 GetCorePeiInstance(
   IN CONST EFI_PEI_SERVICES **PeiServices
   );
+
+//
+// GUID must be 4-byte aligned.
+//
+inline
+UINT32
+HashGuid(
+  IN CONST EFI_GUID *Guid
+  )
+{
+  CONST UINT32 *Data = (CONST UINT32 *) Guid;
+
+  return ((Data[0] ^ Data[1] ^ Data[2] ^ Data[3]) * 0x9e3779b1) >> 16;
+}
+
+EFI_STATUS
+AddPeimFixup(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN UINT32 Start,
+  IN UINT32 End,
+  IN UINT32 Fixup
+  );
+
+VOID
+CallPeim(
+  IN EFI_PEIM_ENTRY_POINT2 PeimInit,
+  IN CONST EFI_GUID *FileName
+  );
+
+EFI_STATUS
+AddPeim(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN EFI_PEIM_ENTRY_POINT2 Entry,
+  IN CONST EFI_GUID *FileName,
+  IN CONST UINT8 *Depex OPTIONAL,
+  IN UINT16 DepexSize
+  );
+
+VOID
+WakePeims(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN CONST EFI_GUID *Guid
+  );
+
+VOID
+ProcessDispatchNotifies(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx
+  );
+
+VOID
+DispatchPeims(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx
+  );
+
+//
+// PEI service call accounting, see PeiServiceStats.c. Services table takes
+// PEI_SERVICE(PeiLocatePpi) etc., which are the services themselves unless
+// PEI_SERVICE_STATS is defined, and dispatcher names the PEIM it calls with
+// PEI_STATS_SET_CALLER() so calls are accounted to it. Statistics have a row
+// per PEIM and a last one for PEI core and notifications.
+//
+#ifdef PEI_SERVICE_STATS
+#define PEI_SERVICE(Name) Name##Stats
+#define PEI_STATS_SET_CALLER(PeiCoreCtx, Peim) (PeiCoreCtx)->StatsCaller = (Peim)
+#define PEI_STATS_REPORT(PeiCoreCtx) PeiServiceStatsReport(PeiCoreCtx)
+
+#define PEI_STATS_CALLERS (FixedPcdGet32(PcdPeiPeimCapacity) + 1)
+
+EFI_STATUS
+EFIAPI
+PeiInstallPpiStats(
+  IN CONST EFI_PEI_SERVICES       **PeiServices,
+  IN CONST EFI_PEI_PPI_DESCRIPTOR *PpiList
+  );
+
+EFI_STATUS
+EFIAPI
+PeiLocatePpiStats(
+  IN CONST EFI_PEI_SERVICES     **PeiServices,
+  IN CONST EFI_GUID             *Guid,
+  IN UINTN                      Instance,
+  IN OUT EFI_PEI_PPI_DESCRIPTOR **PpiDescriptor,
+  IN OUT VOID                   **Ppi
+  );
+
+EFI_STATUS
+EFIAPI
+PeiFfsFindNextVolumeStats(
+  IN CONST EFI_PEI_SERVICES **PeiServices,
+  IN UINTN                  Instance,
+  IN OUT EFI_PEI_FV_HANDLE  *VolumeHandle
+  );
+
+EFI_STATUS
+EFIAPI
+PeiFfsFindNextFileStats(
+  IN CONST EFI_PEI_SERVICES   **PeiServices,
+  IN EFI_FV_FILETYPE          SearchType,
+  IN CONST EFI_PEI_FV_HANDLE  FvHandle,
+  IN OUT EFI_PEI_FILE_HANDLE  *FileHandle
+  );
+
+EFI_STATUS
+EFIAPI
+PeiFfsFindSectionDataStats(
+  IN CONST EFI_PEI_SERVICES **PeiServices,
+  IN EFI_SECTION_TYPE       SectionType,
+  IN EFI_PEI_FILE_HANDLE    FileHandle,
+  OUT VOID                  **SectionData
+  );
+
+EFI_STATUS
+EFIAPI
+PeiFfsGetFileInfoStats(
+  IN EFI_PEI_FILE_HANDLE  FileHandle,
+  OUT EFI_FV_FILE_INFO    *FileInfo
+  );
+
+/**
+  Log calls, time and bytes of FV walked per caller and service.
+
+  @param PeiCoreCtx   PEI core context.
+
+**/
+VOID
+PeiServiceStatsReport(
+  IN CONST PEI_CORE_CONTEXT *PeiCoreCtx
+  );
+
+/**
+  Append statistics to HOB list, see Include/Guid/PeiServiceStats.h.
+
+  @param PeiCoreCtx   PEI core context.
+  @param HobList      PHIT HOB returned by CreateHobList().
+
+  @retval EFI_SUCCESS           HOB is added.
+  @retval EFI_OUT_OF_RESOURCES  HOB list is full.
+
+**/
+EFI_STATUS
+PeiServiceStatsHob(
+  IN CONST PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN OUT EFI_HOB_HANDOFF_INFO_TABLE *HobList
+  );
+#else
+#define PEI_SERVICE(Name) Name
+#define PEI_STATS_SET_CALLER(PeiCoreCtx, Peim)
+#define PEI_STATS_REPORT(PeiCoreCtx)
+#endif
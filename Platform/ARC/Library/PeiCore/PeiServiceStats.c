@@ -0,0 +1,310 @@
+/** @file
+  PEI service call accounting.
+
+  With PEI_SERVICE_STATS defined, PEI services table points to wrappers that
+  count calls, performance counter ticks and bytes of FV walked per service
+  and per calling PEIM. Without it this file is empty and the table points to
+  services directly. Statistics are kept in PEI core context, which is in
+  temporary RAM, see PEI_CORE_DATA in PeiCoreMain.c.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include "PeiCoreMain.h"
+
+#ifdef PEI_SERVICE_STATS
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/TimerLib.h>
+#include <Library/BootPerfLib.h>
+#include <Guid/PeiServiceStats.h>
+
+#define PEI_STATS_CORE (PEI_STATS_CALLERS - 1) // PEI core and notifications
+
+STATIC CONST CHAR8 *CONST mServiceNames[PEI_SERVICE_COUNT] = {
+  [PEI_SERVICE_INSTALL_PPI] = "InstallPpi",
+  [PEI_SERVICE_LOCATE_PPI] = "LocatePpi",
+  [PEI_SERVICE_FIND_NEXT_VOLUME] = "FfsFindNextVolume",
+  [PEI_SERVICE_FIND_NEXT_FILE] = "FfsFindNextFile",
+  [PEI_SERVICE_FIND_SECTION_DATA] = "FfsFindSectionData",
+  [PEI_SERVICE_GET_FILE_INFO] = "FfsGetFileInfo",
+};
+
+STATIC
+VOID
+Account(
+  IN UINTN Service,
+  IN UINT64 Start,
+  IN UINTN Bytes
+  )
+{
+  PEI_CORE_CONTEXT *PeiCoreCtx;
+  PEI_SERVICE_STAT *Stat;
+  UINT64 Mask;
+  UINT64 Ticks;
+
+  GetPerformanceCounterProperties(NULL, &Mask);
+  Ticks = (GetPerformanceCounter() - Start) & Mask;
+
+  PeiCoreCtx = GetCorePeiInstance(NULL);
+  if (PeiCoreCtx->StatsCaller < PEI_STATS_CORE) {
+    Stat = &PeiCoreCtx->Stats[PeiCoreCtx->StatsCaller][Service];
+  } else {
+    Stat = &PeiCoreCtx->Stats[PEI_STATS_CORE][Service];
+  }
+
+  Stat->Calls++;
+  Stat->TotalTicks += Ticks;
+  Stat->Bytes += Bytes;
+  if (Ticks > Stat->MaxTicks) {
+    Stat->MaxTicks = Ticks > MAX_UINT32 ? MAX_UINT32 : (UINT32) Ticks;
+  }
+}
+
+EFI_STATUS
+EFIAPI
+PeiInstallPpiStats(
+  IN CONST EFI_PEI_SERVICES       **PeiServices,
+  IN CONST EFI_PEI_PPI_DESCRIPTOR *PpiList
+  )
+{
+  EFI_STATUS Status;
+  UINT64 Start;
+
+  Start = GetPerformanceCounter();
+  Status = PeiInstallPpi(PeiServices, PpiList);
+  Account(PEI_SERVICE_INSTALL_PPI, Start, 0);
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+PeiLocatePpiStats(
+  IN CONST EFI_PEI_SERVICES     **PeiServices,
+  IN CONST EFI_GUID             *Guid,
+  IN UINTN                      Instance,
+  IN OUT EFI_PEI_PPI_DESCRIPTOR **PpiDescriptor,
+  IN OUT VOID                   **Ppi
+  )
+{
+  EFI_STATUS Status;
+  UINT64 Start;
+
+  Start = GetPerformanceCounter();
+  Status = PeiLocatePpi(PeiServices, Guid, Instance, PpiDescriptor, Ppi);
+  Account(PEI_SERVICE_LOCATE_PPI, Start, 0);
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+PeiFfsFindNextVolumeStats(
+  IN CONST EFI_PEI_SERVICES **PeiServices,
+  IN UINTN                  Instance,
+  IN OUT EFI_PEI_FV_HANDLE  *VolumeHandle
+  )
+{
+  EFI_STATUS Status;
+  UINT64 Start;
+
+  Start = GetPerformanceCounter();
+  Status = PeiFfsFindNextVolume(PeiServices, Instance, VolumeHandle);
+  Account(PEI_SERVICE_FIND_NEXT_VOLUME, Start, 0);
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+PeiFfsFindNextFileStats(
+  IN CONST EFI_PEI_SERVICES   **PeiServices,
+  IN EFI_FV_FILETYPE          SearchType,
+  IN CONST EFI_PEI_FV_HANDLE  FvHandle,
+  IN OUT EFI_PEI_FILE_HANDLE  *FileHandle
+  )
+{
+  EFI_STATUS Status;
+  UINT64 Start;
+  CONST EFI_FIRMWARE_VOLUME_HEADER *Fv;
+  CONST EFI_FFS_FILE_HEADER *File;
+  UINTN From;
+  UINTN To;
+
+  if (FvHandle == NULL || FileHandle == NULL) {
+    return PeiFfsFindNextFile(PeiServices, SearchType, FvHandle, FileHandle);
+  }
+
+  //
+  // Walk spans from the end of previously returned file, or from the end of
+  // volume header, to the end of header of found file or to volume end.
+  //
+  Fv = (CONST EFI_FIRMWARE_VOLUME_HEADER *) FvHandle;
+  File = (CONST EFI_FFS_FILE_HEADER *) *FileHandle;
+  if (File == NULL) {
+    From = (UINTN) Fv + Fv->HeaderLength;
+  } else {
+    From = (UINTN) File + FFS_FILE_SIZE(File);
+  }
+
+  Start = GetPerformanceCounter();
+  Status = PeiFfsFindNextFile(PeiServices, SearchType, FvHandle, FileHandle);
+
+  if (Status == EFI_SUCCESS) {
+    To = (UINTN) *FileHandle + sizeof(EFI_FFS_FILE_HEADER);
+  } else {
+    To = (UINTN) Fv + (UINTN) Fv->FvLength;
+  }
+
+  Account(PEI_SERVICE_FIND_NEXT_FILE, Start, To > From ? To - From : 0);
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+PeiFfsFindSectionDataStats(
+  IN CONST EFI_PEI_SERVICES **PeiServices,
+  IN EFI_SECTION_TYPE       SectionType,
+  IN EFI_PEI_FILE_HANDLE    FileHandle,
+  OUT VOID                  **SectionData
+  )
+{
+  EFI_STATUS Status;
+  UINT64 Start;
+  UINTN Bytes;
+
+  Start = GetPerformanceCounter();
+  Status = PeiFfsFindSectionData(PeiServices, SectionType, FileHandle,
+    SectionData);
+
+  Bytes = 0;
+  if (Status == EFI_SUCCESS) {
+    Bytes = (UINTN) *SectionData - (UINTN) FileHandle;
+  } else if (FileHandle != NULL) {
+    Bytes = FFS_FILE_SIZE((CONST EFI_FFS_FILE_HEADER *) FileHandle);
+  }
+
+  Account(PEI_SERVICE_FIND_SECTION_DATA, Start, Bytes);
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+PeiFfsGetFileInfoStats(
+  IN EFI_PEI_FILE_HANDLE  FileHandle,
+  OUT EFI_FV_FILE_INFO    *FileInfo
+  )
+{
+  EFI_STATUS Status;
+  UINT64 Start;
+
+  Start = GetPerformanceCounter();
+  Status = PeiFfsGetFileInfo(FileHandle, FileInfo);
+  Account(PEI_SERVICE_GET_FILE_INFO, Start,
+    Status == EFI_SUCCESS ? sizeof(EFI_FFS_FILE_HEADER) : 0);
+  return Status;
+}
+
+STATIC
+BOOLEAN
+HasCalls(
+  IN CONST PEI_SERVICE_STAT *Stats
+  )
+{
+  UINTN Service;
+
+  for (Service = 0; Service < PEI_SERVICE_COUNT; Service++) {
+    if (Stats[Service].Calls != 0) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+STATIC
+CONST EFI_GUID *
+CallerName(
+  IN CONST PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN UINTN Caller
+  )
+{
+  if (Caller < PeiCoreCtx->Dispatcher.PeimCount) {
+    return PeiCoreCtx->Dispatcher.Peims[Caller].FileName;
+  }
+
+  return &gEfiCallerIdGuid;
+}
+
+VOID
+PeiServiceStatsReport(
+  IN CONST PEI_CORE_CONTEXT *PeiCoreCtx
+  )
+{
+  CONST PEI_SERVICE_STAT *Stat;
+  UINTN Caller;
+  UINTN Service;
+
+  for (Caller = 0; Caller < PEI_STATS_CALLERS; Caller++) {
+    for (Service = 0; Service < PEI_SERVICE_COUNT; Service++) {
+      Stat = &PeiCoreCtx->Stats[Caller][Service];
+      if (Stat->Calls == 0) {
+        continue;
+      }
+
+      LOG("%g %a calls %u total %u us max %u ns bytes %u\n",
+        CallerName(PeiCoreCtx, Caller), mServiceNames[Service], Stat->Calls,
+        (UINTN) DivU64x32(GetTimeInNanoSecond(Stat->TotalTicks), 1000),
+        (UINTN) GetTimeInNanoSecond(Stat->MaxTicks), (UINTN) Stat->Bytes);
+    }
+  }
+}
+
+EFI_STATUS
+PeiServiceStatsHob(
+  IN CONST PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN OUT EFI_HOB_HANDOFF_INFO_TABLE *HobList
+  )
+{
+  PEI_SERVICE_STATS_HEADER *Header;
+  PEI_SERVICE_STATS_ENTRY *Entry;
+  UINTN Caller;
+  UINT16 Count;
+
+  for (Count = 0, Caller = 0; Caller < PEI_STATS_CALLERS; Caller++) {
+    Count += HasCalls(PeiCoreCtx->Stats[Caller]);
+  }
+
+  Header = AddGuidHob(HobList, &gArcPeiServiceStatsGuid,
+    sizeof(*Header) + Count * sizeof(*Entry));
+  if (Header == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Header->Frequency = GetPerformanceCounterProperties(NULL, NULL);
+  Header->EntryCount = Count;
+  Header->ServiceCount = PEI_SERVICE_COUNT;
+  Header->Reserved = 0;
+
+  Entry = (PEI_SERVICE_STATS_ENTRY *) (Header + 1);
+  for (Caller = 0; Caller < PEI_STATS_CALLERS; Caller++) {
+    if (!HasCalls(PeiCoreCtx->Stats[Caller])) {
+      continue;
+    }
+
+    if (Caller == PEI_STATS_CORE) {
+      ZeroMem(&Entry->FileName, sizeof(Entry->FileName));
+    } else {
+      CopyGuid(&Entry->FileName, CallerName(PeiCoreCtx, Caller));
+    }
+
+    CopyMem(Entry->Stats, PeiCoreCtx->Stats[Caller], sizeof(Entry->Stats));
+    Entry++;
+  }
+
+  return EFI_SUCCESS;
+}
+
+#endif // PEI_SERVICE_STATS
@@ -13,16 +13,104 @@
 #include "PeiCoreMain.h"
 #include <Library/UtilsLib.h>
 
+/**
+  Remember fixup of PIC PEIM image occupying [Start, End) address range.
+
+  @param PeiCoreCtx   PEI core context.
+  @param Start        Image start address.
+  @param End          Image end address.
+  @param Fixup        Value added to link time addresses of the image.
+
+  @return EFI_SUCCESS           Fixup added.
+  @return EFI_INVALID_PARAMETER Range is empty or overlaps another image.
+  @return EFI_OUT_OF_RESOURCES  No room left in fixup table.
+
+**/
+EFI_STATUS
+AddPeimFixup(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN UINT32 Start,
+  IN UINT32 End,
+  IN UINT32 Fixup
+  )
+{
+  PEIM_FIXUP_TABLE *Table;
+  UINT16 Idx;
+
+  Table = &PeiCoreCtx->Fixups;
+  if (Start >= End) {
+    return EFI_INVALID_PARAMETER;
+  } else if (Table->Count >= Table->Capacity) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // PEIMs are registered in dispatch order rather than address order, the
+  // table is small so plain insertion keeps it sorted.
+  //
+  for (Idx = Table->Count; Idx > 0; Idx--) {
+    if (Table->Entries[Idx - 1].Start < Start) {
+      break;
+    }
+    Table->Entries[Idx] = Table->Entries[Idx - 1];
+  }
+
+  if ((Idx > 0 && Table->Entries[Idx - 1].End > Start) ||
+    (Idx < Table->Count && Table->Entries[Idx + 1].Start < End)) {
+    for (; Idx < Table->Count; Idx++) { // Undo the shift
+      Table->Entries[Idx] = Table->Entries[Idx + 1];
+    }
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Table->Entries[Idx].Start = Start;
+  Table->Entries[Idx].End = End;
+  Table->Entries[Idx].Fixup = Fixup;
+  Table->Count++;
+
+  DBG("| PEIM image 0x%x-0x%x fixup 0x%x\n", Start, End, Fixup);
+  return EFI_SUCCESS;
+}
+
 //
-// TODO: Fixup caclulations should take PEIM's file name into account.
+// Find fixup of PEIM image containing given address, i.e. of the PEIM that
+// passed a descriptor living in its data. Images relocated at build time by
+// scripts/xip-relocate.py have no fixup and are not in the table, so their
+// descriptors get zero fixup.
 //
+STATIC
 UINT32
-CalcPeimFixup(
-  IN OUT STATUS_INFO *Status
+FindPeimFixup(
+  IN CONST PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN CONST VOID *Ptr
   )
 {
-  return (UINT32) GetFileSection((VOID *) FixedPcdGet32(PcdBootFvBase),
-    EFI_SECTION_FREEFORM_SUBTYPE_GUID, EFI_FV_FILETYPE_PEIM, NULL, Status);
+  CONST PEIM_FIXUP_TABLE *Table;
+  UINT32 Addr;
+  UINT16 Low;
+  UINT16 High;
+  UINT16 Mid;
+
+  Table = &PeiCoreCtx->Fixups;
+  Addr = (UINT32) (UINTN) Ptr;
+  Low = 0;
+  High = Table->Count;
+
+  // Find the last image starting at or below the address
+  while (Low < High) {
+    Mid = Low + ((High - Low) >> 1);
+    if (Table->Entries[Mid].Start <= Addr) {
+      Low = Mid + 1;
+    } else {
+      High = Mid;
+    }
+  }
+
+  if (Low == 0 || Addr >= Table->Entries[Low - 1].End) {
+    return 0;
+  }
+
+  return Table->Entries[Low - 1].Fixup;
 }
 
 VOID
@@ -33,12 +121,181 @@ FixupPpi(
 {
     EFI_DXE_IPL_PPI *Ppi;
 
+    if (PeimFixup == 0) { // Nothing to do, and descriptor may be in flash
+      return;
+    }
+
     Ppi = (EFI_DXE_IPL_PPI *) (PpiDesc->Ppi + PeimFixup);
     PpiDesc->Ppi = Ppi;
     Ppi->Entry += PeimFixup;
     PpiDesc->Guid = ((VOID *) PpiDesc->Guid) + PeimFixup;
 }
 
+//
+// Find first descriptor of given GUID in hashed list, or PPI_HASH_NIL. Both
+// PPI and notify descriptors start with Flags and Guid, so list entries are
+// looked at via Ppi member regardless of their type.
+//
+STATIC
+UINT16
+FindHashHead(
+  IN CONST PPI_HASH *Hash,
+  IN CONST PEI_PPI_LIST_POINTERS *Ptrs,
+  IN CONST EFI_GUID *Guid
+  )
+{
+  UINT16 Idx;
+
+  Idx = Hash->Buckets[HashGuid(Guid) & Hash->BucketMask];
+
+  while (Idx != PPI_HASH_NIL) {
+    if (CompareGuids(Guid, Ptrs[Idx].Ppi->Guid)) {
+      break;
+    }
+
+    Idx = Hash->Links[Idx].NextGuid;
+  }
+
+  return Idx;
+}
+
+STATIC
+VOID
+HashDescriptor(
+  IN OUT PPI_HASH *Hash,
+  IN CONST PEI_PPI_LIST_POINTERS *Ptrs,
+  IN UINT16 Idx
+  )
+{
+  CONST EFI_GUID *Guid;
+  UINT16 *Bucket;
+  UINT16 Head;
+
+  Hash->Links[Idx].NextGuid = PPI_HASH_NIL;
+  Hash->Links[Idx].NextInstance = PPI_HASH_NIL;
+  Hash->Links[Idx].LastInstance = Idx;
+
+  Guid = Ptrs[Idx].Ppi->Guid;
+  Head = FindHashHead(Hash, Ptrs, Guid);
+  if (Head == PPI_HASH_NIL) {
+    Bucket = &Hash->Buckets[HashGuid(Guid) & Hash->BucketMask];
+    Hash->Links[Idx].NextGuid = *Bucket;
+    *Bucket = Idx;
+  } else {
+    Hash->Links[Hash->Links[Head].LastInstance].NextInstance = Idx;
+    Hash->Links[Head].LastInstance = Idx;
+  }
+}
+
+STATIC
+VOID
+CallNotify(
+  IN PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR *NotifyDesc,
+  IN EFI_PEI_PPI_DESCRIPTOR *PpiDesc
+  )
+{
+  EFI_STATUS Status;
+
+  DBG("| Notify %p about PPI %g\n", NotifyDesc->Notify, PpiDesc->Guid);
+  Status = NotifyDesc->Notify(&PeiCoreCtx->PsPtr, NotifyDesc, PpiDesc->Ppi);
+  if (Status != EFI_SUCCESS) {
+    LOG("Notify %p failed, %a\n", NotifyDesc->Notify,
+      StatusToAsciiStr(Status));
+  }
+}
+
+//
+// Notify listeners registered before Limit about installed PPI. Instance
+// chains are in registration order, so walk stops at first newer listener.
+//
+STATIC
+VOID
+NotifyListeners(
+  IN PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN CONST PPI_HASH *Hash,
+  IN CONST PEI_PPI_LIST_POINTERS *Ptrs,
+  IN EFI_PEI_PPI_DESCRIPTOR *PpiDesc,
+  IN UINTN Limit
+  )
+{
+  UINT16 Idx;
+
+  Idx = FindHashHead(Hash, Ptrs, PpiDesc->Guid);
+  while (Idx != PPI_HASH_NIL && Idx < Limit) {
+    CallNotify(PeiCoreCtx, Ptrs[Idx].Notify, PpiDesc);
+    Idx = Hash->Links[Idx].NextInstance;
+  }
+}
+
+//
+// Notify listener about PPIs of its GUID installed before Limit.
+//
+STATIC
+VOID
+NotifyInstances(
+  IN PEI_CORE_CONTEXT *PeiCoreCtx,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR *NotifyDesc,
+  IN UINTN Limit
+  )
+{
+  PEI_PPI_LIST_POINTERS *Ptrs;
+  UINT16 Idx;
+
+  Ptrs = PeiCoreCtx->PpiData.PpiList.PpiPtrs;
+  Idx = FindHashHead(&PeiCoreCtx->PpiHash, Ptrs, NotifyDesc->Guid);
+  while (Idx != PPI_HASH_NIL && Idx < Limit) {
+    CallNotify(PeiCoreCtx, NotifyDesc, Ptrs[Idx].Ppi);
+    Idx = PeiCoreCtx->PpiHash.Links[Idx].NextInstance;
+  }
+}
+
+/**
+  Deliver PPIs installed since last dispatcher pass to dispatch notifies, and
+  PPIs installed so far to dispatch notifies registered since last pass.
+
+  Loops until notifies stop installing PPIs or registering new notifies, and
+  every PPI is delivered to every matching listener exactly once.
+
+  @param PeiCoreCtx   PEI core context.
+
+**/
+VOID
+ProcessDispatchNotifies(
+  IN OUT PEI_CORE_CONTEXT *PeiCoreCtx
+  )
+{
+  PEI_PPI_LIST *PpiList;
+  PEI_DISPATCH_NOTIFY_LIST *NotifyList;
+  UINTN PpiStart;
+  UINTN PpiEnd;
+  UINTN NotifyStart;
+  UINTN NotifyEnd;
+  UINTN Idx;
+
+  PpiList = &PeiCoreCtx->PpiData.PpiList;
+  NotifyList = &PeiCoreCtx->PpiData.DispatchNotifyList;
+
+  while (PpiList->LastDispatchedCount < PpiList->CurrentCount ||
+    NotifyList->LastDispatchedCount < NotifyList->CurrentCount) {
+    PpiStart = PpiList->LastDispatchedCount;
+    PpiEnd = PpiList->CurrentCount;
+    NotifyStart = NotifyList->LastDispatchedCount;
+    NotifyEnd = NotifyList->CurrentCount;
+    PpiList->LastDispatchedCount = PpiEnd;
+    NotifyList->LastDispatchedCount = NotifyEnd;
+
+    for (Idx = PpiStart; Idx < PpiEnd; Idx++) {
+      NotifyListeners(PeiCoreCtx, &PeiCoreCtx->DispatchHash,
+        NotifyList->NotifyPtrs, PpiList->PpiPtrs[Idx].Ppi, NotifyStart);
+    }
+
+    for (Idx = NotifyStart; Idx < NotifyEnd; Idx++) {
+      NotifyInstances(PeiCoreCtx, NotifyList->NotifyPtrs[Idx].Notify, PpiEnd);
+    }
+  }
+}
+
 #define IS_PIC_PPI(Flags)\
     ((Flags & EFI_PEI_PPI_DESCRIPTOR_PIC) ==\
      EFI_PEI_PPI_DESCRIPTOR_PIC)
@@ -58,8 +315,10 @@ PeiInstallPpi(
   UINT32 PeimFixup;
   PEI_CORE_CONTEXT *PeiCoreCtx;
   PEI_PPI_LIST *PpiListPointer;
+  CONST EFI_PEI_PPI_DESCRIPTOR *Desc;
   UINTN Idx;
   UINTN LastCount;
+  UINTN EndCount;
 
   if (PpiList == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -67,62 +326,79 @@ PeiInstallPpi(
 
   PeiCoreCtx = PS_TO_PEI_CONTEXT_PTR(PeiServices);
   PpiListPointer = &PeiCoreCtx->PpiData.PpiList;
-  Idx = PpiListPointer->CurrentCount;
-  LastCount = Idx;
-
-  if (Idx >= PeiCoreCtx->PpiData.PpiList.MaxCount) {
-    return EFI_NOT_FOUND;
-  }
+  LastCount = PpiListPointer->CurrentCount;
 
   DBG("> Request PPI desc %p PPI %p\n", PpiList, PpiList->Ppi);
 
-  PeimFixup = 0;
-  while (1) {
-    if ((PpiList->Flags & EFI_PEI_PPI_DESCRIPTOR_PPI) == 0) {
-      PpiListPointer->CurrentCount = LastCount;
+  //
+  // Check entire list before changing anything. Descriptors of PIC PEIMs
+  // are fixed up in place, a rejected list must stay untouched so that a
+  // retry does not fix them up twice.
+  //
+  EndCount = LastCount;
+  for (Desc = PpiList; ; Desc++) {
+    if ((Desc->Flags & EFI_PEI_PPI_DESCRIPTOR_PPI) == 0) {
       StatusInfo.Status = EFI_INVALID_PARAMETER;
       goto err;
     }
 
+    if (++EndCount > PpiListPointer->MaxCount) {
+      StatusInfo.Status = EFI_OUT_OF_RESOURCES;
+      goto err;
+    }
+
+    if (IS_LAST_PPI(Desc->Flags)) {
+      break;
+    }
+  }
+
+  PeimFixup = 0;
+  for (Idx = LastCount; Idx < EndCount; Idx++, PpiList++) {
     if (PeimFixup == 0 && IS_PIC_PPI(PpiList->Flags)) {
-      PeimFixup = CalcPeimFixup(&StatusInfo);
-      if (StatusInfo.Status != EFI_SUCCESS) {
-        goto err;
-      }
+      PeimFixup = FindPeimFixup(PeiCoreCtx, PpiList);
       DBG("| PEIM fixup 0x%x\n", PeimFixup);
     }
 
     PpiListPointer->PpiPtrs[Idx].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) PpiList;
-    PpiListPointer->CurrentCount++;
-
     FixupPpi(PpiListPointer->PpiPtrs[Idx].Ppi, PeimFixup);
 
     DBG("[%u/%u] Installed PPI %p GUID %g entry %p\n",
-      PpiListPointer->CurrentCount, PpiListPointer->CurrentCount,
+      Idx + 1, EndCount,
       PpiListPointer->PpiPtrs[Idx].Ppi->Ppi,
       PpiListPointer->PpiPtrs[Idx].Ppi->Guid,
       ((EFI_DXE_IPL_PPI *) PpiListPointer->PpiPtrs[Idx].Ppi->Ppi)->Entry);
+  }
 
-    if (IS_LAST_PPI(PpiList->Flags)) {
-      break;
-    }
+  //
+  // Link new descriptors only when entire list is accepted, then let PEIMs
+  // waiting for them be evaluated again. Callbacks may install more PPIs,
+  // those are handled by nested calls.
+  //
+  PpiListPointer->CurrentCount = EndCount;
+  for (Idx = LastCount; Idx < EndCount; Idx++) {
+    HashDescriptor(&PeiCoreCtx->PpiHash, PpiListPointer->PpiPtrs, Idx);
+  }
 
-    if (++Idx >= PeiCoreCtx->PpiData.PpiList.MaxCount) {
-      StatusInfo.Status = EFI_NOT_FOUND;
-      goto err;
-    }
+  for (Idx = LastCount; Idx < EndCount; Idx++) {
+    WakePeims(PeiCoreCtx, PpiListPointer->PpiPtrs[Idx].Ppi->Guid);
+  }
 
-    PpiList++;
-  };
+  for (Idx = LastCount; Idx < EndCount; Idx++) {
+    NotifyListeners(PeiCoreCtx, &PeiCoreCtx->CallbackHash,
+      PeiCoreCtx->PpiData.CallbackNotifyList.NotifyPtrs,
+      PpiListPointer->PpiPtrs[Idx].Ppi,
+      PeiCoreCtx->PpiData.CallbackNotifyList.CurrentCount);
+  }
 
   return EFI_SUCCESS;
 
 err:
   //
-  // Reject entire provided list.
+  // Reject entire provided list. GUID of a PIC descriptor is not fixed up
+  // yet, so only its address is logged.
   //
-  PpiListPointer->CurrentCount = LastCount;
-  LOG("Failed to install PPI %g\n", PpiList->Guid);
+  LOG("Failed to install PPI desc %p, %a\n", Desc,
+    StatusToAsciiStr(StatusInfo.Status));
   return StatusInfo.Status;
 }
 
@@ -136,9 +412,7 @@ PeiLocatePpi(
   IN OUT VOID                   **Ppi
   )
 {
-  UINTN Idx;
-  UINTN TmpInstance;
-  EFI_GUID *TmpGuid;
+  UINT16 Idx;
   EFI_PEI_PPI_DESCRIPTOR *TmpPpiDesc;
   PEI_CORE_CONTEXT *PeiCoreCtx;
 
@@ -147,33 +421,43 @@ PeiLocatePpi(
   }
 
   PeiCoreCtx = PS_TO_PEI_CONTEXT_PTR(PeiServices);
-  TmpInstance = 0;
 
   DBG("> Available %u PPIs\n", PeiCoreCtx->PpiData.PpiList.CurrentCount);
 
-  for (Idx = 0; Idx < PeiCoreCtx->PpiData.PpiList.CurrentCount; Idx++) {
-    TmpPpiDesc = PeiCoreCtx->PpiData.PpiList.PpiPtrs[Idx].Ppi;
+  Idx = FindHashHead(&PeiCoreCtx->PpiHash, PeiCoreCtx->PpiData.PpiList.PpiPtrs,
+    Guid);
+  while (Idx != PPI_HASH_NIL && Instance > 0) {
+    Idx = PeiCoreCtx->PpiHash.Links[Idx].NextInstance;
+    Instance--;
+  }
 
-    DBG("| Check PPI %u GUID %g ? %g\n", Idx, TmpPpiDesc->Guid, Guid);
+  if (Idx == PPI_HASH_NIL) {
+    return EFI_NOT_FOUND;
+  }
 
-    if (!TmpPpiDesc) {
-      continue;
-    } else if (!CompareGuids(Guid, TmpPpiDesc->Guid)) {
-      continue;
-    } else if (TmpInstance != Instance) {
-      TmpInstance++;
-      continue;
-    } else {
-      if (PpiDescriptor) {
-        *PpiDescriptor = TmpPpiDesc;
-      }
+  TmpPpiDesc = PeiCoreCtx->PpiData.PpiList.PpiPtrs[Idx].Ppi;
+  DBG("| Found PPI %u GUID %g\n", Idx, TmpPpiDesc->Guid);
 
-      *Ppi = TmpPpiDesc->Ppi;
-      return EFI_SUCCESS;
-    }
+  if (PpiDescriptor) {
+    *PpiDescriptor = TmpPpiDesc;
   }
 
-  return EFI_NOT_FOUND;
+  *Ppi = TmpPpiDesc->Ppi;
+  return EFI_SUCCESS;
+}
+
+VOID
+FixupNotify(
+  IN OUT EFI_PEI_NOTIFY_DESCRIPTOR *NotifyDesc,
+  UINT32                           PeimFixup
+  )
+{
+    if (PeimFixup == 0) {
+      return;
+    }
+
+    NotifyDesc->Notify += PeimFixup;
+    NotifyDesc->Guid = ((VOID *) NotifyDesc->Guid) + PeimFixup;
 }
 
 EFI_STATUS
@@ -183,7 +467,114 @@ PeiNotifyPpi (
   IN CONST EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyList
   )
 {
-  return EFI_UNSUPPORTED;
+  STATUS_INFO StatusInfo;
+  UINT32 PeimFixup;
+  PEI_CORE_CONTEXT *PeiCoreCtx;
+  PEI_CALLBACK_NOTIFY_LIST *CallbackList;
+  PEI_DISPATCH_NOTIFY_LIST *DispatchList;
+  CONST EFI_PEI_NOTIFY_DESCRIPTOR *Desc;
+  PEI_PPI_LIST_POINTERS *Ptr;
+  UINTN CallbackCount;
+  UINTN DispatchCount;
+  UINTN CallbackEnd;
+  UINTN DispatchEnd;
+  UINTN Idx;
+
+  if (NotifyList == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  PeiCoreCtx = PS_TO_PEI_CONTEXT_PTR(PeiServices);
+  CallbackList = &PeiCoreCtx->PpiData.CallbackNotifyList;
+  DispatchList = &PeiCoreCtx->PpiData.DispatchNotifyList;
+  CallbackCount = CallbackList->CurrentCount;
+  DispatchCount = DispatchList->CurrentCount;
+
+  DBG("> Request notify desc %p\n", NotifyList);
+
+  //
+  // As in PeiInstallPpi(), check entire list before fixing anything up
+  //
+  CallbackEnd = CallbackCount;
+  DispatchEnd = DispatchCount;
+  for (Desc = NotifyList; ; Desc++) {
+    switch (Desc->Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_TYPES) {
+    case EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK:
+      if (++CallbackEnd > CallbackList->MaxCount) {
+        StatusInfo.Status = EFI_OUT_OF_RESOURCES;
+        goto err;
+      }
+      break;
+    case EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH:
+      if (++DispatchEnd > DispatchList->MaxCount) {
+        StatusInfo.Status = EFI_OUT_OF_RESOURCES;
+        goto err;
+      }
+      break;
+    default:
+      StatusInfo.Status = EFI_INVALID_PARAMETER;
+      goto err;
+    }
+
+    if (IS_LAST_PPI(Desc->Flags)) {
+      break;
+    }
+  }
+
+  PeimFixup = 0;
+  while (1) {
+    if ((NotifyList->Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_TYPES) ==
+      EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK) {
+      Ptr = &CallbackList->NotifyPtrs[CallbackList->CurrentCount++];
+    } else {
+      Ptr = &DispatchList->NotifyPtrs[DispatchList->CurrentCount++];
+    }
+
+    if (PeimFixup == 0 && IS_PIC_PPI(NotifyList->Flags)) {
+      PeimFixup = FindPeimFixup(PeiCoreCtx, NotifyList);
+      DBG("| PEIM fixup 0x%x\n", PeimFixup);
+    }
+
+    Ptr->Notify = (EFI_PEI_NOTIFY_DESCRIPTOR *) NotifyList;
+    FixupNotify(Ptr->Notify, PeimFixup);
+
+    DBG("Registered notify %p GUID %g flags 0x%x\n", Ptr->Notify->Notify,
+      Ptr->Notify->Guid, Ptr->Notify->Flags);
+
+    if (IS_LAST_PPI(NotifyList->Flags)) {
+      break;
+    }
+
+    NotifyList++;
+  }
+
+  //
+  // As with PPIs, link new listeners only when entire list is accepted.
+  // Callbacks learn about already installed PPIs right away, dispatch
+  // notifies on next dispatcher pass.
+  //
+  for (Idx = DispatchCount; Idx < DispatchList->CurrentCount; Idx++) {
+    HashDescriptor(&PeiCoreCtx->DispatchHash, DispatchList->NotifyPtrs, Idx);
+  }
+
+  for (Idx = CallbackCount; Idx < CallbackList->CurrentCount; Idx++) {
+    HashDescriptor(&PeiCoreCtx->CallbackHash, CallbackList->NotifyPtrs, Idx);
+  }
+
+  for (Idx = CallbackCount; Idx < CallbackList->CurrentCount; Idx++) {
+    NotifyInstances(PeiCoreCtx, CallbackList->NotifyPtrs[Idx].Notify,
+      PeiCoreCtx->PpiData.PpiList.CurrentCount);
+  }
+
+  return EFI_SUCCESS;
+
+err:
+  //
+  // Reject entire provided list, see PeiInstallPpi()
+  //
+  LOG("Failed to register notify desc %p, %a\n", Desc,
+    StatusToAsciiStr(StatusInfo.Status));
+  return StatusInfo.Status;
 }
 
 EFI_STATUS
@@ -218,48 +609,30 @@ PeiFfsFindNextFile(
   IN OUT EFI_PEI_FILE_HANDLE  *FileHandle
   )
 {
-  EFI_FIRMWARE_VOLUME_HEADER *Fv;
+  FFS_CURSOR Cursor;
   EFI_FFS_FILE_HEADER *File;
-  EFI_PHYSICAL_ADDRESS Addr; // Address iterator
-  EFI_PHYSICAL_ADDRESS Eov; // End of volume
-  EFI_PHYSICAL_ADDRESS Eof; // End of file
-  GUID_STR GuidStr;
+  STATUS_INFO StatusInfo;
 
   if (FvHandle == NULL || FileHandle == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Fv = (EFI_FIRMWARE_VOLUME_HEADER *) FvHandle;
-  Eov = ToPhysAddr(Fv) + Fv->FvLength;
-
-  if (*FileHandle == NULL) {
-    Addr = AlignAddr(ToPhysAddr(Fv) + Fv->HeaderLength, 8);
-  } else {
-    // Get next file address
-    File = (EFI_FFS_FILE_HEADER *) (UINTN) *FileHandle;
-    Addr = AlignAddr(Addr + FFS_FILE_SIZE(File), 8);
-  }
-
-  while (Addr < Eov) {
-    File = (EFI_FFS_FILE_HEADER *) (UINTN) Addr;
-    Eof = Addr + FFS_FILE_SIZE(File);
-
-    GuidToAsciiStr(&File->Name, &GuidStr);
-    DBG("| Check file at %p type 0x%x name %a\n", File, File->Type, GuidStr.Data);
+  //
+  // Resume right after previously returned file, if any.
+  //
+  InitFfsCursor(&Cursor, FvHandle, *FileHandle);
 
-    if (Eof > Eov) { // Sanity check
-      return EFI_VOLUME_CORRUPTED;
-    }
+  while ((File = NextFfsFile(&Cursor, &StatusInfo)) != NULL) {
+    TRACE("| Check file at %p type 0x%x name %g\n", File, File->Type,
+      &File->Name);
 
-    if (File->Type == SearchType) {
+    if (SearchType == EFI_FV_FILETYPE_ALL || File->Type == SearchType) {
       *FileHandle = File;
       return EFI_SUCCESS;
     }
-
-    Addr = AlignAddr(Eof, 8);
   }
 
-  return EFI_NOT_FOUND;
+  return StatusInfo.Status;
 }
 
 EFI_STATUS
@@ -304,12 +677,11 @@ PeiFfsGetFileInfo(
     return EFI_INVALID_PARAMETER;
   }
 
+  File = (EFI_FFS_FILE_HEADER *) FileHandle;
   if (IS_FFS_FILE2(File)) {
     return EFI_UNSUPPORTED;
   }
 
-  File = (EFI_FFS_FILE_HEADER *) FileHandle;
-
   CopyMem(&FileInfo->FileName.Data1, &File->Name, sizeof(FileInfo->FileName));
 
   FileInfo->FileType = File->Type;
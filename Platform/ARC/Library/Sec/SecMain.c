@@ -11,7 +11,12 @@
 #include <Library/UtilsLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/SerialPortLib.h>
+#include <Library/SerialPortExtLib.h>
 #include <Library/PrintLib.h>
+#include <Library/BootPerfLib.h>
+#include <Library/PcdLib.h>
+#include <Library/ArcCpuInfoLib.h>
+#include <Common/Cpu.h>
 
 typedef struct {
   UINT8 ZeroVector[16];
@@ -32,16 +37,62 @@ IsValidBootFv(
   return CompareGuid(&BootFv->FileSystemGuid, &gEfiFirmwareFileSystem2Guid);
 }
 
+/**
+  Enable caches selected by PcdArcCachePolicy, _ModuleEntryPoint leaves them
+  invalidated and disabled. Data caches are bypassed from PcdArcUncachedBase
+  up, so that device registers are never cached.
+
+  There is one uncached region only, flash is cached for XIP code and has to
+  be written to with cache bypassing accesses.
+
+**/
+STATIC
+VOID
+InitCaches(VOID)
+{
+  ARC_CPU_INFO Info;
+  UINT32 Policy;
+  UINT32 Ctrl;
+
+  GetArcCpuInfo(&Info);
+  Policy = FixedPcdGet32(PcdArcCachePolicy);
+  if ((Policy & ((1 << CACHE_POLICY_DC_BIT) | (1 << CACHE_POLICY_SLC_BIT)))
+    != 0) {
+    Ctrl = __builtin_arc_lr(ARC_AUX_VOLATILE);
+    __builtin_arc_sr((Ctrl & 0x0fffffff) |
+      (FixedPcdGet32(PcdArcUncachedBase) & 0xf0000000), ARC_AUX_VOLATILE);
+  }
+
+  if ((Policy & (1 << CACHE_POLICY_SLC_BIT)) != 0 && Info.Slc.Size != 0) {
+    Ctrl = __builtin_arc_lr(ARC_AUX_SLC_CTRL);
+    __builtin_arc_sr(Ctrl & ~(1 << CACHE_CTRL_DC_BIT), ARC_AUX_SLC_CTRL);
+  }
+
+  if ((Policy & (1 << CACHE_POLICY_DC_BIT)) != 0 && Info.DCache.Size != 0) {
+    Ctrl = __builtin_arc_lr(ARC_AUX_DC_CTRL);
+    __builtin_arc_sr(Ctrl & ~(1 << CACHE_CTRL_DC_BIT), ARC_AUX_DC_CTRL);
+  }
+
+  if ((Policy & (1 << CACHE_POLICY_IC_BIT)) != 0 && Info.ICache.Size != 0) {
+    Ctrl = __builtin_arc_lr(ARC_AUX_IC_CTRL);
+    __builtin_arc_sr(Ctrl & ~(1 << CACHE_CTRL_DC_BIT), ARC_AUX_IC_CTRL);
+  }
+}
+
 /**
   The entry point of SEC Image.
 
   UEFI PI 1.8: I-17.1 Security (SEC) phase information.
 
+  @param EntryTicks   Performance counter value at _ModuleEntryPoint.
+
   @return This function should not return.
 
 **/
 VOID
-SecMain(VOID)
+SecMain(
+  IN UINT64 EntryTicks
+  )
 {
   EFI_PEI_CORE_ENTRY_POINT PeiEp;
   EFI_FIRMWARE_VOLUME_HEADER BootFv;
@@ -49,11 +100,19 @@ SecMain(VOID)
   FV_HEADER BootFvHdr;
   STATUS_INFO StatusInfo;
   EFI_SEC_PEI_HAND_OFF SecData;
+  CONST BOOT_MANIFEST_HEADER *Manifest;
+  CONST BOOT_MANIFEST_ENTRY *Entry;
+
+  InitCaches();
+  PerfReset();
+  PerfRecordTicks(EntryTicks, MODULE_START_ID, &gEfiCallerIdGuid);
+  PerfRecord(PERF_EVENT_ID, &gEfiCallerIdGuid);
 
   CopyMem(&BootFvHdr, (VOID *) FixedPcdGet32(PcdBootFvBase), sizeof(BootFvHdr));
   CopyMem(&BootFv, (VOID *) &BootFvHdr, BootFvHdr.HeaderLength);
 
   SerialRegisterBase = SerialPortInitialize();
+  PerfPhase(BOOT_PHASE_SEC, EntryTicks);
   LOG("Enter SEC, boot FV addr %p size %u\n", &BootFv, BootFv.HeaderLength);
 
   if (BootFv.Signature != EFI_FVH_SIGNATURE) {
@@ -73,8 +132,21 @@ SecMain(VOID)
   SecData.BootFirmwareVolumeBase = FixedPcdGet32(PcdBootFvBase);
   SecData.BootFirmwareVolumeSize = (UINTN) BootFv.FvLength;
 
-  PeiEp = GetTeEntryPoint(SecData.BootFirmwareVolumeBase,
-    EFI_FV_FILETYPE_PEI_CORE, NULL, &StatusInfo);
+  PeiEp = NULL;
+  Manifest = GetBootManifest((VOID *) FixedPcdGet32(PcdBootManifestBase));
+  if (Manifest != NULL) {
+    Entry = FindManifestEntry(Manifest, EFI_FV_FILETYPE_PEI_CORE, NULL);
+    if (Entry != NULL) {
+      PeiEp = (EFI_PEI_CORE_ENTRY_POINT) (UINTN) Entry->EntryPoint;
+    }
+  }
+
+  if (PeiEp == NULL) {
+    DBG("No valid boot manifest, search boot FV\n");
+    PeiEp = GetTeEntryPoint(SecData.BootFirmwareVolumeBase,
+      EFI_FV_FILETYPE_PEI_CORE, NULL, &StatusInfo);
+  }
+
   if (PeiEp == NULL) {
     LOG("Failed to find PEI core entry point | Status '%a' %u\n",
       StatusToAsciiStr(StatusInfo.Status), StatusInfo.Line);
@@ -93,10 +165,12 @@ SecMain(VOID)
 
   LOG("Call PEI core at %p\n", PeiEp);
 
+  PerfRecord(MODULE_END_ID, &gEfiCallerIdGuid);
   PeiEp(&SecData, NULL);
 
   LOG("Fatal error: returned from PEI entry point\n");
 
 halt:
   LOG("-= Boot failed =-\n");
+  SerialPortDrain(TRUE);
 }
@@ -14,6 +14,8 @@
 #include <Uefi/UefiBaseType.h>
 
 VOID
-SecMain(VOID);
+SecMain(
+  IN UINT64 EntryTicks
+  );
 
 #endif // SEC_MAIN_H_
@@ -1,6 +1,18 @@
 /** @file
   Minimalist 16550 UART Serial Port driver.
 
+  When PcdSerialTxRingSize is not 0, SerialPortWrite() queues bytes in a ring
+  in temporary RAM and returns right away. Every SerialPortWrite() and
+  SerialPortDrain() call refills transmit FIFO from the ring if FIFO is
+  empty. Writers wait for the UART only when the ring is full.
+
+  When PcdSerialRxRingSize is not 0 and PEI core routed UART interrupt to
+  SerialPortInterruptHandler(), SerialPortEnableRxInterrupt() enables received
+  data available interrupt and the handler fills a receive ring, which
+  SerialPortRead() and SerialPortPoll() consume without touching the UART.
+  With hardware flow control RTS is dropped once the ring is 3/4 full and
+  raised again once it is 1/4 full.
+
   This implementation is just a stripped down version of
   MdeModulePkg/Library/BaseSerialPortLib16550/BaseSerialPortLib16550.c
 
@@ -13,6 +25,7 @@
 
 #include <Base.h>
 #include <Library/SerialPortLib.h>
+#include <Library/SerialPortExtLib.h>
 #include <Library/PcdLib.h>
 #include <Library/IoLib.h>
 #include <Library/BaseLib.h>
@@ -26,6 +39,7 @@
 #define R_UART_DLL          0
 #define R_UART_DLM          1
 #define R_UART_IER          1
+#define B_UART_IER_RDA      BIT0
 
 #define R_UART_FCR          2
 #define B_UART_FCR_FIFOE    BIT0
@@ -41,6 +55,7 @@
 #define R_UART_MCR          4
 #define B_UART_MCR_DTR      BIT0
 #define B_UART_MCR_RTS      BIT1
+#define B_UART_MCR_OUT2     BIT3 // Routes interrupt to the CPU
 #define B_UART_MCRVAL       (B_UART_MCR_DTR | B_UART_MCR_RTS)
 
 #define R_UART_LSR          5
@@ -52,6 +67,31 @@
 #define B_UART_MSR_CTS      BIT4
 #define B_UART_MSR_DSR      BIT5
 
+#define SERIAL_TX_RING_SIGNATURE SIGNATURE_32('S', 'T', 'X', 'R')
+
+typedef struct {
+  UINT32 Signature;
+  UINT32 Size; // Power of 2
+  UINT32 Head; // Free running write counter
+  UINT32 Tail; // Free running read counter
+} SERIAL_TX_RING;
+
+#define SERIAL_RX_RING_SIGNATURE SIGNATURE_32('S', 'R', 'X', 'R')
+
+//
+// Single producer (interrupt handler) and single consumer ring, producer
+// only moves Head and consumer only moves Tail.
+//
+typedef struct {
+  UINT32 Signature;
+  UINT32 Size; // Power of 2
+  volatile UINT32 Head; // Free running write counter
+  volatile UINT32 Tail; // Free running read counter
+  UINT32 Dropped; // Bytes lost because ring was full
+  UINT32 Active; // Interrupt fills the ring
+  UINT32 Reserved[2];
+} SERIAL_RX_RING;
+
 #undef PcdGetBool
 #define PcdGetBool(TokenName) _PCD_VALUE_##TokenName
 
@@ -160,30 +200,31 @@ GetSerialRegisterBase(VOID)
 
 #define B_UART_IS_WRITABLE (B_UART_MSR_DSR | B_UART_MSR_CTS)
 
+BOOLEAN
+SerialPortIsWritable(
+  UINTN  SerialBase
+  )
+{
+  UINT8 Bits;
+
+  if (!PcdGetBool(PcdSerialUseHardwareFlowControl)) {
+    return TRUE;
+  }
+
+  Bits = SerialIn(SerialBase, R_UART_MSR) & B_UART_IS_WRITABLE;
+  if (PcdGetBool(PcdSerialDetectCable)) {
+    return Bits == B_UART_IS_WRITABLE;
+  }
+
+  return Bits != B_UART_MSR_DSR;
+}
+
 VOID
 SerialPortWaitWritable(
   UINTN  SerialBase
   )
 {
-  while (1) {
-    if (!PcdGetBool(PcdSerialUseHardwareFlowControl)) {
-      return;
-    } else {
-      //
-      // Wait for the hardware flow control signal
-      //
-      if (PcdGetBool(PcdSerialDetectCable)) {
-        UINT8 Bits = SerialIn(SerialBase, R_UART_MSR) & B_UART_IS_WRITABLE;
-        if (Bits == B_UART_IS_WRITABLE) {
-          return;
-        }
-      } else {
-        UINT8 Bits = SerialIn(SerialBase, R_UART_MSR) & B_UART_IS_WRITABLE;
-        if (Bits != B_UART_MSR_DSR) {
-          return;
-        }
-      }
-    }
+  while (!SerialPortIsWritable(SerialBase)) {
   }
 }
 
@@ -203,6 +244,342 @@ SerialPortFlush(
   }
 }
 
+/**
+  Get transmit FIFO size.
+
+  @return Number of bytes FIFO takes once it is empty.
+**/
+UINTN
+GetTxFifoSize(VOID)
+{
+  if ((PcdGet8(PcdSerialFifoControl) & B_UART_FCR_FIFOE) == 0) {
+    return 1;
+  }
+
+  if ((PcdGet8(PcdSerialFifoControl) & B_UART_FCR_FIFO64) == 0) {
+    return 16;
+  }
+
+  return PcdGet32(PcdSerialExtendedTxFifoSize);
+}
+
+/**
+  Wait until transmit FIFO can take GetTxFifoSize() bytes. Unlike
+  SerialPortFlush() this does not wait for the shift register.
+
+  @param  Base  The base address register of UART device.
+**/
+VOID
+SerialPortWaitTxEmpty(
+  UINTN  Base
+  )
+{
+  while ((SerialIn(Base, R_UART_LSR) & B_UART_LSR_TXRDY) == 0) {
+  }
+}
+
+/**
+  Get transmit ring, setting it up if this is the first use.
+
+  @return Transmit ring, NULL if buffering is disabled.
+**/
+SERIAL_TX_RING *
+GetTxRing(VOID)
+{
+  SERIAL_TX_RING *Ring;
+  UINT32 Size;
+
+  if (PcdGet32(PcdSerialTxRingSize) <= sizeof(SERIAL_TX_RING)) {
+    return NULL;
+  }
+
+  Ring = (SERIAL_TX_RING *) (UINTN) PcdGet32(PcdSerialTxRingBase);
+  Size = GetPowerOfTwo32(PcdGet32(PcdSerialTxRingSize) -
+    sizeof(SERIAL_TX_RING));
+
+  if (Ring->Signature != SERIAL_TX_RING_SIGNATURE || Ring->Size != Size ||
+    Ring->Head - Ring->Tail > Size) {
+    Ring->Signature = SERIAL_TX_RING_SIGNATURE;
+    Ring->Size = Size;
+    Ring->Head = 0;
+    Ring->Tail = 0;
+  }
+
+  return Ring;
+}
+
+/**
+  Get receive ring.
+
+  @return Receive ring, NULL if interrupt driven receive is disabled.
+**/
+SERIAL_RX_RING *
+GetRxRing(VOID)
+{
+  if (PcdGet32(PcdSerialRxRingSize) <= sizeof(SERIAL_RX_RING)) {
+    return NULL;
+  }
+
+  return (SERIAL_RX_RING *) (UINTN) PcdGet32(PcdSerialRxRingBase);
+}
+
+/**
+  Get receive ring, if interrupt fills it.
+
+  @return Receive ring, NULL if the UART has to be polled.
+**/
+SERIAL_RX_RING *
+GetActiveRxRing(VOID)
+{
+  SERIAL_RX_RING *Ring;
+
+  Ring = GetRxRing();
+  if (Ring == NULL || Ring->Signature != SERIAL_RX_RING_SIGNATURE ||
+    !Ring->Active) {
+    return NULL;
+  }
+
+  return Ring;
+}
+
+/**
+  Get receive ring, setting it up if it is not valid. Ring is left inactive
+  until SerialPortEnableRxInterrupt().
+
+  @return Receive ring, NULL if interrupt driven receive is disabled.
+**/
+SERIAL_RX_RING *
+InitRxRing(VOID)
+{
+  SERIAL_RX_RING *Ring;
+  UINT32 Size;
+
+  Ring = GetRxRing();
+  if (Ring == NULL) {
+    return NULL;
+  }
+
+  Size = GetPowerOfTwo32(PcdGet32(PcdSerialRxRingSize) -
+    sizeof(SERIAL_RX_RING));
+
+  if (Ring->Signature != SERIAL_RX_RING_SIGNATURE || Ring->Size != Size ||
+    Ring->Head - Ring->Tail > Size) {
+    Ring->Signature = SERIAL_RX_RING_SIGNATURE;
+    Ring->Size = Size;
+    Ring->Head = 0;
+    Ring->Tail = 0;
+    Ring->Dropped = 0;
+  }
+
+  Ring->Active = FALSE;
+  return Ring;
+}
+
+/**
+  Get modem control register value.
+
+  @param  Ring  Receive ring, NULL if interrupt driven receive is disabled.
+  @param  Rts   TRUE to let the peer send data.
+
+  @return MCR value.
+**/
+UINT8
+GetMcr(
+  SERIAL_RX_RING  *Ring,
+  BOOLEAN         Rts
+  )
+{
+  UINT8 Mcr;
+
+  Mcr = B_UART_MCR_DTR;
+  if (Rts) {
+    Mcr |= B_UART_MCR_RTS;
+  }
+
+  if (Ring != NULL) {
+    Mcr |= B_UART_MCR_OUT2;
+  }
+
+  return Mcr;
+}
+
+VOID
+EFIAPI
+SerialPortInterruptHandler(VOID)
+{
+  SERIAL_RX_RING *Ring;
+  UINT8 *Data;
+  UINTN Base;
+  UINT32 Head;
+  UINT8 Byte;
+
+  Base = GetSerialRegisterBase();
+  Ring = GetActiveRxRing();
+  if (Base == 0 || Ring == NULL) {
+    return;
+  }
+
+  Data = (UINT8 *) (Ring + 1);
+  Head = Ring->Head;
+
+  while ((SerialIn(Base, R_UART_LSR) & B_UART_LSR_RXRDY) != 0) {
+    Byte = SerialIn(Base, R_UART_RXBUF);
+    if (Head - Ring->Tail == Ring->Size) {
+      Ring->Dropped++;
+      continue;
+    }
+
+    Data[Head++ & (Ring->Size - 1)] = Byte;
+  }
+
+  MemoryFence(); // Data is in place before consumer sees new Head
+  Ring->Head = Head;
+
+  if (PcdGetBool(PcdSerialUseHardwareFlowControl) &&
+    Head - Ring->Tail >= Ring->Size - (Ring->Size >> 2)) {
+    SerialOut(Base, R_UART_MCR, GetMcr(Ring, FALSE));
+  }
+}
+
+EFI_STATUS
+EFIAPI
+SerialPortEnableRxInterrupt(
+  IN BOOLEAN Enable
+  )
+{
+  SERIAL_RX_RING *Ring;
+  UINTN Base;
+
+  Base = GetSerialRegisterBase();
+  Ring = GetRxRing();
+  if (Base == 0 || Ring == NULL ||
+    Ring->Signature != SERIAL_RX_RING_SIGNATURE) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Enable) {
+    Ring->Active = TRUE;
+    MemoryFence(); // Handler sees active ring once UART interrupts
+    SerialOut(Base, R_UART_IER, B_UART_IER_RDA);
+  } else {
+    SerialOut(Base, R_UART_IER, 0);
+    Ring->Active = FALSE;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Take bytes from receive ring.
+
+  @param  Base    The base address register of UART device.
+  @param  Ring    Receive ring.
+  @param  Buffer  Pointer to destination data buffer.
+  @param  Bytes   Number of bytes to take at most.
+
+  @return Number of bytes taken.
+**/
+UINTN
+ReadRxRing(
+  UINTN           Base,
+  SERIAL_RX_RING  *Ring,
+  UINT8           *Buffer,
+  UINTN           Bytes
+  )
+{
+  UINT8 *Data;
+  UINT32 Head;
+  UINT32 Tail;
+  UINTN Result;
+
+  Data = (UINT8 *) (Ring + 1);
+  Head = Ring->Head;
+  Tail = Ring->Tail;
+  MemoryFence(); // Head is read before data it covers
+
+  for (Result = 0; Result < Bytes && Tail != Head; Result++) {
+    *Buffer++ = Data[Tail++ & (Ring->Size - 1)];
+  }
+
+  MemoryFence(); // Data is taken before producer sees new Tail
+  Ring->Tail = Tail;
+
+  //
+  // Only handler drops RTS, above high watermark, which ring cannot reach
+  // again before this write lands.
+  //
+  if (Result != 0 && PcdGetBool(PcdSerialUseHardwareFlowControl) &&
+    Ring->Head - Tail <= (Ring->Size >> 2)) {
+    SerialOut(Base, R_UART_MCR, GetMcr(Ring, TRUE));
+  }
+
+  return Result;
+}
+
+/**
+  Move queued bytes to transmit FIFO, if it is empty. Flow control lines are
+  checked once per FIFO fill.
+
+  @param  Base  The base address register of UART device.
+  @param  Ring  Transmit ring.
+**/
+VOID
+FillTxFifo(
+  UINTN           Base,
+  SERIAL_TX_RING  *Ring
+  )
+{
+  UINT8 *Data;
+  UINTN Index;
+  UINTN FifoSize;
+
+  if (Ring->Head == Ring->Tail ||
+    (SerialIn(Base, R_UART_LSR) & B_UART_LSR_TXRDY) == 0 ||
+    !SerialPortIsWritable(Base)) {
+    return;
+  }
+
+  Data = (UINT8 *) (Ring + 1);
+  FifoSize = GetTxFifoSize();
+  for (Index = 0; Index < FifoSize && Ring->Tail != Ring->Head; Index++) {
+    SerialOut(Base, R_UART_TXBUF, Data[Ring->Tail++ & (Ring->Size - 1)]);
+  }
+}
+
+/**
+  Move bytes queued by SerialPortWrite() to serial device.
+
+  @param Wait   FALSE to move only what device can take right away, TRUE to
+                return once every queued byte is transmitted.
+**/
+VOID
+EFIAPI
+SerialPortDrain(
+  IN BOOLEAN Wait
+  )
+{
+  SERIAL_TX_RING *Ring;
+  UINTN Base;
+
+  Base = GetSerialRegisterBase();
+  if (Base == 0) {
+    return;
+  }
+
+  Ring = GetTxRing();
+  if (Ring != NULL) {
+    FillTxFifo(Base, Ring);
+    while (Wait && Ring->Head != Ring->Tail) {
+      SerialPortWaitTxEmpty(Base);
+      FillTxFifo(Base, Ring);
+    }
+  }
+
+  if (Wait) {
+    SerialPortFlush(Base);
+  }
+}
+
 /**
   Initialize the serial device hardware.
 
@@ -214,6 +591,8 @@ RETURN_STATUS
 EFIAPI
 SerialPortInitialize(VOID)
 {
+  SERIAL_TX_RING *Ring;
+  SERIAL_RX_RING *RxRing;
   UINTN   Base;
   UINT32  Div;
   UINT32  DivRem;
@@ -242,8 +621,10 @@ SerialPortInitialize(VOID)
     LineCtl = B_UART_LCR_8N1; // Make it default
   }
 
+  RxRing = InitRxRing();
+
   SerialOut(Base, R_UART_IER, 0);
-  SerialOut(Base, R_UART_MCR, B_UART_MCRVAL);
+  SerialOut(Base, R_UART_MCR, GetMcr(RxRing, TRUE));
   SerialOut(Base, R_UART_FCR, B_UART_FCRVAL);
   //
   // Set line control and enable access to DLL/DLM registers via DLAB bit.
@@ -253,6 +634,11 @@ SerialPortInitialize(VOID)
   SerialOut(Base, R_UART_DLM, (Div >> 8) & 0xff);
   SerialOut(Base, R_UART_LCR, LineCtl);
 
+  Ring = GetTxRing();
+  if (Ring != NULL) {
+    Ring->Tail = Ring->Head; // Drop what is left from previous boot
+  }
+
   return Base;
 }
 
@@ -272,6 +658,8 @@ SerialPortWrite(
   IN UINTN  Bytes
   )
 {
+  SERIAL_TX_RING *Ring;
+  UINT8 *Data;
   UINTN Base;
   UINTN Result;
   UINTN Index;
@@ -287,35 +675,41 @@ SerialPortWrite(
   }
 
   if (Bytes == 0) {
-    SerialPortFlush(Base);
+    SerialPortDrain(TRUE);
     return 0;
   }
 
-  //
-  // Compute the maximum size of the Tx FIFO
-  //
-  FifoSize = 1;
-  if ((PcdGet8(PcdSerialFifoControl) & B_UART_FCR_FIFOE) != 0) {
-    if ((PcdGet8(PcdSerialFifoControl) & B_UART_FCR_FIFO64) == 0) {
-      FifoSize = 16;
-    } else {
-      FifoSize = PcdGet32(PcdSerialExtendedTxFifoSize);
+  Result = Bytes;
+  Ring = GetTxRing();
+  if (Ring == NULL) {
+    FifoSize = GetTxFifoSize();
+    while (Bytes != 0) {
+      //
+      // Refill entire Tx FIFO as soon as it is empty
+      //
+      SerialPortWaitTxEmpty(Base);
+      SerialPortWaitWritable(Base);
+      for (Index = 0; Index < FifoSize && Bytes != 0; Index++, Bytes--) {
+        SerialOut(Base, R_UART_TXBUF, *Buffer++);
+      }
     }
+
+    return Result;
   }
 
-  Result = Bytes;
+  Data = (UINT8 *) (Ring + 1);
   while (Bytes != 0) {
-    SerialPortFlush(Base);
-
-    //
-    // Fill entire Tx FIFO
-    //
-    for (Index = 0; Index < FifoSize && Bytes != 0; Index++, Bytes--) {
-      SerialPortWaitWritable(Base);
-      SerialOut(Base, R_UART_TXBUF, *Buffer++);
+    if (Ring->Head - Ring->Tail == Ring->Size) {
+      SerialPortWaitTxEmpty(Base); // Ring is full, make room for the rest
+      FillTxFifo(Base, Ring);
+      continue;
     }
+
+    Data[Ring->Head++ & (Ring->Size - 1)] = *Buffer++;
+    Bytes--;
   }
 
+  FillTxFifo(Base, Ring);
   return Result;
 }
 
@@ -335,6 +729,7 @@ SerialPortRead (
   IN  UINTN  Bytes
   )
 {
+  SERIAL_RX_RING *Ring;
   UINTN  Base;
   UINTN  Result;
   UINT8  Mcr;
@@ -348,6 +743,15 @@ SerialPortRead (
     return 0;
   }
 
+  Ring = GetActiveRxRing();
+  if (Ring != NULL) {
+    for (Result = 0; Result < Bytes; ) {
+      Result += ReadRxRing(Base, Ring, Buffer + Result, Bytes - Result);
+    }
+
+    return Result;
+  }
+
   Mcr = SerialIn(Base, R_UART_MCR) & ~B_UART_MCR_RTS;
 
   for (Result = 0; Bytes-- != 0; Result++) {
@@ -378,3 +782,42 @@ SerialPortRead (
 
   return Result;
 }
+
+/**
+  Polls a serial device to see if there is any data waiting to be read.
+
+  @retval TRUE    Data is waiting to be read from the serial device.
+  @retval FALSE   There is no data waiting to be read from the serial device.
+**/
+BOOLEAN
+EFIAPI
+SerialPortPoll(VOID)
+{
+  SERIAL_RX_RING *Ring;
+  UINTN Base;
+  UINT8 Mcr;
+
+  Ring = GetActiveRxRing();
+  if (Ring != NULL) {
+    return Ring->Head != Ring->Tail;
+  }
+
+  Base = GetSerialRegisterBase();
+  if (Base == 0) {
+    return FALSE;
+  }
+
+  if ((SerialIn(Base, R_UART_LSR) & B_UART_LSR_RXRDY) != 0) {
+    return TRUE;
+  }
+
+  if (PcdGetBool(PcdSerialUseHardwareFlowControl)) {
+    //
+    // Set RTS to let the peer send some data
+    //
+    Mcr = SerialIn(Base, R_UART_MCR);
+    SerialOut(Base, R_UART_MCR, (UINT8) (Mcr | B_UART_MCR_RTS));
+  }
+
+  return FALSE;
+}
@@ -0,0 +1,525 @@
+/** @file
+  Minimalist virtio-mmio console driver.
+
+  Probes virtio-mmio transports for console device and sets up port 0
+  transmit queue in temporary RAM (PcdVirtioConsoleRamBase/Size). Every
+  SerialPortWrite() call is copied to a queue buffer and posted as a single
+  descriptor, so the device is notified once per buffer instead of trapping
+  on every byte. Both legacy (version 1) and modern (version 2) transports
+  are supported. Device that still runs the queue of an earlier
+  SerialPortInitialize() is kept as is, buffers in flight are not lost.
+
+  Temporary RAM layout, offsets are page aligned as legacy transport needs:
+
+    0x0000  descriptor table and available ring
+    0x1000  used ring
+    0x1800  driver state
+    0x2000  data buffers, one per descriptor
+
+  Input is not supported, the console is meant for logging only.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <Base.h>
+#include <Library/SerialPortLib.h>
+#include <Library/SerialPortExtLib.h>
+#include <Library/PcdLib.h>
+#include <Library/IoLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+
+//
+// virtio-mmio register offsets, see Virtual I/O Device (VIRTIO) 1.1, 4.2.2
+//
+#define R_VIRTIO_MAGIC              0x000
+#define R_VIRTIO_VERSION            0x004
+#define R_VIRTIO_DEVICE_ID          0x008
+#define R_VIRTIO_DRIVER_FEATURES    0x020
+#define R_VIRTIO_DRIVER_FEATURES_SEL 0x024
+#define R_VIRTIO_GUEST_PAGE_SIZE    0x028 // Legacy only
+#define R_VIRTIO_QUEUE_SEL          0x030
+#define R_VIRTIO_QUEUE_NUM_MAX      0x034
+#define R_VIRTIO_QUEUE_NUM          0x038
+#define R_VIRTIO_QUEUE_ALIGN        0x03c // Legacy only
+#define R_VIRTIO_QUEUE_PFN          0x040 // Legacy only
+#define R_VIRTIO_QUEUE_READY        0x044
+#define R_VIRTIO_QUEUE_NOTIFY       0x050
+#define R_VIRTIO_INTERRUPT_STATUS   0x060
+#define R_VIRTIO_INTERRUPT_ACK      0x064
+#define R_VIRTIO_STATUS             0x070
+#define R_VIRTIO_QUEUE_DESC_LOW     0x080
+#define R_VIRTIO_QUEUE_DESC_HIGH    0x084
+#define R_VIRTIO_QUEUE_AVAIL_LOW    0x090
+#define R_VIRTIO_QUEUE_AVAIL_HIGH   0x094
+#define R_VIRTIO_QUEUE_USED_LOW     0x0a0
+#define R_VIRTIO_QUEUE_USED_HIGH    0x0a4
+
+#define VIRTIO_MAGIC                SIGNATURE_32('v', 'i', 'r', 't')
+#define VIRTIO_DEVICE_ID_CONSOLE    3
+
+#define B_VIRTIO_STATUS_ACK         BIT0
+#define B_VIRTIO_STATUS_DRIVER      BIT1
+#define B_VIRTIO_STATUS_DRIVER_OK   BIT2
+#define B_VIRTIO_STATUS_FEATURES_OK BIT3
+#define B_VIRTIO_STATUS_NEEDS_RESET BIT6
+#define B_VIRTIO_STATUS_FAILED      BIT7
+
+#define B_VIRTIO_F_VERSION_1        BIT0 // Feature bit 32, selector 1
+
+#define VIRTIO_CONSOLE_TX_QUEUE     1 // Port 0 transmitq
+
+#define VRING_AVAIL_F_NO_INTERRUPT  BIT0
+#define VRING_USED_F_NO_NOTIFY      BIT0
+
+#define VQ_SIZE                     8 // Power of 2
+#define VQ_PAGE_SIZE                0x1000
+#define VQ_USED_OFFSET              0x1000
+#define VQ_STATE_OFFSET             0x1800
+#define VQ_BUFFER_OFFSET            0x2000
+
+typedef struct {
+  UINT64 Addr;
+  UINT32 Len;
+  UINT16 Flags;
+  UINT16 Next;
+} VRING_DESC;
+
+typedef struct {
+  UINT16 Flags;
+  UINT16 Idx;
+  UINT16 Ring[VQ_SIZE];
+} VRING_AVAIL;
+
+typedef struct {
+  UINT32 Id;
+  UINT32 Len;
+} VRING_USED_ELEM;
+
+typedef struct {
+  volatile UINT16 Flags;
+  volatile UINT16 Idx;
+  VRING_USED_ELEM Ring[VQ_SIZE];
+} VRING_USED;
+
+#define VIRTIO_CONSOLE_SIGNATURE SIGNATURE_32('V', 'C', 'O', 'N')
+
+typedef struct {
+  UINT32 Signature;
+  UINT32 Transport; // MMIO base of console transport
+  UINT32 BufferSize; // Bytes per descriptor buffer
+  UINT16 AvailIdx; // Free running, descriptors posted
+  UINT16 QueueSize; // Descriptors in queue
+} VIRTIO_CONSOLE;
+
+#define VQ_RAM_BASE FixedPcdGet32(PcdVirtioConsoleRamBase)
+#define VQ_RAM_SIZE FixedPcdGet32(PcdVirtioConsoleRamSize)
+
+STATIC_ASSERT (
+  VQ_SIZE * sizeof(VRING_DESC) + sizeof(VRING_AVAIL) <= VQ_USED_OFFSET,
+  "Available ring overlaps used ring"
+  );
+
+/**
+  Driver state in temporary RAM.
+
+  @return Initialized driver state, NULL if console is not set up.
+**/
+STATIC
+VIRTIO_CONSOLE *
+GetConsole(VOID)
+{
+  VIRTIO_CONSOLE *Console;
+
+  if (VQ_RAM_SIZE <= VQ_BUFFER_OFFSET) {
+    return NULL;
+  }
+
+  Console = (VIRTIO_CONSOLE *) (VQ_RAM_BASE + VQ_STATE_OFFSET);
+  if (Console->Signature != VIRTIO_CONSOLE_SIGNATURE) {
+    return NULL;
+  }
+
+  return Console;
+}
+
+/**
+  Find first virtio-mmio transport with console device behind it.
+
+  @return MMIO base of the transport, 0 if there is none.
+**/
+STATIC
+UINTN
+FindTransport(VOID)
+{
+  UINTN Base;
+  UINT32 Index;
+
+  Base = FixedPcdGet32(PcdVirtioMmioBase);
+  for (Index = 0; Index < FixedPcdGet32(PcdVirtioMmioCount); Index++) {
+    if (MmioRead32(Base + R_VIRTIO_MAGIC) == VIRTIO_MAGIC &&
+        MmioRead32(Base + R_VIRTIO_DEVICE_ID) == VIRTIO_DEVICE_ID_CONSOLE) {
+      return Base;
+    }
+
+    Base += FixedPcdGet32(PcdVirtioMmioStride);
+  }
+
+  return 0;
+}
+
+/**
+  Number of descriptors device has not returned yet.
+
+  @param  Console   Driver state.
+
+  @return Descriptors in flight.
+**/
+STATIC
+UINT16
+GetPending(
+  IN VIRTIO_CONSOLE *Console
+  )
+{
+  VRING_USED *Used;
+
+  Used = (VRING_USED *) (VQ_RAM_BASE + VQ_USED_OFFSET);
+  return (UINT16) (Console->AvailIdx - Used->Idx);
+}
+
+/**
+  Set up port 0 transmit queue of console device.
+
+  @param  Base      MMIO base of console transport.
+  @param  Version   Transport version.
+
+  @retval TRUE      Queue is set up and device is live.
+  @retval FALSE     Device rejected features or has no such queue.
+**/
+STATIC
+BOOLEAN
+SetupQueue(
+  IN UINTN  Base,
+  IN UINT32 Version
+  )
+{
+  VRING_DESC *Desc;
+  VRING_AVAIL *Avail;
+  UINTN Used;
+  UINT32 Status;
+  UINT32 Index;
+
+  Status = B_VIRTIO_STATUS_ACK | B_VIRTIO_STATUS_DRIVER;
+  MmioWrite32(Base + R_VIRTIO_STATUS, 0); // Reset, drops queue of previous boot
+  MmioWrite32(Base + R_VIRTIO_STATUS, B_VIRTIO_STATUS_ACK);
+  MmioWrite32(Base + R_VIRTIO_STATUS, Status);
+
+  if (Version >= 2) {
+    MmioWrite32(Base + R_VIRTIO_DRIVER_FEATURES_SEL, 1);
+    MmioWrite32(Base + R_VIRTIO_DRIVER_FEATURES, B_VIRTIO_F_VERSION_1);
+    MmioWrite32(Base + R_VIRTIO_DRIVER_FEATURES_SEL, 0);
+    MmioWrite32(Base + R_VIRTIO_DRIVER_FEATURES, 0);
+    Status |= B_VIRTIO_STATUS_FEATURES_OK;
+    MmioWrite32(Base + R_VIRTIO_STATUS, Status);
+    if ((MmioRead32(Base + R_VIRTIO_STATUS) & B_VIRTIO_STATUS_FEATURES_OK) == 0) {
+      return FALSE;
+    }
+  } else {
+    MmioWrite32(Base + R_VIRTIO_DRIVER_FEATURES, 0);
+    MmioWrite32(Base + R_VIRTIO_GUEST_PAGE_SIZE, VQ_PAGE_SIZE);
+  }
+
+  MmioWrite32(Base + R_VIRTIO_QUEUE_SEL, VIRTIO_CONSOLE_TX_QUEUE);
+  if (MmioRead32(Base + R_VIRTIO_QUEUE_NUM_MAX) < VQ_SIZE) {
+    return FALSE;
+  }
+
+  ZeroMem((VOID *) VQ_RAM_BASE, VQ_BUFFER_OFFSET);
+
+  //
+  // Buffers never move, only descriptor lengths change on write
+  //
+  Desc = (VRING_DESC *) VQ_RAM_BASE;
+  for (Index = 0; Index < VQ_SIZE; Index++) {
+    Desc[Index].Addr = VQ_RAM_BASE + VQ_BUFFER_OFFSET +
+      Index * ((VQ_RAM_SIZE - VQ_BUFFER_OFFSET) / VQ_SIZE);
+  }
+
+  Avail = (VRING_AVAIL *) (Desc + VQ_SIZE);
+  Avail->Flags = VRING_AVAIL_F_NO_INTERRUPT; // Used ring is polled
+  Used = VQ_RAM_BASE + VQ_USED_OFFSET;
+
+  MmioWrite32(Base + R_VIRTIO_QUEUE_NUM, VQ_SIZE);
+  if (Version >= 2) {
+    MmioWrite32(Base + R_VIRTIO_QUEUE_DESC_LOW, (UINT32) (UINTN) Desc);
+    MmioWrite32(Base + R_VIRTIO_QUEUE_DESC_HIGH, 0);
+    MmioWrite32(Base + R_VIRTIO_QUEUE_AVAIL_LOW, (UINT32) (UINTN) Avail);
+    MmioWrite32(Base + R_VIRTIO_QUEUE_AVAIL_HIGH, 0);
+    MmioWrite32(Base + R_VIRTIO_QUEUE_USED_LOW, (UINT32) Used);
+    MmioWrite32(Base + R_VIRTIO_QUEUE_USED_HIGH, 0);
+    MmioWrite32(Base + R_VIRTIO_QUEUE_READY, 1);
+  } else {
+    MmioWrite32(Base + R_VIRTIO_QUEUE_ALIGN, VQ_USED_OFFSET);
+    MmioWrite32(Base + R_VIRTIO_QUEUE_PFN, VQ_RAM_BASE / VQ_PAGE_SIZE);
+  }
+
+  MmioWrite32(Base + R_VIRTIO_STATUS, Status | B_VIRTIO_STATUS_DRIVER_OK);
+  return TRUE;
+}
+
+/**
+  Check whether console device still runs the queue an earlier
+  SerialPortInitialize() set up, with the same layout.
+
+  @param  Console   Driver state with valid signature.
+
+  @retval TRUE      Device is live, queue can be used as is.
+  @retval FALSE     Device has to be reset and queue set up again.
+**/
+STATIC
+BOOLEAN
+IsQueueLive(
+  IN VIRTIO_CONSOLE *Console
+  )
+{
+  VRING_DESC *Desc;
+  VRING_AVAIL *Avail;
+  UINTN Base;
+  UINT32 Status;
+
+  Desc = (VRING_DESC *) VQ_RAM_BASE;
+  Avail = (VRING_AVAIL *) (Desc + VQ_SIZE);
+  if (Console->QueueSize != VQ_SIZE ||
+    Console->BufferSize != (VQ_RAM_SIZE - VQ_BUFFER_OFFSET) / VQ_SIZE ||
+    Desc[0].Addr != VQ_RAM_BASE + VQ_BUFFER_OFFSET ||
+    Avail->Idx != Console->AvailIdx) {
+    return FALSE;
+  }
+
+  Base = FindTransport();
+  if (Base == 0 || Base != Console->Transport) {
+    return FALSE;
+  }
+
+  Status = MmioRead32(Base + R_VIRTIO_STATUS);
+  if ((Status & (B_VIRTIO_STATUS_DRIVER_OK | B_VIRTIO_STATUS_NEEDS_RESET |
+    B_VIRTIO_STATUS_FAILED)) != B_VIRTIO_STATUS_DRIVER_OK) {
+    return FALSE;
+  }
+
+  //
+  // Queue addresses are write only on modern transport, ready is what can
+  // be read back
+  //
+  MmioWrite32(Base + R_VIRTIO_QUEUE_SEL, VIRTIO_CONSOLE_TX_QUEUE);
+  if (MmioRead32(Base + R_VIRTIO_VERSION) >= 2) {
+    return MmioRead32(Base + R_VIRTIO_QUEUE_READY) != 0;
+  }
+
+  return MmioRead32(Base + R_VIRTIO_QUEUE_PFN) == VQ_RAM_BASE / VQ_PAGE_SIZE;
+}
+
+/**
+  Wait until device returns posted buffers.
+
+  @param Wait   FALSE to return right away, TRUE to return once every posted
+                buffer is consumed by device.
+**/
+VOID
+EFIAPI
+SerialPortDrain(
+  IN BOOLEAN Wait
+  )
+{
+  VIRTIO_CONSOLE *Console;
+
+  Console = GetConsole();
+  if (Console == NULL || !Wait) {
+    return;
+  }
+
+  while (GetPending(Console) != 0) {
+  }
+}
+
+/**
+  Acknowledge console device interrupt. Used ring is polled, so there is
+  nothing else to do.
+**/
+VOID
+EFIAPI
+SerialPortInterruptHandler(VOID)
+{
+  VIRTIO_CONSOLE *Console;
+  UINT32 Status;
+
+  Console = GetConsole();
+  if (Console == NULL) {
+    return;
+  }
+
+  Status = MmioRead32(Console->Transport + R_VIRTIO_INTERRUPT_STATUS);
+  MmioWrite32(Console->Transport + R_VIRTIO_INTERRUPT_ACK, Status);
+}
+
+/**
+  Console input is not supported, there is nothing to receive.
+**/
+EFI_STATUS
+EFIAPI
+SerialPortEnableRxInterrupt(
+  IN BOOLEAN Enable
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Initialize the serial device hardware.
+
+  @retval RETURN_SUCCESS        The serial device was initialized.
+  @retval RETURN_DEVICE_ERROR   The serial device could not be initialized.
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortInitialize(VOID)
+{
+  VIRTIO_CONSOLE *Console;
+  UINTN Base;
+  UINT32 Version;
+
+  if (VQ_RAM_SIZE <= VQ_BUFFER_OFFSET) {
+    return RETURN_DEVICE_ERROR;
+  }
+
+  Console = (VIRTIO_CONSOLE *) (VQ_RAM_BASE + VQ_STATE_OFFSET);
+  if (Console->Signature == VIRTIO_CONSOLE_SIGNATURE && IsQueueLive(Console)) {
+    return RETURN_SUCCESS;
+  }
+
+  Console->Signature = 0;
+
+  Base = FindTransport();
+  if (Base == 0) {
+    return RETURN_DEVICE_ERROR;
+  }
+
+  Version = MmioRead32(Base + R_VIRTIO_VERSION);
+  if (!SetupQueue(Base, Version)) {
+    MmioWrite32(Base + R_VIRTIO_STATUS, 0);
+    return RETURN_DEVICE_ERROR;
+  }
+
+  Console->Transport = Base;
+  Console->BufferSize = (VQ_RAM_SIZE - VQ_BUFFER_OFFSET) / VQ_SIZE;
+  Console->AvailIdx = 0;
+  Console->QueueSize = VQ_SIZE;
+  Console->Signature = VIRTIO_CONSOLE_SIGNATURE;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Write data from buffer to serial device.
+
+  @param  Buffer  Pointer to source data buffer.
+  @param  Bytes   Number of bytes to write.
+
+  @retval =0      No data has been written or operation has failed.
+  @retval >0      The number of written bytes.
+**/
+UINTN
+EFIAPI
+SerialPortWrite(
+  IN UINT8  *Buffer,
+  IN UINTN  Bytes
+  )
+{
+  VIRTIO_CONSOLE *Console;
+  VRING_DESC *Desc;
+  VRING_AVAIL *Avail;
+  VRING_USED *Used;
+  UINTN Result;
+  UINT32 Size;
+  UINT16 Slot;
+
+  if (Buffer == NULL) {
+    return 0;
+  }
+
+  Console = GetConsole();
+  if (Console == NULL) {
+    return 0;
+  }
+
+  if (Bytes == 0) {
+    SerialPortDrain(TRUE);
+    return 0;
+  }
+
+  Desc = (VRING_DESC *) VQ_RAM_BASE;
+  Avail = (VRING_AVAIL *) (Desc + VQ_SIZE);
+  Used = (VRING_USED *) (VQ_RAM_BASE + VQ_USED_OFFSET);
+
+  Result = Bytes;
+  while (Bytes != 0) {
+    //
+    // Descriptor is reused only after device returned it
+    //
+    while (GetPending(Console) == VQ_SIZE) {
+    }
+
+    Size = (UINT32) MIN(Bytes, Console->BufferSize);
+    Slot = Console->AvailIdx & (VQ_SIZE - 1);
+    CopyMem((VOID *) (UINTN) Desc[Slot].Addr, Buffer, Size);
+    Desc[Slot].Len = Size;
+    Avail->Ring[Slot] = Slot;
+
+    MemoryFence(); // Descriptor before index
+    Avail->Idx = ++Console->AvailIdx;
+    MemoryFence(); // Index before notify check
+
+    if ((Used->Flags & VRING_USED_F_NO_NOTIFY) == 0) {
+      MmioWrite32(Console->Transport + R_VIRTIO_QUEUE_NOTIFY,
+        VIRTIO_CONSOLE_TX_QUEUE);
+    }
+
+    Buffer += Size;
+    Bytes -= Size;
+  }
+
+  return Result;
+}
+
+/**
+  Reads data from serial device into buffer. Console input is not supported.
+
+  @param  Buffer   Pointer to destination data buffer.
+  @param  Bytes    Number of bytes to read from the serial device.
+
+  @retval 0        No data has been read.
+**/
+UINTN
+EFIAPI
+SerialPortRead (
+  OUT UINT8  *Buffer,
+  IN  UINTN  Bytes
+  )
+{
+  return 0;
+}
+
+/**
+  Polls a serial device to see if there is any data waiting to be read.
+
+  @retval FALSE   Console input is not supported.
+**/
+BOOLEAN
+EFIAPI
+SerialPortPoll(VOID)
+{
+  return FALSE;
+}
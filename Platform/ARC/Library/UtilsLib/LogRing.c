@@ -0,0 +1,131 @@
+/** @file
+  Binary log ring.
+
+  LOG() records are appended to a ring in temporary RAM instead of being
+  formatted and written to serial port, see LOG_RING in UtilsLib.h. Ring is
+  shared by SEC and PEI core and is set up by whoever logs first.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <UtilsLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PcdLib.h>
+
+#define LOG_RING_BASE FixedPcdGet32(PcdLogRingBase)
+#define LOG_RING_SIZE FixedPcdGet32(PcdLogRingSize)
+
+#define LOG_DUMP_WORDS 8
+
+STATIC
+LOG_RING *
+GetLogRing(VOID)
+{
+  LOG_RING *Ring;
+  UINT32 Size;
+
+  if (LOG_RING_SIZE <= sizeof(LOG_RING)) {
+    return NULL;
+  }
+
+  Ring = (LOG_RING *) LOG_RING_BASE;
+  Size = (LOG_RING_SIZE - sizeof(LOG_RING)) & ~3U;
+
+  if (Ring->Signature != LOG_RING_SIGNATURE || Ring->Size != Size ||
+    Ring->Head > Size) {
+    Ring->Signature = LOG_RING_SIGNATURE;
+    Ring->Size = Size;
+    Ring->Head = 0;
+    Ring->Lap = 0;
+  }
+
+  return Ring;
+}
+
+VOID
+LogWrite(
+  IN CONST VOID *Site,
+  IN CONST UINTN *Args,
+  IN UINT8 ArgCount
+  )
+{
+  LOG_RING *Ring;
+  UINT32 *Data;
+  UINT32 Size;
+  UINT8 Idx;
+
+  Ring = GetLogRing();
+  Size = (2 + ArgCount) * sizeof(UINT32);
+  if (Ring == NULL || ArgCount > LOG_MAX_ARGS || Size > Ring->Size) {
+    return;
+  }
+
+  Data = (UINT32 *) (Ring + 1);
+
+  //
+  // Records are never split, the rest of the area is skipped instead
+  //
+  if (Ring->Head + Size > Ring->Size) {
+    if (Ring->Head < Ring->Size) {
+      Data[Ring->Head >> 2] = 0;
+    }
+    Ring->Head = 0;
+    Ring->Lap++;
+  }
+
+  Data += Ring->Head >> 2;
+  Data[0] = LOG_RECORD_MAGIC | ArgCount;
+  Data[1] = (UINT32) (UINTN) Site;
+  for (Idx = 0; Idx < ArgCount; Idx++) {
+    Data[2 + Idx] = (UINT32) Args[Idx];
+  }
+
+  Ring->Head += Size;
+}
+
+VOID
+DumpWords(
+  IN CONST CHAR8 Tag[4],
+  IN CONST UINT32 *Words,
+  IN UINTN Count
+  )
+{
+  CONST UINT32 *Word;
+  CONST UINT32 *End;
+  CHAR8 Str[sizeof("@log") + LOG_DUMP_WORDS * sizeof(" 01234567")];
+  UINTN Len;
+  UINT8 Idx;
+
+  Word = Words;
+  End = Words + Count;
+  while (Word < End) {
+    CopyMem(Str, Tag, 4);
+    Len = 4;
+    for (Idx = 0; Idx < LOG_DUMP_WORDS && Word < End; Idx++, Word++) {
+      Str[Len++] = ' ';
+      ByteToAscii(*Word >> 24, &Str[Len]);
+      ByteToAscii(*Word >> 16, &Str[Len + 2]);
+      ByteToAscii(*Word >> 8, &Str[Len + 4]);
+      ByteToAscii(*Word, &Str[Len + 6]);
+      Len += 8;
+    }
+    Str[Len++] = '\n';
+    SerialPortWrite((UINT8 *) Str, Len);
+  }
+}
+
+VOID
+LogDump(VOID)
+{
+  CONST LOG_RING *Ring;
+
+  Ring = GetLogRing();
+  if (Ring != NULL) {
+    DumpWords("@log", (CONST UINT32 *) Ring,
+      (sizeof(*Ring) + Ring->Size) / sizeof(UINT32));
+  }
+}
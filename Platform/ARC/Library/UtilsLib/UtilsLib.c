@@ -8,11 +8,9 @@
   Released under the BSD-2-Clause License
 **/
 
-#ifdef VERBOSE_FV_IO
-#undef VERBOSE
-#endif
-
 #include <UtilsLib.h>
+#include <Library/BaseLib.h>
+#include <Library/PcdLib.h>
 #include <IndustryStandard/PeImage.h>
 
 VOID
@@ -168,7 +166,7 @@ FindSection(
   while (Addr < SectionsEnd) {
     Section = (EFI_COMMON_SECTION_HEADER *) (UINTN) Addr;
     Size = SECTION_SIZE(Section);
-    DBG("| Section %p size 0x%x type 0x%x\n", Section, Size, Section->Type);
+    TRACE("| Section %p size 0x%x type 0x%x\n", Section, Size, Section->Type);
     if (Size < sizeof(*Section)) {
       SET_STATUS_INFO(StatusInfo, EFI_VOLUME_CORRUPTED);
       return NULL;
@@ -191,40 +189,287 @@ FindSection(
   return NULL;
 }
 
-VOID *
-GetFileSection(
+/**
+  Position cursor at first file of volume, or right after given file.
+
+  @param Cursor   Cursor to initialize.
+  @param FvBase   Firmware volume header.
+  @param File     File to resume after, NULL to start from the beginning.
+
+**/
+VOID
+InitFfsCursor(
+  OUT FFS_CURSOR *Cursor,
+  IN VOID *FvBase,
+  IN CONST EFI_FFS_FILE_HEADER *File OPTIONAL
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER *Fv;
+
+  Fv = (EFI_FIRMWARE_VOLUME_HEADER *) FvBase;
+  Cursor->Eov = ToPhysAddr(Fv) + Fv->FvLength;
+
+  if (File == NULL) {
+    Cursor->Addr = AlignAddr(ToPhysAddr(Fv) + Fv->HeaderLength, 8);
+  } else {
+    Cursor->Addr = AlignAddr(ToPhysAddr((VOID *) File) + FFS_FILE_SIZE(File),
+      8);
+  }
+}
+
+//
+// Header of erased flash reads as all ones. Headers are 8-byte aligned, so
+// they are checked word by word.
+//
+STATIC
+BOOLEAN
+IsErasedHeader(
+  IN CONST EFI_FFS_FILE_HEADER *File
+  )
+{
+  CONST UINT32 *Word;
+  UINT8 Idx;
+
+  Word = (CONST UINT32 *) File;
+  for (Idx = 0; Idx < sizeof(*File) / sizeof(*Word); Idx++) {
+    if (Word[Idx] != MAX_UINT32) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Get file under cursor and advance cursor to the next one.
+
+  @param Cursor       Cursor set up by InitFfsCursor().
+  @param StatusInfo   EFI_NOT_FOUND at the end of files, EFI_VOLUME_CORRUPTED
+                      when file does not fit the volume.
+
+  @return File header, or NULL when there are no more files.
+
+**/
+EFI_FFS_FILE_HEADER *
+NextFfsFile(
+  IN OUT FFS_CURSOR *Cursor,
+  OUT STATUS_INFO *StatusInfo OPTIONAL
+  )
+{
+  EFI_FFS_FILE_HEADER *File;
+  EFI_PHYSICAL_ADDRESS Eof; // End of file
+
+  while (Cursor->Addr + sizeof(*File) <= Cursor->Eov) {
+    File = (EFI_FFS_FILE_HEADER *) (UINTN) Cursor->Addr;
+    if (IsErasedHeader(File)) {
+      break;
+    }
+
+    Eof = Cursor->Addr + FFS_FILE_SIZE(File);
+    if (FFS_FILE_SIZE(File) < sizeof(*File) || Eof > Cursor->Eov) {
+      SET_STATUS_INFO(StatusInfo, EFI_VOLUME_CORRUPTED);
+      return NULL;
+    }
+
+    Cursor->Addr = AlignAddr(Eof, 8);
+    if (File->Type != EFI_FV_FILETYPE_FFS_PAD) {
+      SET_STATUS_INFO(StatusInfo, EFI_SUCCESS);
+      return File;
+    }
+  }
+
+  Cursor->Addr = Cursor->Eov;
+  SET_STATUS_INFO(StatusInfo, EFI_NOT_FOUND);
+  return NULL;
+}
+
+FFS_INDEX_HEADER *
+GetFfsIndex(
+  IN VOID *FvBase
+  )
+{
+  FFS_CURSOR Cursor;
+  EFI_FFS_FILE_HEADER *File;
+  FFS_INDEX_HEADER *Index;
+  UINT8 Depth;
+  CONST EFI_GUID FileName = FFS_INDEX_FILE_GUID;
+
+  InitFfsCursor(&Cursor, FvBase, NULL);
+
+  //
+  // The index is never far from the volume header, so only a few files are
+  // checked instead of walking the whole volume.
+  //
+  for (Depth = 0; Depth < FFS_INDEX_SEARCH_DEPTH; Depth++) {
+    File = NextFfsFile(&Cursor, NULL);
+    if (File == NULL) {
+      break;
+    }
+
+    if (File->Type == EFI_FV_FILETYPE_FREEFORM &&
+      CompareGuids(&FileName, &File->Name)) {
+      Index = FindSection(EFI_SECTION_RAW, ToPhysAddr(File + 1),
+        ToPhysAddr(File) + FFS_FILE_SIZE(File), NULL);
+      if (Index == NULL) {
+        return NULL;
+      }
+
+      Index = (FFS_INDEX_HEADER *) ((EFI_COMMON_SECTION_HEADER *) Index + 1);
+      if (Index->Signature != FFS_INDEX_SIGNATURE || Index->Count == 0) {
+        return NULL;
+      }
+
+      return Index;
+    }
+  }
+
+  return NULL;
+}
+
+STATIC
+INTN
+CompareIndexKey(
+  IN CONST FFS_INDEX_ENTRY *Entry,
+  IN EFI_FV_FILETYPE FileType,
+  IN CONST EFI_GUID *FileName OPTIONAL
+  )
+{
+  CONST UINT8 *Name1;
+  CONST UINT8 *Name2;
+  UINT8 Idx;
+
+  if (Entry->Type != FileType || FileName == NULL) {
+    return (INTN) Entry->Type - (INTN) FileType;
+  }
+
+  Name1 = (CONST UINT8 *) &Entry->Name;
+  Name2 = (CONST UINT8 *) FileName;
+
+  for (Idx = 0; Idx < sizeof(EFI_GUID); Idx++) {
+    if (Name1[Idx] != Name2[Idx]) {
+      return (INTN) Name1[Idx] - (INTN) Name2[Idx];
+    }
+  }
+
+  return 0;
+}
+
+EFI_FFS_FILE_HEADER *
+FindIndexedFile(
+  IN VOID *FvBase,
+  IN CONST FFS_INDEX_HEADER *Index,
+  IN EFI_FV_FILETYPE FileType,
+  IN CONST EFI_GUID *FileName OPTIONAL
+  )
+{
+  CONST FFS_INDEX_ENTRY *Entries;
+  UINTN Low;
+  UINTN High;
+  UINTN Mid;
+  UINT32 Offset;
+
+  Entries = (CONST FFS_INDEX_ENTRY *) (Index + 1);
+  Low = 0;
+  High = Index->Count;
+
+  //
+  // Find the lower bound of (FileType, FileName), or of FileType alone when
+  // no name is given.
+  //
+  while (Low < High) {
+    Mid = Low + ((High - Low) >> 1);
+    if (CompareIndexKey(&Entries[Mid], FileType, FileName) < 0) {
+      Low = Mid + 1;
+    } else {
+      High = Mid;
+    }
+  }
+
+  if (Low >= Index->Count ||
+    CompareIndexKey(&Entries[Low], FileType, FileName) != 0) {
+    return NULL;
+  }
+
+  //
+  // Without a name the linear walk returns the first file of given type, so
+  // pick the lowest offset among same type entries to keep that behaviour.
+  //
+  Offset = Entries[Low].Offset;
+  if (FileName == NULL) {
+    for (Mid = Low + 1; Mid < Index->Count; Mid++) {
+      if (Entries[Mid].Type != FileType) {
+        break;
+      } else if (Entries[Mid].Offset < Offset) {
+        Offset = Entries[Mid].Offset;
+      }
+    }
+  }
+
+  if (Offset >= ((EFI_FIRMWARE_VOLUME_HEADER *) FvBase)->FvLength) {
+    return NULL;
+  }
+
+  return (EFI_FFS_FILE_HEADER *) (FvBase + Offset);
+}
+
+/**
+  Find file of given type, and name if provided, using FFS index when volume
+  has one, or walking volume files otherwise.
+
+  @param FvBase       Firmware volume header.
+  @param FileType     File type to look for.
+  @param FileName     File name, NULL to take first file of given type.
+  @param StatusInfo   EFI_NOT_FOUND or EFI_VOLUME_CORRUPTED on failure.
+
+  @return File header, or NULL if file is not found.
+
+**/
+EFI_FFS_FILE_HEADER *
+FindFfsFile(
   IN VOID *FvBase,
-  IN EFI_SECTION_TYPE SectionType,
   IN EFI_FV_FILETYPE FileType,
   IN CONST EFI_GUID *FileName OPTIONAL,
   OUT STATUS_INFO *StatusInfo OPTIONAL
   )
 {
   EFI_FIRMWARE_VOLUME_HEADER *Fv;
-  EFI_PHYSICAL_ADDRESS Addr; // Address iterator
   EFI_PHYSICAL_ADDRESS Eov; // End of volume
-  EFI_PHYSICAL_ADDRESS Eof; // End of file
   EFI_FFS_FILE_HEADER *File;
-  GUID_STR GuidStr;
-  VOID *Image;
+  FFS_INDEX_HEADER *Index;
+  FFS_CURSOR Cursor;
+  STATUS_INFO WalkStatus;
   BOOLEAN FileNameOk;
 
   Fv = (EFI_FIRMWARE_VOLUME_HEADER *) FvBase;
   Eov = ToPhysAddr(Fv) + Fv->FvLength;
-  Addr = AlignAddr(ToPhysAddr(Fv) + Fv->HeaderLength, 8);
-
-  while (Addr < Eov) {
-    File = (EFI_FFS_FILE_HEADER *) (UINTN) Addr;
-    Eof = Addr + FFS_FILE_SIZE(File);
 
-    GuidToAsciiStr(&File->Name, &GuidStr);
-    DBG("| Check file at %p type 0x%x name %a\n", File, File->Type, GuidStr.Data);
+  Index = GetFfsIndex(FvBase);
+  if (Index != NULL) {
+    File = FindIndexedFile(FvBase, Index, FileType, FileName);
+    if (File == NULL) {
+      SET_STATUS_INFO(StatusInfo, EFI_NOT_FOUND);
+      return NULL;
+    }
 
-    if (Eof > Eov) { // Sanity check
+    if (ToPhysAddr(File) + FFS_FILE_SIZE(File) > Eov) { // Sanity check
       SET_STATUS_INFO(StatusInfo, EFI_VOLUME_CORRUPTED);
       return NULL;
     }
 
+    TRACE("| Indexed file at %p type 0x%x\n", File, File->Type);
+    SET_STATUS_INFO(StatusInfo, EFI_SUCCESS);
+    return File;
+  }
+
+  //
+  // No index in this volume, fall back to header by header walk.
+  //
+  InitFfsCursor(&Cursor, FvBase, NULL);
+
+  while ((File = NextFfsFile(&Cursor, &WalkStatus)) != NULL) {
+    TRACE("| Check file at %p type 0x%x name %g\n", File, File->Type,
+      &File->Name);
+
     if (!FileName) {
       FileNameOk = TRUE;
     } else {
@@ -232,37 +477,66 @@ GetFileSection(
     }
 
     if (FileNameOk && File->Type == FileType) {
-      return FindSection(SectionType, ToPhysAddr(File + 1), Eof, StatusInfo);
+      SET_STATUS_INFO(StatusInfo, EFI_SUCCESS);
+      return File;
     }
-
-    Addr = AlignAddr(Eof, 8);
   }
 
-  SET_STATUS_INFO(StatusInfo, EFI_NOT_FOUND);
+  SET_STATUS_INFO(StatusInfo, WalkStatus.Status);
   return NULL;
 }
 
 VOID *
-GetTeEntryPoint(
+GetFileSection(
   IN VOID *FvBase,
+  IN EFI_SECTION_TYPE SectionType,
   IN EFI_FV_FILETYPE FileType,
   IN CONST EFI_GUID *FileName OPTIONAL,
   OUT STATUS_INFO *StatusInfo OPTIONAL
   )
+{
+  EFI_FFS_FILE_HEADER *File;
+
+  File = FindFfsFile(FvBase, FileType, FileName, StatusInfo);
+  if (File == NULL) {
+    return NULL;
+  }
+
+  return FindSection(SectionType, ToPhysAddr(File + 1),
+    ToPhysAddr(File) + FFS_FILE_SIZE(File), StatusInfo);
+}
+
+VOID *
+GetTeSectionEntryPoint(
+  IN EFI_COMMON_SECTION_HEADER *Section
+  )
 {
   VOID *Ptr;
   EFI_TE_IMAGE_HEADER *TeHdr;
 
+  Ptr = Section + 1;
+  TeHdr = (EFI_TE_IMAGE_HEADER *) Ptr;
+  Ptr -= TeHdr->StrippedSize;
+  Ptr += sizeof(*TeHdr) + TeHdr->AddressOfEntryPoint & 0xffffffff;
+  return Ptr;
+}
+
+VOID *
+GetTeEntryPoint(
+  IN VOID *FvBase,
+  IN EFI_FV_FILETYPE FileType,
+  IN CONST EFI_GUID *FileName OPTIONAL,
+  OUT STATUS_INFO *StatusInfo OPTIONAL
+  )
+{
+  VOID *Ptr;
+
   Ptr = GetFileSection(FvBase, EFI_SECTION_TE, FileType, FileName, StatusInfo);
   if (Ptr == NULL) {
     return NULL;
-  } else {
-    Ptr += sizeof(EFI_COMMON_SECTION_HEADER);
-    TeHdr = (EFI_TE_IMAGE_HEADER *) Ptr;
-    Ptr -= TeHdr->StrippedSize;
-    Ptr += sizeof(*TeHdr) + TeHdr->AddressOfEntryPoint & 0xffffffff;
-    return Ptr;
   }
+
+  return GetTeSectionEntryPoint(Ptr);
 }
 
 PEI_APRIORI_FILE_CONTENTS *
@@ -287,3 +561,59 @@ GetAprioriFile(
 
   return Ptr;
 }
+
+CONST BOOT_MANIFEST_HEADER *
+GetBootManifest(
+  IN VOID *Base
+  )
+{
+  CONST BOOT_MANIFEST_HEADER *Manifest;
+
+  Manifest = (CONST BOOT_MANIFEST_HEADER *) Base;
+  if (Manifest->Signature != BOOT_MANIFEST_SIGNATURE ||
+    Manifest->Revision != BOOT_MANIFEST_REVISION) {
+    return NULL;
+  }
+
+  //
+  // Size is checked against the region before the checksum reads it all
+  //
+  if (Manifest->Size > FixedPcdGet32(PcdBootManifestSize) ||
+    Manifest->Size != sizeof(*Manifest) +
+    Manifest->Count * sizeof(BOOT_MANIFEST_ENTRY)) {
+    return NULL;
+  }
+
+  //
+  // Manifest is generated after the FD is built, so a stale one is caught
+  // here and callers fall back to walking firmware volumes.
+  //
+  if (CalculateSum32((UINT32 *) Manifest, Manifest->Size) != 0) {
+    return NULL;
+  }
+
+  return Manifest;
+}
+
+CONST BOOT_MANIFEST_ENTRY *
+FindManifestEntry(
+  IN CONST BOOT_MANIFEST_HEADER *Manifest,
+  IN EFI_FV_FILETYPE FileType,
+  IN CONST EFI_GUID *FileName OPTIONAL
+  )
+{
+  CONST BOOT_MANIFEST_ENTRY *Entry;
+  UINT16 Idx;
+
+  Entry = BOOT_MANIFEST_ENTRIES(Manifest);
+
+  for (Idx = 0; Idx < Manifest->Count; Idx++, Entry++) {
+    if (Entry->Type != FileType) {
+      continue;
+    } else if (FileName == NULL || CompareGuids(FileName, &Entry->FileName)) {
+      return Entry;
+    }
+  }
+
+  return NULL;
+}
@@ -0,0 +1,273 @@
+#!/usr/bin/env python3
+#
+# Deterministic boot time benchmark on QEMU.
+#
+# Boots FD image headless under qemu-system-arc -icount a number of times and
+# picks "@phs" boot phase markers written by PerfPhase() from console output
+# (build with -D BOOT_PHASE_MARKERS=TRUE). Markers carry performance counter
+# value each phase started at. With -icount every instruction advances
+# virtual clock by 2^shift ns, and ARC timers count virtual time, so counter
+# deltas translate to instruction counts which do not change from run to run.
+# Wall time is taken on host when marker lines arrive and is informative only.
+#
+# Results are written as JSON. Given a baseline written by an earlier run,
+# instruction counts of each phase are compared against it and the script
+# exits with 2 if any phase grew by more than threshold percent.
+#
+# Usage:
+#   boot-bench.py [options] <image.fd> <kernel> [-- <extra qemu args>]
+#
+#   --runs <n>          number of boots (default 5)
+#   --shift <n>         -icount shift (default 0)
+#   --timer-hz <hz>     timer clock of QEMU CPU model (default 50000000, same
+#                       as PcdArcTimerFrequency)
+#   --timeout <s>       time given to a boot to reach DXE core (default 60)
+#   --baseline <file>   compare against baseline JSON
+#   --threshold <pct>   allowed instruction count growth (default 1.0)
+#   --save <file>       write results as new baseline
+#   --qemu <path>       QEMU binary (default qemu-system-arc)
+#   --virtio-console    read markers from virtio console instead of UART, for
+#                       images built with -D VIRTIO_CONSOLE=TRUE
+#
+#   kernel   ELF32 ARC binary given to -kernel, see build-qemu-fd.sh
+#            make-kernel
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import json
+import os
+import select
+import statistics
+import subprocess
+import sys
+import time
+
+# BOOT_PHASE_* in Platform/ARC/Include/Library/BootPerfLib.h
+BOOT_PHASES = ('sec', 'pei', 'dxe-ipl', 'dxe')
+PHASE_TAG = '@phs '
+
+OPTIONS = {
+    '--runs': ('runs', int, 5),
+    '--shift': ('shift', int, 0),
+    '--timer-hz': ('timer_hz', int, 50000000),
+    '--timeout': ('timeout', float, 60.0),
+    '--baseline': ('baseline', str, None),
+    '--threshold': ('threshold', float, 1.0),
+    '--save': ('save', str, None),
+    '--qemu': ('qemu', str, 'qemu-system-arc'),
+}
+
+FLAGS = {
+    '--virtio-console': 'virtio_console',
+}
+
+UART_CONSOLE = ['-serial', 'stdio']
+VIRTIO_CONSOLE = ['-serial', 'null', '-device', 'virtio-serial-device',
+                  '-device', 'virtconsole,chardev=con0',
+                  '-chardev', 'stdio,id=con0']
+
+
+def parse_args(argv):
+    opts = {name: default for (name, _, default) in OPTIONS.values()}
+    opts.update({name: False for name in FLAGS.values()})
+    args = []
+    extra = []
+    idx = 1
+    while idx < len(argv):
+        arg = argv[idx]
+        if arg == '--':
+            extra = argv[idx + 1:]
+            break
+        if arg in FLAGS:
+            opts[FLAGS[arg]] = True
+            idx += 1
+            continue
+        if arg in OPTIONS:
+            if idx + 1 == len(argv):
+                raise ValueError('%s needs a value' % arg)
+            (name, conv, _) = OPTIONS[arg]
+            opts[name] = conv(argv[idx + 1])
+            idx += 2
+            continue
+        args.append(arg)
+        idx += 1
+    return opts, args, extra
+
+
+def parse_marker(line):
+    """(phase, ticks) of marker line, None for other lines."""
+    pos = line.find(PHASE_TAG)
+    if pos < 0:
+        return None
+    words = line[pos + len(PHASE_TAG):].split()
+    if len(words) != 3:
+        return None
+    try:
+        phase, high, low = [int(word, 16) for word in words]
+    except ValueError:
+        return None
+    if phase >= len(BOOT_PHASES):
+        return None
+    return phase, (high << 32) | low
+
+
+def boot(opts, fd, kernel, extra):
+    """Marker (ticks, host seconds since QEMU start) by phase name."""
+    cmd = [opts['qemu'], '-M', 'virt', '-m', '4G', '-display', 'none',
+           '-monitor', 'none', '-icount', 'shift=%u,sleep=off' % opts['shift'],
+           '-kernel', kernel, '-bios', fd]
+    cmd += VIRTIO_CONSOLE if opts['virtio_console'] else UART_CONSOLE
+    cmd += extra
+
+    markers = {}
+    start = time.monotonic()
+    proc = subprocess.Popen(cmd, stdin=subprocess.DEVNULL,
+                            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    try:
+        pending = b''
+        deadline = start + opts['timeout']
+        while BOOT_PHASES[-1] not in markers:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                break
+            ready, _, _ = select.select([proc.stdout], [], [], remaining)
+            if not ready:
+                break
+            chunk = os.read(proc.stdout.fileno(), 4096)
+            if not chunk:
+                break
+            now = time.monotonic() - start
+            pending += chunk
+            *lines, pending = pending.split(b'\n')
+            for line in lines:
+                marker = parse_marker(line.decode(errors='replace'))
+                if marker is not None:
+                    markers[BOOT_PHASES[marker[0]]] = (marker[1], now)
+    finally:
+        proc.kill()
+        proc.wait()
+
+    missing = [phase for phase in BOOT_PHASES if phase not in markers]
+    if missing:
+        raise RuntimeError('no %s marker within %.0f s, is FD built with '
+                           'BOOT_PHASE_MARKERS=TRUE?' % (', '.join(missing),
+                                                         opts['timeout']))
+    return markers
+
+
+def phase_costs(opts, markers):
+    """Instructions and wall seconds of each phase, up to the next marker."""
+    costs = {}
+    for (idx, phase) in enumerate(BOOT_PHASES[:-1]):
+        (ticks, wall) = markers[phase]
+        (next_ticks, next_wall) = markers[BOOT_PHASES[idx + 1]]
+        costs[phase] = (to_instructions(opts, next_ticks - ticks),
+                        next_wall - wall)
+    (first_ticks, first_wall) = markers[BOOT_PHASES[0]]
+    (last_ticks, last_wall) = markers[BOOT_PHASES[-1]]
+    costs['total'] = (to_instructions(opts, last_ticks - first_ticks),
+                      last_wall)
+    return costs
+
+
+def to_instructions(opts, ticks):
+    return ticks * 1000000000 // (opts['timer_hz'] << opts['shift'])
+
+
+def summarize(opts, fd, runs):
+    phases = {}
+    deterministic = True
+    for phase in runs[0]:
+        insns = [run[phase][0] for run in runs]
+        wall = [run[phase][1] * 1000.0 for run in runs]
+        deterministic = deterministic and min(insns) == max(insns)
+        phases[phase] = {
+            'instructions': int(statistics.median(insns)),
+            'instructions_min': min(insns),
+            'instructions_max': max(insns),
+            'wall_ms': round(statistics.median(wall), 3),
+            'wall_ms_min': round(min(wall), 3),
+            'wall_ms_max': round(max(wall), 3),
+        }
+    return {
+        'image': os.path.basename(fd),
+        'runs': len(runs),
+        'icount_shift': opts['shift'],
+        'timer_hz': opts['timer_hz'],
+        'deterministic': deterministic,
+        'phases': phases,
+    }
+
+
+def compare(result, baseline, threshold):
+    """Add comparison to result, return names of regressed phases."""
+    regressed = []
+    comparison = {}
+    for (phase, now) in result['phases'].items():
+        before = baseline.get('phases', {}).get(phase)
+        if before is None or before['instructions'] == 0:
+            continue
+        delta = now['instructions'] - before['instructions']
+        pct = 100.0 * delta / before['instructions']
+        comparison[phase] = {
+            'instructions_base': before['instructions'],
+            'instructions_delta': delta,
+            'instructions_pct': round(pct, 3),
+            'wall_ms_base': before['wall_ms'],
+            'wall_ms_delta': round(now['wall_ms'] - before['wall_ms'], 3),
+        }
+        if pct > threshold:
+            regressed.append(phase)
+    result['baseline'] = comparison
+    result['regressed'] = regressed
+    return regressed
+
+
+def main(argv):
+    opts, args, extra = parse_args(argv)
+    if len(args) != 2 or opts['runs'] < 1:
+        print('Usage: %s [options] <image.fd> <kernel> '
+              '[-- <extra qemu args>]' % argv[0])
+        return 1
+
+    (fd, kernel) = args
+    runs = []
+    for run in range(opts['runs']):
+        markers = boot(opts, fd, kernel, extra)
+        runs.append(phase_costs(opts, markers))
+        print('| run %u: %u instructions, %.1f ms' % (
+            run + 1, runs[-1]['total'][0], runs[-1]['total'][1] * 1000.0),
+            file=sys.stderr)
+
+    result = summarize(opts, fd, runs)
+    if not result['deterministic']:
+        print('! instruction counts differ between runs', file=sys.stderr)
+
+    regressed = []
+    if opts['baseline'] is not None:
+        with open(opts['baseline']) as f:
+            regressed = compare(result, json.load(f), opts['threshold'])
+
+    if opts['save'] is not None:
+        with open(opts['save'], 'w') as f:
+            json.dump(result, f, indent=2)
+            f.write('\n')
+
+    json.dump(result, sys.stdout, indent=2)
+    print()
+
+    if regressed:
+        print('! %s grew by more than %.2f%%' % (', '.join(regressed),
+                                                opts['threshold']),
+              file=sys.stderr)
+        return 2
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+#
+# Boot manifest generator.
+#
+# Collects entry points, image bases and fixups of SEC, PEI core and PEIM
+# images from a built FD and writes them into the boot manifest region, so
+# SEC and PEI core do not have to search firmware volumes at runtime. Layout
+# matches BOOT_MANIFEST_HEADER in Platform/ARC/Include/Library/UtilsLib.h.
+#
+# PEIMs are stored in dispatch order: apriori PEIMs first, then the rest in
+# volume order, with every PEIM moved after PEIMs producing PPIs its DEPEX
+# refers to. Producers come from INF files listed in FDF, so without --fdf
+# option only apriori and volume order is kept.
+#
+# Usage:
+#   boot-manifest.py [--fdf <file.fdf>] <image.fd> <offset> <size> [fd-base]
+#
+#   offset   manifest region offset within FD (PcdBootManifestBase)
+#   size     manifest region size
+#   fd-base  address FD is visible at during boot (default 0)
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import heapq
+import struct
+import sys
+
+import fvlib
+import inflib
+
+BOOT_MANIFEST_SIGNATURE = b'BMFT'
+BOOT_MANIFEST_REVISION = 4
+BOOT_MANIFEST_HEADER = '<4sHHII'
+BOOT_MANIFEST_ENTRY = '<16sIIIIIBBH'
+BOOT_MANIFEST_HAS_FIXUP = 0x01
+
+APRIORI_FILE_GUID = fvlib.guid_bytes('1b45cc0a-156a-428a-af62-49864da0e6e6')
+
+# Dependency expression opcodes, see MdePkg/Include/Pi/PiDependency.h
+DEP_PUSH = 0x02
+DEP_END = 0x08
+
+IMAGE_TYPES = (
+    fvlib.FV_FILETYPE_SECURITY_CORE,
+    fvlib.FV_FILETYPE_PEI_CORE,
+    fvlib.FV_FILETYPE_PEIM,
+)
+
+
+class Image:
+    def __init__(self, file_, fd_base):
+        self.file = file_
+        self.name = file_.name
+        self.type = file_.type
+
+        te = file_.section(fvlib.SECTION_TE)
+        if te is None:
+            raise ValueError('no TE section in %s' % file_.guid)
+
+        (sig, _, _, _, stripped, entry, _, _) = struct.unpack_from(
+            fvlib.TE_HEADER_FORMAT, te.fd, te.data_offset)
+        if sig != b'VZ':
+            raise ValueError('bad TE signature in %s' % file_.guid)
+
+        # Same math as GetTeEntryPoint() in UtilsLib.c
+        image_base = (fd_base + te.data_offset + fvlib.TE_HEADER_SIZE -
+                      stripped)
+        self.entry_point = image_base + entry
+        # PEI core matches PPI descriptors to images by file range, as
+        # AddPeimFile() does. TE image base lies up to the stripped header
+        # size before the file, i.e. in the previous one.
+        self.file_base = fd_base + file_.offset
+        self.file_size = file_.size
+
+        # Same as CalcPeiFixup()/CalcPeimFixup() used to compute at runtime
+        fixup = file_.section(fvlib.SECTION_FREEFORM_SUBTYPE_GUID)
+        self.flags = 0
+        self.fixup = 0
+        if fixup is not None:
+            self.flags |= BOOT_MANIFEST_HAS_FIXUP
+            self.fixup = fd_base + fixup.offset
+
+        depex = file_.section(fvlib.SECTION_PEI_DEPEX)
+        self.depex = 0
+        self.depex_size = 0
+        self.depends = []
+        if depex is not None:
+            self.depex = fd_base + depex.data_offset
+            self.depex_size = len(depex.data)
+            self.depends = depex_guids(depex.data)
+
+    def pack(self):
+        return struct.pack(BOOT_MANIFEST_ENTRY, self.name, self.entry_point,
+                           self.file_base, self.file_size,
+                           self.fixup & 0xffffffff,
+                           self.depex, self.type, self.flags, self.depex_size)
+
+
+def depex_guids(data):
+    guids = []
+    pos = 0
+    while pos < len(data) and data[pos] != DEP_END:
+        if data[pos] == DEP_PUSH:
+            guids.append(bytes(data[pos + 1:pos + 17]))
+            pos += 17
+        else:
+            pos += 1
+    return guids
+
+
+def ppi_producers(fdf):
+    """Map of PPI GUID bytes to file names of PEIMs producing them."""
+    producers = {}
+    for path in inflib.fv_inf_paths(fdf, ['BootFv']):
+        full = inflib.find_file(path)
+        if full is None:
+            raise ValueError('failed to find %s' % path)
+        inf = inflib.Inf(full)
+        if inf.module_type != 'PEIM' or inf.file_guid is None:
+            continue
+        guids = inflib.package_guids(inf)
+        for cname in inf.produced_ppis():
+            if cname not in guids:
+                raise ValueError('failed to find %s GUID for %s' % (cname, path))
+            producers.setdefault(guids[cname], set()).add(
+                fvlib.guid_bytes(inf.file_guid))
+    return producers
+
+
+def apriori_order(fv):
+    file_ = fv.find(APRIORI_FILE_GUID, fvlib.FV_FILETYPE_FREEFORM)
+    if file_ is None:
+        return []
+    data = file_.section(fvlib.SECTION_RAW).data
+    return [bytes(data[i:i + 16]) for i in range(0, len(data) - 15, 16)]
+
+
+def dispatch_order(peims, apriori):
+    """Apriori PEIMs first in listed order, the rest in volume order."""
+    by_name = {img.name: img for img in peims}
+    first = [by_name[name] for name in apriori if name in by_name]
+    return first + [img for img in peims if img not in first]
+
+
+def topological_order(peims, producers):
+    """Stable topological sort: among PEIMs whose producers are already
+    placed, the one earliest in given order goes first."""
+    index = {img.name: idx for idx, img in enumerate(peims)}
+    waiters = [[] for _ in peims]
+    pending = [0] * len(peims)
+
+    for idx, img in enumerate(peims):
+        deps = set()
+        for guid in img.depends:
+            deps |= {index[name] for name in producers.get(guid, ())
+                     if name in index and name != img.name}
+        pending[idx] = len(deps)
+        for dep in deps:
+            waiters[dep].append(idx)
+
+    ready = [idx for idx in range(len(peims)) if pending[idx] == 0]
+    heapq.heapify(ready)
+    order = []
+    while ready:
+        idx = heapq.heappop(ready)
+        order.append(peims[idx])
+        for waiter in waiters[idx]:
+            pending[waiter] -= 1
+            if pending[waiter] == 0:
+                heapq.heappush(ready, waiter)
+
+    # PEIMs in dependency cycles keep original order, dispatcher evaluates
+    # their DEPEX at runtime anyway
+    cycle = [img for img in peims if img not in order]
+    for img in cycle:
+        print('! %s is in dependency cycle' % img.file.guid, file=sys.stderr)
+    return order + cycle
+
+
+def collect(fd, fd_base, producers):
+    cores = []
+    peims = []
+    apriori = []
+
+    for fv in fvlib.volumes(fd):
+        apriori += apriori_order(fv)
+        for file_ in fv.files():
+            if file_.type not in IMAGE_TYPES:
+                continue
+            img = Image(file_, fd_base)
+            if img.type == fvlib.FV_FILETYPE_PEIM:
+                peims.append(img)
+            else:
+                cores.append(img)
+
+    cores.sort(key=lambda img: img.type)  # SEC before PEI core
+    return cores + topological_order(dispatch_order(peims, apriori), producers)
+
+
+def build_manifest(images):
+    entries = b''.join(img.pack() for img in images)
+    size = struct.calcsize(BOOT_MANIFEST_HEADER) + len(entries)
+    hdr = struct.pack(BOOT_MANIFEST_HEADER, BOOT_MANIFEST_SIGNATURE,
+                      BOOT_MANIFEST_REVISION, len(images), size, 0)
+    raw = hdr + entries
+
+    # Checksum makes 32-bit sum of the whole manifest zero, see
+    # CalculateSum32() check in GetBootManifest()
+    total = sum(struct.unpack('<%uI' % (size // 4), raw)) & 0xffffffff
+    checksum = (0x100000000 - total) & 0xffffffff
+    return raw[:12] + struct.pack('<I', checksum) + raw[16:]
+
+
+def main(argv):
+    producers = {}
+    if len(argv) > 2 and argv[1] == '--fdf':
+        producers = ppi_producers(argv[2])
+        argv = argv[:1] + argv[3:]
+
+    if len(argv) < 4:
+        print('Usage: %s [--fdf <file.fdf>] <image.fd> <offset> <size> '
+              '[fd-base]' % argv[0])
+        return 1
+
+    path = argv[1]
+    offset = int(argv[2], 0)
+    size = int(argv[3], 0)
+    fd_base = int(argv[4], 0) if len(argv) > 4 else 0
+
+    fd = fvlib.load(path)
+    images = collect(fd, fd_base, producers)
+    raw = build_manifest(images)
+    if len(raw) > size:
+        raise ValueError('manifest %u bytes does not fit %u' % (len(raw), size))
+    if offset + size > len(fd):
+        raise ValueError('manifest region is outside of %s' % path)
+
+    fd[offset:offset + size] = raw + b'\xff' * (size - len(raw))
+    fvlib.save(path, fd)
+
+    for img in images:
+        print('| %s type 0x%02x entry 0x%08x file 0x%08x fixup 0x%08x '
+              'depex 0x%08x' % (img.file.guid, img.type, img.entry_point,
+                                img.file_base, img.fixup, img.depex))
+    print('> %s: manifest with %u entries at 0x%x' % (path, len(images), offset))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -3,15 +3,18 @@
 set -e
 
 workspace_=$HOME/tmp/edk2
+scripts_=$(dirname $(readlink -f $0))
 numthreads_=$(getconf _NPROCESSORS_ONLN)
 
 gen_target_txt()
 {
 	local tools_in=../edk2-arc/Platform/ARC/snps-tools.txt
 	local tools_out=Conf/snps-tools.txt
+	local logfmt_in=../edk2-arc/Platform/ARC/LogFmt.lds
 
 	cat BaseTools/Conf/tools_def.template > $tools_out
 	cat $tools_in >> $tools_out
+	cp $logfmt_in $WORKSPACE/LogFmt.lds
 
 	cat > Conf/target.txt << EOF
 ACTIVE_PLATFORM = EmulatorPkg/EmulatorPkg.dsc
@@ -64,6 +67,36 @@ build_target()
 	printf "\033[1;32m>\033[0m done $WORKSPACE/Build\n"
 }
 
+make_ffs_index()
+{
+	local capacity=64
+
+	python3 $scripts_/fv-index.py placeholder $WORKSPACE/FfsIndex.raw $capacity
+}
+
+patch_ffs_index()
+{
+	python3 $scripts_/fv-index.py patch $@
+}
+
+pei_capacity()
+{
+	python3 $scripts_/pei-capacity.py $scripts_/../Platform/ARC/Hs4x/Hs4x.fdf $1
+}
+
+relocate_xip()
+{
+	# FD is visible at 0 during boot, keep in sync with make_boot_manifest
+	python3 $scripts_/xip-relocate.py $1 0
+}
+
+make_boot_manifest()
+{
+	# Keep in sync with BOOT_MANIFEST_OFFSET/SIZE in Hs4x.fdf
+	python3 $scripts_/boot-manifest.py \
+		--fdf $scripts_/../Platform/ARC/Hs4x/Hs4x.fdf $1 0x80000 0x1000
+}
+
 setup_build_env()
 {
 	. $workspace_/venv/bin/activate
@@ -87,7 +120,14 @@ setup_build_env
 case $1 in
 build-fd)
 	gen_target_txt
-	build_target -b DEBUG -t GCC -a ARC2 -p Platform/ARC/Hs4x/Hs4x.dsc
+	make_ffs_index
+	build_target -b DEBUG -t GCC -a ARC2 -p Platform/ARC/Hs4x/Hs4x.dsc \
+		-D PEI_PPI_CAPACITY=$(pei_capacity ppis) \
+		-D PEI_NOTIFY_CAPACITY=$(pei_capacity notifies) \
+		-D PEI_PEIM_CAPACITY=$(pei_capacity peims)
+	patch_ffs_index $WORKSPACE/Build/hs4x/DEBUG_GCC/FV/QEMU-ARC.fd
+	relocate_xip $WORKSPACE/Build/hs4x/DEBUG_GCC/FV/QEMU-ARC.fd
+	make_boot_manifest $WORKSPACE/Build/hs4x/DEBUG_GCC/FV/QEMU-ARC.fd
 	;;
 make-tools)
 	make -C BaseTools/Source/C
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+#
+# Cache maintenance benchmark report.
+#
+# Reads "@cbn" lines written by CacheBench PEIM (build with
+# -D CACHE_BENCH=TRUE) from console output and prints cycles per KiB taken
+# by range and whole cache operations for each measured size, along with the
+# smallest size whole cache operation is as fast as range one at. That size
+# is the value for PcdArcCacheFlushThreshold. Layout matches
+# CACHE_BENCH_HEADER and CACHE_BENCH_RESULT in
+# Platform/ARC/Library/CacheBench/CacheBench.c.
+#
+# Usage:
+#   cache-bench.py <boot.log> [cpu-hz]
+#
+#   cpu-hz   CPU clock, default is performance counter frequency, which is
+#            CPU clock with RTC or TIMER1 as counter
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import struct
+import sys
+
+CACHE_BENCH_SIGNATURE = b'CBNC'
+CACHE_BENCH_HEADER = '<4sII'
+CACHE_BENCH_RESULT = '<IIII'
+
+# Order matches mOps in CacheBench.c
+OPS = (
+    'WriteBackDataCache',
+    'WriteBackInvalidateDataCache',
+    'InvalidateInstructionCache',
+)
+
+
+def load(path):
+    """Counter frequency and (op, size, range ticks, whole ticks) results."""
+    words = []
+    with open(path, errors='replace') as f:
+        for line in f:
+            pos = line.find('@cbn ')
+            if pos >= 0:
+                words += [int(word, 16) for word in line[pos + 5:].split()]
+    raw = struct.pack('<%uI' % len(words), *words)
+
+    hdr_size = struct.calcsize(CACHE_BENCH_HEADER)
+    if len(raw) < hdr_size:
+        raise ValueError('no cache benchmark results in %s' % path)
+    sig, freq, count = struct.unpack_from(CACHE_BENCH_HEADER, raw)
+    if sig != CACHE_BENCH_SIGNATURE:
+        raise ValueError('bad cache benchmark signature in %s' % path)
+
+    size = struct.calcsize(CACHE_BENCH_RESULT)
+    results = []
+    for pos in range(hdr_size, min(len(raw), hdr_size + count * size), size):
+        results.append(struct.unpack_from(CACHE_BENCH_RESULT, raw, pos))
+    if len(results) != count:
+        print('! %u of %u results' % (len(results), count), file=sys.stderr)
+    return freq, results
+
+
+def main(argv):
+    if len(argv) < 2:
+        print('Usage: %s <boot.log> [cpu-hz]' % argv[0])
+        return 1
+
+    freq, results = load(argv[1])
+    cpu_hz = int(argv[2], 0) if len(argv) > 2 else freq
+    scale = float(cpu_hz) / freq if freq else 1.0
+
+    for (idx, name) in enumerate(OPS):
+        rows = [result for result in results if result[0] == idx]
+        if not rows:
+            continue
+
+        print('%s (cycles per KiB):' % name)
+        print('  %10s %12s %12s' % ('KiB', 'range', 'whole'))
+        threshold = None
+        for (_, size, range_ticks, whole_ticks) in rows:
+            kib = size / 1024.0
+            print('  %10u %12.1f %12.1f' % (kib, scale * range_ticks / kib,
+                                            scale * whole_ticks / kib))
+            if threshold is None and whole_ticks <= range_ticks:
+                threshold = size
+        if threshold is None:
+            print('> range is faster up to %u KiB' % (rows[-1][1] // 1024))
+        else:
+            print('> whole cache from %u KiB, PcdArcCacheFlushThreshold|0x%x' %
+                  (threshold // 1024, threshold))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
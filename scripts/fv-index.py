@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+#
+# Build-time FFS file index generator.
+#
+# Every firmware volume that carries the index file (see FFS_INDEX_FILE_GUID in
+# Platform/ARC/Include/Library/UtilsLib.h) gets it filled with a table of
+# (type, name) -> offset entries sorted the same way UtilsLib searches them.
+#
+# Usage:
+#   fv-index.py placeholder <out.raw> <capacity>
+#   fv-index.py patch <image.fd|image.fv> [...]
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import struct
+import sys
+
+import fvlib
+
+FFS_INDEX_FILE_GUID = fvlib.guid_bytes('a608ac97-b87b-4d29-aa15-b0744a3181dd')
+FFS_INDEX_SIGNATURE = b'FFSX'
+FFS_INDEX_HEADER = '<4sHH'
+FFS_INDEX_ENTRY = '<16sIB3x'
+
+
+def make_placeholder(path, capacity):
+    raw = struct.pack(FFS_INDEX_HEADER, FFS_INDEX_SIGNATURE, 0, capacity)
+    raw += b'\0' * (struct.calcsize(FFS_INDEX_ENTRY) * capacity)
+    fvlib.save(path, raw)
+
+
+def patch_volume(fv):
+    index = fv.find(FFS_INDEX_FILE_GUID, fvlib.FV_FILETYPE_FREEFORM)
+    if index is None:
+        return False
+
+    sec = index.section(fvlib.SECTION_RAW)
+    sig, _, capacity = struct.unpack_from(FFS_INDEX_HEADER, fv.fd,
+                                          sec.data_offset)
+    if sig != FFS_INDEX_SIGNATURE:
+        raise ValueError('bad index signature in FV at 0x%x' % fv.offset)
+
+    entries = sorted((f.type, f.name, f.fv_offset) for f in fv.files()
+                     if f.type != fvlib.FV_FILETYPE_FFS_PAD)
+    if len(entries) > capacity:
+        raise ValueError('%u files do not fit index capacity %u' %
+                         (len(entries), capacity))
+
+    pos = sec.data_offset
+    struct.pack_into(FFS_INDEX_HEADER, fv.fd, pos, sig, len(entries), capacity)
+    pos += struct.calcsize(FFS_INDEX_HEADER)
+    for type_, name, offset in entries:
+        struct.pack_into(FFS_INDEX_ENTRY, fv.fd, pos, name, offset, type_)
+        pos += struct.calcsize(FFS_INDEX_ENTRY)
+
+    index.update_checksum()
+    print('| FV at 0x%x: indexed %u/%u files' %
+          (fv.offset, len(entries), capacity))
+    return True
+
+
+def patch(path):
+    fd = fvlib.load(path)
+    patched = [patch_volume(fv) for fv in fvlib.volumes(fd)]
+    if any(patched):
+        fvlib.save(path, fd)
+    print('> %s: %u of %u volumes indexed' % (path, sum(patched), len(patched)))
+
+
+def main(argv):
+    if len(argv) == 4 and argv[1] == 'placeholder':
+        make_placeholder(argv[2], int(argv[3], 0))
+    elif len(argv) >= 3 and argv[1] == 'patch':
+        for path in argv[2:]:
+            patch(path)
+    else:
+        print('Usage: %s placeholder <out.raw> <capacity>' % argv[0])
+        print('       %s patch <image.fd|image.fv> [...]' % argv[0])
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
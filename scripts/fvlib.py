@@ -0,0 +1,197 @@
+#
+# Minimal firmware volume parser shared by build helper scripts.
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import struct
+import uuid
+
+FVH_SIGNATURE = b'_FVH'
+FVH_SIGNATURE_OFFSET = 40
+FVH_FORMAT = '<16s16sQ4sIHHHxB'  # up to and including Revision
+
+FFS_HEADER_SIZE = 24
+FFS_HEADER2_SIZE = 32
+FFS_ATTRIB_LARGE_FILE = 0x01
+FFS_ATTRIB_CHECKSUM = 0x40
+FFS_FIXED_CHECKSUM = 0xaa
+
+FV_FILETYPE_RAW = 0x01
+FV_FILETYPE_FREEFORM = 0x02
+FV_FILETYPE_SECURITY_CORE = 0x03
+FV_FILETYPE_PEI_CORE = 0x04
+FV_FILETYPE_DXE_CORE = 0x05
+FV_FILETYPE_PEIM = 0x06
+FV_FILETYPE_FFS_PAD = 0xf0
+
+SECTION_PE32 = 0x10
+SECTION_TE = 0x12
+SECTION_PEI_DEPEX = 0x1b
+SECTION_FREEFORM_SUBTYPE_GUID = 0x18
+SECTION_RAW = 0x19
+
+SECTION_HEADER_SIZE = 4
+SECTION_HEADER2_SIZE = 8
+
+TE_HEADER_FORMAT = '<2sHBBHIIQ'  # Signature .. ImageBase
+TE_HEADER_SIZE = 40
+TE_IMAGE_BASE_OFFSET = 16
+TE_BASE_RELOC_OFFSET = 24  # DataDirectory[0], (VirtualAddress, Size)
+
+
+def align(val, bytes_):
+    return (val + bytes_ - 1) & ~(bytes_ - 1)
+
+
+def guid_str(raw):
+    return str(uuid.UUID(bytes_le=bytes(raw)))
+
+
+def guid_bytes(text):
+    return uuid.UUID(text).bytes_le
+
+
+class Section:
+    def __init__(self, fd, offset, type_, size, header_size):
+        self.fd = fd
+        self.offset = offset  # Section header offset within FD buffer
+        self.type = type_
+        self.size = size
+        self.data_offset = offset + header_size
+
+    @property
+    def data(self):
+        return self.fd[self.data_offset:self.offset + self.size]
+
+
+class File:
+    def __init__(self, fd, fv, offset):
+        self.fd = fd
+        self.fv = fv
+        self.offset = offset  # File header offset within FD buffer
+        hdr = fd[offset:offset + FFS_HEADER_SIZE]
+        self.name = bytes(hdr[0:16])
+        self.type = hdr[18]
+        self.attributes = hdr[19]
+        self.size = hdr[20] | hdr[21] << 8 | hdr[22] << 16
+        self.header_size = FFS_HEADER_SIZE
+        if self.attributes & FFS_ATTRIB_LARGE_FILE:
+            self.size, = struct.unpack_from('<Q', fd, offset + FFS_HEADER_SIZE)
+            self.header_size = FFS_HEADER2_SIZE
+
+    @property
+    def fv_offset(self):
+        return self.offset - self.fv.offset
+
+    @property
+    def guid(self):
+        return guid_str(self.name)
+
+    @property
+    def end(self):
+        return self.offset + self.size
+
+    def sections(self):
+        pos = align(self.offset + self.header_size, 4)
+        while pos + SECTION_HEADER_SIZE <= self.end:
+            size = self.fd[pos] | self.fd[pos + 1] << 8 | self.fd[pos + 2] << 16
+            type_ = self.fd[pos + 3]
+            header_size = SECTION_HEADER_SIZE
+            if size == 0xffffff:
+                size, = struct.unpack_from('<I', self.fd, pos + 4)
+                header_size = SECTION_HEADER2_SIZE
+            if size < header_size or pos + size > self.end:
+                raise ValueError('corrupted section at 0x%x' % pos)
+            yield Section(self.fd, pos, type_, size, header_size)
+            pos = align(pos + size, 4)
+
+    def section(self, type_):
+        for sec in self.sections():
+            if sec.type == type_:
+                return sec
+        return None
+
+    def update_checksum(self):
+        if self.attributes & FFS_ATTRIB_CHECKSUM:
+            data = self.fd[self.offset + self.header_size:self.end]
+            self.fd[self.offset + 17] = (0x100 - sum(data)) & 0xff
+        else:
+            self.fd[self.offset + 17] = FFS_FIXED_CHECKSUM
+
+
+class Volume:
+    def __init__(self, fd, offset):
+        self.fd = fd
+        self.offset = offset  # Volume header offset within FD buffer
+        (_, self.fs_guid, self.length, _, self.attributes, self.header_length,
+         _, _, self.revision) = struct.unpack_from(FVH_FORMAT, fd, offset)
+
+    @property
+    def end(self):
+        return self.offset + self.length
+
+    def files(self):
+        pos = align(self.offset + self.header_length, 8)
+        while pos + FFS_HEADER_SIZE <= self.end:
+            if self.fd[pos:pos + FFS_HEADER_SIZE] == b'\xff' * FFS_HEADER_SIZE:
+                break  # Erased free space
+            file_ = File(self.fd, self, pos)
+            if file_.size < file_.header_size or file_.end > self.end:
+                raise ValueError('corrupted file at 0x%x' % pos)
+            yield file_
+            pos = align(file_.end, 8)
+
+    def find(self, name=None, type_=None):
+        for file_ in self.files():
+            if name is not None and file_.name != name:
+                continue
+            if type_ is not None and file_.type != type_:
+                continue
+            return file_
+        return None
+
+
+def volumes(fd):
+    """Yield every firmware volume found in an FD or FV image."""
+    pos = fd.find(FVH_SIGNATURE, FVH_SIGNATURE_OFFSET)
+    while pos >= 0:
+        base = pos - FVH_SIGNATURE_OFFSET
+        if fd[base:base + 16] == b'\0' * 16:
+            fv = Volume(fd, base)
+            if fv.header_length >= 56 and base + fv.length <= len(fd):
+                yield fv
+                pos = fd.find(FVH_SIGNATURE, fv.end + FVH_SIGNATURE_OFFSET)
+                continue
+        pos = fd.find(FVH_SIGNATURE, pos + 1)
+
+
+def te_images(fd, fd_base):
+    """List of (image base, image end, file name) of TE images in FD, bases
+    are addresses image offsets are relative to when FD is at fd_base."""
+    images = []
+    for fv in volumes(fd):
+        for file_ in fv.files():
+            te = file_.section(SECTION_TE)
+            if te is None:
+                continue
+            (_, _, _, _, stripped, _, _, _) = struct.unpack_from(
+                TE_HEADER_FORMAT, te.fd, te.data_offset)
+            # Same math as GetTeEntryPoint() in UtilsLib.c
+            base = fd_base + te.data_offset + TE_HEADER_SIZE - stripped
+            images.append((base, fd_base + file_.end, file_.name))
+    return images
+
+
+def load(path):
+    with open(path, 'rb') as f:
+        return bytearray(f.read())
+
+
+def save(path, fd):
+    with open(path, 'wb') as f:
+        f.write(fd)
@@ -0,0 +1,800 @@
+/** @file
+  Host microbenchmarks for firmware volume parsing in UtilsLib and PEI core.
+
+  Builds synthetic firmware volumes of various sizes and section mixes (or
+  maps a real FD image read-only) and measures lookups done by UtilsLib.c
+  and PeiServices.c. Results are printed as JSON lines, one per measurement.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <HostShim.h>
+#include <UtilsLib.h>
+
+#define PAGE_SIZE_ 4096
+#define MAX_TARGETS 1024
+#define TARGET_NS 50000000ULL // Aim for ~50 ms per measurement
+#define MAX_SIZES 8
+
+typedef struct {
+  CONST CHAR8 *Name;
+  UINT8 Count;
+  EFI_SECTION_TYPE Types[4]; // Last one is looked up
+} SECTION_MIX;
+
+STATIC CONST SECTION_MIX mMixes[] = {
+  { "te", 2, { EFI_SECTION_TE, EFI_SECTION_USER_INTERFACE } },
+  { "pe32", 2, { EFI_SECTION_PE32, EFI_SECTION_USER_INTERFACE } },
+  { "raw-te", 4, {
+      EFI_SECTION_RAW, EFI_SECTION_RAW, EFI_SECTION_USER_INTERFACE,
+      EFI_SECTION_TE
+    }
+  },
+};
+
+typedef struct {
+  UINT8 *Base;
+  UINTN Size;
+  INT32 Prot; // Protection restored after page tracking
+  FFS_INDEX_HEADER *Index; // NULL for real images without index
+  UINTN FileCount;
+  EFI_FFS_FILE_HEADER **Files;
+} VOLUME;
+
+typedef struct {
+  EFI_FV_FILETYPE Type;
+  EFI_GUID Name;
+  EFI_SECTION_TYPE SectionType;
+} TARGET;
+
+//
+// Page access tracking: memory under test is protected and every first touch
+// of a page is recorded by SIGSEGV handler.
+//
+STATIC UINT8 *mTrackBase;
+STATIC UINTN mTrackSize;
+STATIC UINT8 *mTrackPages;
+STATIC UINTN mTrackTouched;
+STATIC INT32 mTrackProt;
+
+STATIC
+VOID
+OnFault(
+  int Sig,
+  siginfo_t *Info,
+  void *Context
+  )
+{
+  UINT8 *Addr = Info->si_addr;
+  UINTN Page;
+
+  if (Addr < mTrackBase || Addr >= mTrackBase + mTrackSize) {
+    signal(SIGSEGV, SIG_DFL);
+    raise(SIGSEGV);
+    return;
+  }
+
+  Page = (Addr - mTrackBase) / PAGE_SIZE_;
+  mTrackPages[Page] = 1;
+  mTrackTouched++;
+  mprotect(mTrackBase + Page * PAGE_SIZE_, PAGE_SIZE_, mTrackProt);
+}
+
+STATIC
+VOID
+TrackStart(
+  IN VOLUME *Vol
+  )
+{
+  mTrackBase = Vol->Base;
+  mTrackSize = Vol->Size;
+  mTrackProt = Vol->Prot;
+  mTrackTouched = 0;
+  memset(mTrackPages, 0, (Vol->Size + PAGE_SIZE_ - 1) / PAGE_SIZE_);
+  mprotect(Vol->Base, Vol->Size, PROT_NONE);
+}
+
+STATIC
+UINTN
+TrackStop(
+  IN VOLUME *Vol
+  )
+{
+  mprotect(Vol->Base, Vol->Size, mTrackProt);
+  return mTrackTouched;
+}
+
+STATIC
+UINT64
+NowNs(VOID)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (UINT64) Ts.tv_sec * 1000000000ULL + Ts.tv_nsec;
+}
+
+STATIC UINT64 mRand = 0x9e3779b97f4a7c15ULL;
+
+STATIC
+UINT64
+Rand(VOID)
+{
+  mRand ^= mRand << 13;
+  mRand ^= mRand >> 7;
+  mRand ^= mRand << 17;
+  return mRand;
+}
+
+STATIC
+VOID *
+Map32(
+  IN UINTN Size,
+  IN INT32 Prot,
+  IN INT32 Fd
+  )
+{
+  VOID *Ptr;
+  INT32 Flags;
+
+  //
+  // Sources keep addresses in 32-bit variables like they do on ARC, so all
+  // images must be mapped below 4 GiB.
+  //
+  Flags = MAP_PRIVATE | MAP_32BIT | (Fd < 0 ? MAP_ANONYMOUS : 0);
+  Ptr = mmap(NULL, Size, Prot, Flags, Fd, 0);
+  if (Ptr == MAP_FAILED) {
+    perror("mmap");
+    exit(1);
+  }
+
+  return Ptr;
+}
+
+STATIC
+VOID
+SetSize24(
+  OUT UINT8 Size[3],
+  IN UINT32 Val
+  )
+{
+  Size[0] = Val & 0xff;
+  Size[1] = (Val >> 8) & 0xff;
+  Size[2] = (Val >> 16) & 0xff;
+}
+
+STATIC
+UINTN
+PutFile(
+  IN UINT8 *Addr,
+  IN CONST EFI_GUID *Name,
+  IN EFI_FV_FILETYPE Type,
+  IN CONST SECTION_MIX *Mix,
+  IN UINT32 RawSize // Payload of a RAW only file, 0 for Mix sections
+  )
+{
+  EFI_FFS_FILE_HEADER *File;
+  EFI_COMMON_SECTION_HEADER *Section;
+  UINTN Pos;
+  UINTN Size;
+  UINT8 Idx;
+
+  File = (EFI_FFS_FILE_HEADER *) Addr;
+  memset(File, 0, sizeof(*File));
+  File->Name = *Name;
+  File->Type = Type;
+  File->IntegrityCheck.Checksum.File = 0xaa;
+  File->State = 0xf8;
+
+  Pos = sizeof(*File);
+  for (Idx = 0; Idx < (RawSize ? 1 : Mix->Count); Idx++) {
+    Pos = ALIGN_VALUE(Pos, 4);
+    Size = RawSize ? RawSize : 64 + Rand() % 960;
+    Size += sizeof(*Section);
+    Section = (EFI_COMMON_SECTION_HEADER *) (Addr + Pos);
+    SetSize24(Section->Size, Size);
+    Section->Type = RawSize ? EFI_SECTION_RAW : Mix->Types[Idx];
+    memset(Section + 1, 0x5a, Size - sizeof(*Section));
+    Pos += Size;
+  }
+
+  SetSize24(File->Size, Pos);
+  return Pos;
+}
+
+STATIC
+int
+CompareEntries(
+  CONST VOID *Ptr1,
+  CONST VOID *Ptr2
+  )
+{
+  CONST FFS_INDEX_ENTRY *Entry1 = Ptr1;
+  CONST FFS_INDEX_ENTRY *Entry2 = Ptr2;
+
+  if (Entry1->Type != Entry2->Type) {
+    return Entry1->Type - Entry2->Type;
+  }
+
+  return memcmp(&Entry1->Name, &Entry2->Name, sizeof(EFI_GUID));
+}
+
+//
+// Lay out the index file first, then FileCount files with random names, and
+// a DXE core last so that type-only searches have to go through everything.
+//
+STATIC
+VOID
+MakeVolume(
+  OUT VOLUME *Vol,
+  IN UINTN FileCount,
+  IN CONST SECTION_MIX *Mix
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER *Fv;
+  CONST EFI_GUID IndexName = FFS_INDEX_FILE_GUID;
+  FFS_INDEX_ENTRY *Entries;
+  EFI_GUID Name;
+  UINTN IndexSize;
+  UINTN Pos;
+  UINTN Idx;
+  UINT8 Type;
+
+  FileCount++; // DXE core
+  IndexSize = sizeof(FFS_INDEX_HEADER) + (FileCount + 1) * sizeof(*Entries);
+  Vol->Size = ALIGN_VALUE(
+    256 + IndexSize + FileCount * (sizeof(EFI_FFS_FILE_HEADER) + 4 * 1100),
+    PAGE_SIZE_);
+  Vol->Prot = PROT_READ | PROT_WRITE;
+  Vol->Base = Map32(Vol->Size, Vol->Prot, -1);
+  Vol->FileCount = FileCount + 1;
+  Vol->Files = calloc(Vol->FileCount, sizeof(*Vol->Files));
+  memset(Vol->Base, 0xff, Vol->Size);
+
+  Fv = (EFI_FIRMWARE_VOLUME_HEADER *) Vol->Base;
+  memset(Fv, 0, sizeof(*Fv));
+  Fv->FvLength = Vol->Size;
+  Fv->Signature = EFI_FVH_SIGNATURE;
+  Fv->HeaderLength = sizeof(*Fv) + sizeof(EFI_FV_BLOCK_MAP_ENTRY);
+  Fv->Revision = 2;
+
+  Pos = ALIGN_VALUE(Fv->HeaderLength, 8);
+  Vol->Files[0] = (EFI_FFS_FILE_HEADER *) (Vol->Base + Pos);
+  Pos += PutFile(Vol->Base + Pos, &IndexName, EFI_FV_FILETYPE_FREEFORM, NULL,
+    IndexSize);
+  Vol->Index = (FFS_INDEX_HEADER *)
+    ((EFI_COMMON_SECTION_HEADER *) (Vol->Files[0] + 1) + 1);
+
+  for (Idx = 1; Idx < Vol->FileCount; Idx++) {
+    Pos = ALIGN_VALUE(Pos, 8);
+    Name.Data1 = Rand();
+    Name.Data2 = Rand();
+    Name.Data3 = Rand();
+    *(UINT64 *) Name.Data4 = Rand();
+    Type = Rand() % 4 ? EFI_FV_FILETYPE_PEIM : EFI_FV_FILETYPE_DRIVER;
+    if (Idx == Vol->FileCount - 1) {
+      Type = EFI_FV_FILETYPE_DXE_CORE;
+    }
+    Vol->Files[Idx] = (EFI_FFS_FILE_HEADER *) (Vol->Base + Pos);
+    Pos += PutFile(Vol->Base + Pos, &Name, Type, Mix, 0);
+  }
+
+  //
+  // Fill in index the same way scripts/fv-index.py does.
+  //
+  Vol->Index->Signature = FFS_INDEX_SIGNATURE;
+  Vol->Index->Capacity = Vol->FileCount;
+  Vol->Index->Count = Vol->FileCount;
+  Entries = (FFS_INDEX_ENTRY *) (Vol->Index + 1);
+  for (Idx = 0; Idx < Vol->FileCount; Idx++) {
+    memset(&Entries[Idx], 0, sizeof(*Entries));
+    Entries[Idx].Name = Vol->Files[Idx]->Name;
+    Entries[Idx].Type = Vol->Files[Idx]->Type;
+    Entries[Idx].Offset = (UINT8 *) Vol->Files[Idx] - Vol->Base;
+  }
+  qsort(Entries, Vol->FileCount, sizeof(*Entries), CompareEntries);
+}
+
+STATIC
+VOID
+FreeVolume(
+  IN VOLUME *Vol
+  )
+{
+  munmap(Vol->Base, Vol->Size);
+  free(Vol->Files);
+}
+
+STATIC
+VOID
+Report(
+  IN CONST CHAR8 *Bench,
+  IN CONST CHAR8 *Mode,
+  IN CONST CHAR8 *Mix,
+  IN UINTN Files,
+  IN UINT64 Iterations,
+  IN double NsPerOp,
+  IN UINTN Pages
+  )
+{
+  printf("{\"bench\": \"%s\", \"mode\": \"%s\", \"mix\": \"%s\", "
+    "\"files\": %lu, \"iterations\": %lu, \"ns_per_op\": %.2f, "
+    "\"pages_touched\": %lu, \"bytes_touched\": %lu}\n",
+    Bench, Mode, Mix, (unsigned long) Files, (unsigned long) Iterations,
+    NsPerOp, (unsigned long) Pages, (unsigned long) Pages * PAGE_SIZE_);
+  fflush(stdout);
+}
+
+//
+// Scaling summary: log-log slope of ns/op between smallest and largest
+// volume, i.e. ~0 for O(1), ~1 for O(n).
+//
+typedef struct {
+  CONST CHAR8 *Bench;
+  CONST CHAR8 *Mode;
+  CONST CHAR8 *Mix;
+  UINTN Files[MAX_SIZES];
+  double Ns[MAX_SIZES];
+  UINTN Count;
+} CURVE;
+
+STATIC CURVE mCurves[32];
+STATIC UINTN mCurveCount;
+
+STATIC
+VOID
+AddPoint(
+  IN CONST CHAR8 *Bench,
+  IN CONST CHAR8 *Mode,
+  IN CONST CHAR8 *Mix,
+  IN UINTN Files,
+  IN double Ns
+  )
+{
+  CURVE *Curve;
+  UINTN Idx;
+
+  for (Idx = 0; Idx < mCurveCount; Idx++) {
+    Curve = &mCurves[Idx];
+    if (!strcmp(Curve->Bench, Bench) && !strcmp(Curve->Mode, Mode) &&
+      !strcmp(Curve->Mix, Mix)) {
+      break;
+    }
+  }
+
+  if (Idx == mCurveCount) {
+    if (mCurveCount == ARRAY_SIZE(mCurves)) {
+      return;
+    }
+    Curve = &mCurves[mCurveCount++];
+    Curve->Bench = Bench;
+    Curve->Mode = Mode;
+    Curve->Mix = Mix;
+    Curve->Count = 0;
+  }
+
+  if (Curve->Count < MAX_SIZES) {
+    Curve->Files[Curve->Count] = Files;
+    Curve->Ns[Curve->Count++] = Ns;
+  }
+}
+
+STATIC
+VOID
+ReportCurves(VOID)
+{
+  CURVE *Curve;
+  UINTN Idx;
+  UINTN Last;
+  double Slope;
+
+  for (Idx = 0; Idx < mCurveCount; Idx++) {
+    Curve = &mCurves[Idx];
+    if (Curve->Count < 2) {
+      continue;
+    }
+
+    Last = Curve->Count - 1;
+    Slope = log(Curve->Ns[Last] / Curve->Ns[0]) /
+      log((double) Curve->Files[Last] / Curve->Files[0]);
+    printf("{\"curve\": \"%s\", \"mode\": \"%s\", \"mix\": \"%s\", "
+      "\"files\": [", Curve->Bench, Curve->Mode, Curve->Mix);
+    for (UINTN Pt = 0; Pt < Curve->Count; Pt++) {
+      printf("%s%lu", Pt ? ", " : "", (unsigned long) Curve->Files[Pt]);
+    }
+    printf("], \"ns_per_op\": [");
+    for (UINTN Pt = 0; Pt < Curve->Count; Pt++) {
+      printf("%s%.2f", Pt ? ", " : "", Curve->Ns[Pt]);
+    }
+    printf("], \"loglog_slope\": %.3f}\n", Slope);
+  }
+}
+
+STATIC
+UINTN
+PickTargets(
+  IN VOLUME *Vol,
+  IN EFI_SECTION_TYPE SectionType,
+  OUT TARGET *Targets
+  )
+{
+  UINTN Idx;
+  EFI_FFS_FILE_HEADER *File;
+
+  for (Idx = 0; Idx < MAX_TARGETS; Idx++) {
+    File = Vol->Files[1 + Rand() % (Vol->FileCount - 1)];
+    Targets[Idx].Type = File->Type;
+    Targets[Idx].Name = File->Name;
+    Targets[Idx].SectionType = SectionType;
+  }
+
+  return MAX_TARGETS;
+}
+
+STATIC volatile UINTN mSink;
+
+//
+// PEI core dispatcher is linked in through PeiServices.c, but PEIMs are never
+// dispatched here.
+//
+VOID
+CallPeim(
+  IN EFI_PEIM_ENTRY_POINT2 PeimInit,
+  IN CONST EFI_GUID *FileName
+  )
+{
+  PeimInit(NULL, NULL);
+}
+
+STATIC
+UINT64
+Iterations(
+  IN UINTN Files
+  )
+{
+  UINT64 Iters = 40000000ULL / (Files + 10);
+
+  return Iters < 2000 ? 2000 : Iters;
+}
+
+STATIC
+VOID
+BenchGetFileSection(
+  IN VOLUME *Vol,
+  IN CONST CHAR8 *Mode,
+  IN CONST CHAR8 *Mix,
+  IN UINTN Files,
+  IN TARGET *Targets,
+  IN UINTN TargetCount
+  )
+{
+  UINT64 Iters;
+  UINT64 Start;
+  UINT64 Idx;
+  UINTN Pages;
+  TARGET *Target;
+  double Ns;
+
+  Iters = Iterations(Files);
+  Start = NowNs();
+  for (Idx = 0; Idx < Iters; Idx++) {
+    Target = &Targets[Idx % TargetCount];
+    mSink += (UINTN) GetFileSection(Vol->Base, Target->SectionType,
+      Target->Type, &Target->Name, NULL);
+  }
+  Ns = (double) (NowNs() - Start) / Iters;
+
+  //
+  // Pages touched are averaged over a handful of cold lookups.
+  //
+  for (Pages = 0, Idx = 0; Idx < 16; Idx++) {
+    Target = &Targets[Idx];
+    TrackStart(Vol);
+    mSink += (UINTN) GetFileSection(Vol->Base, Target->SectionType,
+      Target->Type, &Target->Name, NULL);
+    Pages += TrackStop(Vol);
+  }
+
+  Report("get_file_section", Mode, Mix, Files, Iters, Ns, Pages / 16);
+  AddPoint("get_file_section", Mode, Mix, Files, Ns);
+}
+
+STATIC
+VOID
+BenchFindSection(
+  IN VOLUME *Vol,
+  IN CONST SECTION_MIX *Mix,
+  IN UINTN Files
+  )
+{
+  EFI_FFS_FILE_HEADER *File;
+  EFI_SECTION_TYPE Type;
+  UINT64 Iters;
+  UINT64 Start;
+  UINT64 Idx;
+  double Ns;
+
+  Type = Mix->Types[Mix->Count - 1];
+  Iters = 4000000;
+  Start = NowNs();
+  for (Idx = 0; Idx < Iters; Idx++) {
+    File = Vol->Files[1 + Idx % (Vol->FileCount - 1)];
+    mSink += (UINTN) FindSection(Type, ToPhysAddr(File + 1),
+      ToPhysAddr(File) + FFS_FILE_SIZE(File), NULL);
+  }
+  Ns = (double) (NowNs() - Start) / Iters;
+
+  Report("find_section", "-", Mix->Name, Files, Iters, Ns, 0);
+}
+
+STATIC
+VOID
+BenchFindNextFile(
+  IN VOLUME *Vol,
+  IN CONST CHAR8 *Mix,
+  IN UINTN Files
+  )
+{
+  EFI_PEI_FILE_HANDLE Handle;
+  UINT64 Iters;
+  UINT64 Start;
+  UINT64 Idx;
+  UINTN Pages;
+  double Ns;
+
+  Iters = Iterations(Files);
+  Start = NowNs();
+  for (Idx = 0; Idx < Iters; Idx++) {
+    Handle = NULL;
+    PeiFfsFindNextFile(NULL, EFI_FV_FILETYPE_DXE_CORE, Vol->Base, &Handle);
+    mSink += (UINTN) Handle;
+  }
+  Ns = (double) (NowNs() - Start) / Iters;
+
+  TrackStart(Vol);
+  Handle = NULL;
+  PeiFfsFindNextFile(NULL, EFI_FV_FILETYPE_DXE_CORE, Vol->Base, &Handle);
+  Pages = TrackStop(Vol);
+
+  Report("ffs_find_next_file", "last-of-type", Mix, Files, Iters, Ns, Pages);
+  AddPoint("ffs_find_next_file", "last-of-type", Mix, Files, Ns);
+
+  //
+  // Enumerate all files resuming from previous handle, total cost should
+  // grow linearly with number of files.
+  //
+  Iters = Iterations(Files);
+  Start = NowNs();
+  for (Idx = 0; Idx < Iters; Idx++) {
+    Handle = NULL;
+    while (PeiFfsFindNextFile(NULL, EFI_FV_FILETYPE_ALL, Vol->Base,
+      &Handle) == EFI_SUCCESS) {
+      mSink += (UINTN) Handle;
+    }
+  }
+  Ns = (double) (NowNs() - Start) / Iters;
+
+  TrackStart(Vol);
+  Handle = NULL;
+  while (PeiFfsFindNextFile(NULL, EFI_FV_FILETYPE_ALL, Vol->Base,
+    &Handle) == EFI_SUCCESS);
+  Pages = TrackStop(Vol);
+
+  Report("ffs_find_next_file", "enumerate-all", Mix, Files, Iters, Ns, Pages);
+  AddPoint("ffs_find_next_file", "enumerate-all", Mix, Files, Ns);
+}
+
+STATIC
+VOID
+BenchGuids(VOID)
+{
+  EFI_GUID Guids[64];
+  GUID_STR Str;
+  UINT64 Iters;
+  UINT64 Start;
+  UINT64 Idx;
+
+  for (Idx = 0; Idx < ARRAY_SIZE(Guids); Idx++) {
+    Guids[Idx].Data1 = Rand();
+    Guids[Idx].Data2 = Rand();
+    Guids[Idx].Data3 = Rand();
+    *(UINT64 *) Guids[Idx].Data4 = Rand();
+  }
+
+  Iters = 10000000;
+  Start = NowNs();
+  for (Idx = 0; Idx < Iters; Idx++) {
+    GuidToAsciiStr(&Guids[Idx % ARRAY_SIZE(Guids)], &Str);
+    mSink += Str.Data[Idx % GUID_STR_MAX];
+  }
+  Report("guid_to_ascii_str", "-", "-", 0, Iters,
+    (double) (NowNs() - Start) / Iters, 0);
+
+  Iters = 100000000;
+  Start = NowNs();
+  for (Idx = 0; Idx < Iters; Idx++) {
+    mSink += CompareGuids(&Guids[Idx % ARRAY_SIZE(Guids)],
+      &Guids[(Idx >> 6) % ARRAY_SIZE(Guids)]);
+  }
+  Report("compare_guids", "-", "-", 0, Iters,
+    (double) (NowNs() - Start) / Iters, 0);
+}
+
+STATIC
+VOID
+RunSynthetic(
+  IN UINTN *Sizes,
+  IN UINTN SizeCount
+  )
+{
+  STATIC TARGET Targets[MAX_TARGETS];
+  CONST SECTION_MIX *Mix;
+  VOLUME Vol;
+  UINTN MixIdx;
+  UINTN SizeIdx;
+  UINT16 Count;
+
+  BenchGuids();
+
+  for (MixIdx = 0; MixIdx < ARRAY_SIZE(mMixes); MixIdx++) {
+    Mix = &mMixes[MixIdx];
+    for (SizeIdx = 0; SizeIdx < SizeCount; SizeIdx++) {
+      MakeVolume(&Vol, Sizes[SizeIdx], Mix);
+      mTrackPages = realloc(mTrackPages, Vol.Size / PAGE_SIZE_);
+      PickTargets(&Vol, Mix->Types[Mix->Count - 1], Targets);
+
+      Count = Vol.Index->Count;
+      Vol.Index->Count = 0; // Unpopulated index forces linear walk
+      BenchGetFileSection(&Vol, "linear", Mix->Name, Sizes[SizeIdx], Targets,
+        MAX_TARGETS);
+      Vol.Index->Count = Count;
+      BenchGetFileSection(&Vol, "indexed", Mix->Name, Sizes[SizeIdx], Targets,
+        MAX_TARGETS);
+
+      BenchFindSection(&Vol, Mix, Sizes[SizeIdx]);
+      BenchFindNextFile(&Vol, Mix->Name, Sizes[SizeIdx]);
+      FreeVolume(&Vol);
+    }
+  }
+
+  ReportCurves();
+}
+
+//
+// Benchmark lookups of every file of every volume found in a real image.
+//
+STATIC
+VOID
+RunImage(
+  IN CONST CHAR8 *Path
+  )
+{
+  STATIC TARGET Targets[MAX_TARGETS];
+  struct stat St;
+  EFI_FIRMWARE_VOLUME_HEADER *Fv;
+  EFI_FFS_FILE_HEADER *File;
+  EFI_COMMON_SECTION_HEADER *Section;
+  FFS_CURSOR Cursor;
+  VOLUME Vol;
+  UINT8 *Image;
+  UINTN Pos;
+  UINTN Count;
+  INT32 Fd;
+
+  Fd = open(Path, O_RDONLY);
+  if (Fd < 0 || fstat(Fd, &St) < 0) {
+    perror(Path);
+    exit(1);
+  }
+
+  Image = Map32(St.st_size, PROT_READ, Fd);
+  mTrackPages = calloc(1, St.st_size / PAGE_SIZE_ + 1);
+
+  for (Pos = 0; Pos + sizeof(*Fv) <= (UINTN) St.st_size; Pos += 8) {
+    Fv = (EFI_FIRMWARE_VOLUME_HEADER *) (Image + Pos);
+    if (Fv->Signature != EFI_FVH_SIGNATURE ||
+      Pos + Fv->FvLength > (UINTN) St.st_size || Pos % PAGE_SIZE_ != 0) {
+      continue;
+    }
+
+    Vol.Base = (UINT8 *) Fv;
+    Vol.Size = Fv->FvLength;
+    Vol.Prot = PROT_READ;
+    Vol.Index = GetFfsIndex(Fv);
+
+    Count = 0;
+    InitFfsCursor(&Cursor, Fv, NULL);
+    while (Count < MAX_TARGETS && (File = NextFfsFile(&Cursor, NULL)) != NULL) {
+      Section = (EFI_COMMON_SECTION_HEADER *) (File + 1);
+      Targets[Count].Type = File->Type;
+      Targets[Count].Name = File->Name;
+      Targets[Count++].SectionType = Section->Type;
+    }
+
+    if (Count > 0) {
+      fprintf(stderr, "> FV at 0x%lx, %lu files, %s\n", (unsigned long) Pos,
+        (unsigned long) Count, Vol.Index ? "indexed" : "no index");
+      BenchGetFileSection(&Vol, Vol.Index ? "image-indexed" : "image-linear",
+        Path, Count, Targets, Count);
+    }
+
+    Pos += Fv->FvLength - 8;
+  }
+}
+
+STATIC
+VOID
+Usage(
+  IN CONST CHAR8 *Name
+  )
+{
+  fprintf(stderr,
+    "Usage: %s [-s 10,100,1000,10000] [-f image.fd]\n"
+    "  -s  comma separated synthetic volume sizes (number of files)\n"
+    "  -f  benchmark lookups in a real FD/FV image mapped read-only\n",
+    Name);
+  exit(1);
+}
+
+int
+main(
+  int Argc,
+  char **Argv
+  )
+{
+  STATIC UINTN Sizes[MAX_SIZES] = { 10, 100, 1000, 10000 };
+  struct sigaction Sa;
+  UINTN SizeCount;
+  CHAR8 *Image;
+  CHAR8 *Tok;
+  int Opt;
+
+  SizeCount = 4;
+  Image = NULL;
+
+  while ((Opt = getopt(Argc, Argv, "s:f:h")) != -1) {
+    switch (Opt) {
+    case 's':
+      SizeCount = 0;
+      for (Tok = strtok(optarg, ","); Tok && SizeCount < MAX_SIZES;
+        Tok = strtok(NULL, ",")) {
+        Sizes[SizeCount++] = strtoul(Tok, NULL, 0);
+      }
+      break;
+    case 'f':
+      Image = optarg;
+      break;
+    default:
+      Usage(Argv[0]);
+    }
+  }
+
+  memset(&Sa, 0, sizeof(Sa));
+  Sa.sa_sigaction = OnFault;
+  Sa.sa_flags = SA_SIGINFO;
+  sigaction(SIGSEGV, &Sa, NULL);
+
+  if (Image != NULL) {
+    RunImage(Image);
+  } else {
+    RunSynthetic(Sizes, SizeCount);
+  }
+
+  return 0;
+}
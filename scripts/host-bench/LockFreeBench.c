@@ -0,0 +1,459 @@
+/** @file
+  Host stress test and benchmark for lock free primitives of ARC
+  SynchronizationLib and LockFreeLib (Platform/ARC/Library/CpuLib/CpuLock.c
+  and LockFree.c).
+
+  Each case runs for a fixed time and checks results against what a
+  sequential execution of the same operations could give:
+
+    fetch-or/and  each thread sets and clears its own bit of a shared word,
+                  the value returned must always have it in the state the
+                  thread left it
+    fetch-add     values returned to a thread strictly increase and the
+                  final value equals the number of calls
+    spsc          values arrive in the order pushed, none lost or repeated
+    mpmc          every value is popped exactly once, values of one
+                  producer are seen in push order by every consumer
+    seqlock       readers never accept a torn record
+
+  With host compilers atomics come from Shim/HostSync.c, with ARC ones from
+  Arc2Sync.c, so the same test runs on ARC hardware or QEMU user mode.
+  Threads are run by Shim/BenchHarness.c. Results are printed as JSON lines,
+  one per case and thread count.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <HostShim.h>
+#include <BenchHarness.h>
+#include <Library/SynchronizationLib.h>
+#include <LockFreeLib.h>
+
+#define RING_SIZE 256
+#define RECORD_WORDS 8
+
+//
+// Ring values are producer Id in the upper bits and sequence number in the
+// lower ones, 0 is never pushed
+//
+#define VALUE_SHIFT 24
+#define VALUE_MASK ((1U << VALUE_SHIFT) - 1)
+
+//
+// Worker Sum is the sum of values pushed or popped, rings only
+//
+typedef struct {
+  CONST CHAR8 *Name;
+  UINT32 MinThreads;
+  UINT32 MaxThreads;
+  VOID (*Init)(UINT32 Threads);
+  VOID (*Run)(BENCH_WORKER *Self);
+  BOOLEAN (*Check)(BENCH_WORKER *Workers, UINT32 Threads);
+} CASE;
+
+STATIC volatile UINT32 mWord LINE_ALIGNED;
+STATIC volatile UINT32 mBits[BENCH_MAX_THREADS / 32] LINE_ALIGNED;
+
+STATIC SPSC_RING mSpsc;
+STATIC UINTN mSpscEntries[RING_SIZE] LINE_ALIGNED;
+
+STATIC MPMC_RING mMpmc;
+STATIC MPMC_RING_CELL mMpmcCells[RING_SIZE] LINE_ALIGNED;
+STATIC volatile UINT32 mProducersLeft LINE_ALIGNED;
+
+STATIC SEQ_LOCK mSeqLock;
+STATIC volatile UINT32 mRecord[RECORD_WORDS] LINE_ALIGNED;
+
+STATIC
+VOID
+WordInit(
+  IN UINT32 Threads
+  )
+{
+  mWord = 0;
+  memset((VOID *) mBits, 0, sizeof(mBits));
+}
+
+STATIC
+VOID
+FetchOrAndRun(
+  IN BENCH_WORKER *Self
+  )
+{
+  volatile UINT32 *Word;
+  UINT32 Bit;
+  UINT32 Old;
+
+  Word = &mBits[Self->Id / 32];
+  Bit = 1U << (Self->Id % 32);
+  for (; !BENCH_STOPPED(); Self->Ops += 2) {
+    Old = InterlockedFetchOr32(Word, Bit);
+    Self->Errors += (Old & Bit) != 0;
+    Old = InterlockedFetchAnd32(Word, ~Bit);
+    Self->Errors += (Old & Bit) == 0;
+  }
+}
+
+STATIC
+BOOLEAN
+FetchOrAndCheck(
+  IN BENCH_WORKER *Workers,
+  IN UINT32 Threads
+  )
+{
+  UINT32 Idx;
+
+  for (Idx = 0; Idx < ARRAY_SIZE(mBits); Idx++) {
+    if (mBits[Idx] != 0) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+STATIC
+VOID
+FetchAddRun(
+  IN BENCH_WORKER *Self
+  )
+{
+  UINT32 Old;
+  UINT32 Last;
+
+  Last = 0;
+  for (; !BENCH_STOPPED(); Self->Ops++) {
+    Old = InterlockedFetchAdd32(&mWord, 1);
+    Self->Errors += Self->Ops != 0 && (INT32) (Old - Last) <= 0;
+    Last = Old;
+  }
+}
+
+STATIC
+BOOLEAN
+FetchAddCheck(
+  IN BENCH_WORKER *Workers,
+  IN UINT32 Threads
+  )
+{
+  UINT64 Total;
+  UINT32 Idx;
+
+  Total = 0;
+  for (Idx = 0; Idx < Threads; Idx++) {
+    Total += Workers[Idx].Ops;
+  }
+
+  return mWord == (UINT32) Total;
+}
+
+STATIC
+VOID
+SpscInit(
+  IN UINT32 Threads
+  )
+{
+  InitializeSpscRing(&mSpsc, mSpscEntries, RING_SIZE);
+}
+
+//
+// Worker 0 pushes 1, 2, 3, ... until stopped, worker 1 pops until stopped
+// and the ring is drained
+//
+STATIC
+VOID
+SpscRun(
+  IN BENCH_WORKER *Self
+  )
+{
+  UINTN Value;
+  UINTN Expected;
+  BOOLEAN Done;
+
+  if (Self->Id == 0) {
+    for (Value = 1; !BENCH_STOPPED(); ) {
+      if (SpscRingPush(&mSpsc, Value)) {
+        Value++;
+        Self->Ops++;
+      } else {
+        CpuPause();
+      }
+    }
+
+    return;
+  }
+
+  //
+  // Ring found empty after producer stopped stays empty
+  //
+  for (Expected = 1; ; ) {
+    Done = BENCH_STOPPED();
+    if (SpscRingPop(&mSpsc, &Value)) {
+      Self->Errors += Value != Expected;
+      Expected = Value + 1;
+      Self->Ops++;
+    } else if (Done) {
+      break;
+    } else {
+      CpuPause();
+    }
+  }
+}
+
+STATIC
+BOOLEAN
+SpscCheck(
+  IN BENCH_WORKER *Workers,
+  IN UINT32 Threads
+  )
+{
+  UINTN Value;
+
+  return Workers[1].Ops == Workers[0].Ops && !SpscRingPop(&mSpsc, &Value);
+}
+
+STATIC
+VOID
+MpmcInit(
+  IN UINT32 Threads
+  )
+{
+  InitializeMpmcRing(&mMpmc, mMpmcCells, RING_SIZE);
+  mProducersLeft = (Threads + 1) / 2;
+}
+
+//
+// Even workers produce, odd ones consume. Consumers keep popping until all
+// producers are done and the ring is empty.
+//
+STATIC
+VOID
+MpmcRun(
+  IN BENCH_WORKER *Self
+  )
+{
+  UINT32 Last[BENCH_MAX_THREADS / 2];
+  UINTN Value;
+  UINT32 Producer;
+  UINT32 Seq;
+  BOOLEAN Done;
+
+  if ((Self->Id & 1) == 0) {
+    for (Seq = 1; !BENCH_STOPPED() && Seq <= VALUE_MASK; ) {
+      Value = ((UINTN) (Self->Id / 2) << VALUE_SHIFT) | Seq;
+      if (MpmcRingPush(&mMpmc, Value)) {
+        Self->Sum += Value;
+        Seq++;
+        Self->Ops++;
+      } else {
+        CpuPause();
+      }
+    }
+
+    InterlockedFetchAdd32(&mProducersLeft, (UINT32) -1);
+    return;
+  }
+
+  memset(Last, 0, sizeof(Last));
+  for (;;) {
+    Done = mProducersLeft == 0;
+    if (MpmcRingPop(&mMpmc, &Value)) {
+      Producer = (UINT32) (Value >> VALUE_SHIFT);
+      Seq = (UINT32) (Value & VALUE_MASK);
+      if (Producer >= (Self->Threads + 1) / 2 || Seq <= Last[Producer]) {
+        Self->Errors++;
+      } else {
+        Last[Producer] = Seq;
+      }
+
+      Self->Sum += Value;
+      Self->Ops++;
+    } else if (Done) {
+      break;
+    } else {
+      CpuPause();
+    }
+  }
+}
+
+STATIC
+BOOLEAN
+MpmcCheck(
+  IN BENCH_WORKER *Workers,
+  IN UINT32 Threads
+  )
+{
+  UINT64 PushedSum;
+  UINT64 PoppedSum;
+  UINT64 Pushed;
+  UINT64 Popped;
+  UINTN Value;
+  UINT32 Idx;
+
+  PushedSum = PoppedSum = Pushed = Popped = 0;
+  for (Idx = 0; Idx < Threads; Idx++) {
+    if ((Idx & 1) == 0) {
+      PushedSum += Workers[Idx].Sum;
+      Pushed += Workers[Idx].Ops;
+    } else {
+      PoppedSum += Workers[Idx].Sum;
+      Popped += Workers[Idx].Ops;
+    }
+  }
+
+  return Pushed == Popped && PushedSum == PoppedSum &&
+    !MpmcRingPop(&mMpmc, &Value);
+}
+
+STATIC
+VOID
+SeqLockInit(
+  IN UINT32 Threads
+  )
+{
+  InitializeSeqLock(&mSeqLock);
+  memset((VOID *) mRecord, 0, sizeof(mRecord));
+}
+
+//
+// Worker 0 writes records of equal words, the others read them and count
+// accepted records whose words differ
+//
+STATIC
+VOID
+SeqLockRun(
+  IN BENCH_WORKER *Self
+  )
+{
+  UINT32 Copy[RECORD_WORDS];
+  UINT32 Sequence;
+  UINT32 Value;
+  UINT32 Idx;
+
+  if (Self->Id == 0) {
+    for (Value = 1; !BENCH_STOPPED(); Value++, Self->Ops++) {
+      SeqLockWriteBegin(&mSeqLock);
+      for (Idx = 0; Idx < RECORD_WORDS; Idx++) {
+        mRecord[Idx] = Value;
+      }
+
+      SeqLockWriteEnd(&mSeqLock);
+    }
+
+    return;
+  }
+
+  for (; !BENCH_STOPPED(); Self->Ops++) {
+    do {
+      Sequence = SeqLockReadBegin(&mSeqLock);
+      for (Idx = 0; Idx < RECORD_WORDS; Idx++) {
+        Copy[Idx] = mRecord[Idx];
+      }
+    } while (SeqLockReadRetry(&mSeqLock, Sequence));
+
+    for (Idx = 1; Idx < RECORD_WORDS; Idx++) {
+      Self->Errors += Copy[Idx] != Copy[0];
+    }
+  }
+}
+
+STATIC
+BOOLEAN
+SeqLockCheck(
+  IN BENCH_WORKER *Workers,
+  IN UINT32 Threads
+  )
+{
+  return (mSeqLock.Sequence & 1) == 0 &&
+    mSeqLock.Sequence == 2 * (UINT32) Workers[0].Ops;
+}
+
+STATIC CONST CASE mCases[] = {
+  { "fetch-or-and", 1, BENCH_MAX_THREADS, WordInit, FetchOrAndRun,
+    FetchOrAndCheck },
+  { "fetch-add", 1, BENCH_MAX_THREADS, WordInit, FetchAddRun, FetchAddCheck },
+  { "spsc", 2, 2, SpscInit, SpscRun, SpscCheck },
+  { "mpmc", 2, BENCH_MAX_THREADS, MpmcInit, MpmcRun, MpmcCheck },
+  { "seqlock", 2, BENCH_MAX_THREADS, SeqLockInit, SeqLockRun, SeqLockCheck },
+};
+
+STATIC
+BOOLEAN
+Measure(
+  IN CONST VOID *Item,
+  IN UINT32 Threads,
+  IN UINT32 DurationMs
+  )
+{
+  STATIC BENCH_WORKER Workers[BENCH_MAX_THREADS];
+  CONST CASE *Case;
+  UINT64 Ns;
+  UINT64 Total;
+  UINT32 Errors;
+  BOOLEAN Ok;
+  UINT32 Idx;
+
+  Case = Item;
+  Case->Init(Threads);
+  Ns = BenchRun(Case->Run, Workers, Threads, DurationMs);
+
+  Total = 0;
+  Errors = 0;
+  for (Idx = 0; Idx < Threads; Idx++) {
+    Total += Workers[Idx].Ops;
+    Errors += Workers[Idx].Errors;
+  }
+
+  Ok = Errors == 0 && Case->Check(Workers, Threads);
+  printf("{\"bench\": \"lockfree\", \"case\": \"%s\", \"threads\": %u, "
+    "\"ops\": %lu, \"ns\": %lu, \"mops_per_s\": %.3f, \"errors\": %u, "
+    "\"pause_yields\": %s, \"ok\": %s}\n",
+    Case->Name, Threads, (unsigned long) Total, (unsigned long) Ns,
+    Ns ? 1000.0 * Total / Ns : 0, Errors, HostPauseYields ? "true" : "false",
+    Ok ? "true" : "false");
+  fflush(stdout);
+  return Ok;
+}
+
+int
+main(
+  int Argc,
+  char **Argv
+  )
+{
+  BENCH_OPTIONS Options;
+  BOOLEAN Ok;
+  UINTN Idx;
+
+  BenchParseOptions(Argc, Argv, 'c', "", NULL,
+    "Usage: %s [-t 64] [-d 200] [-c fetch-or-and,fetch-add,spsc,mpmc,"
+    "seqlock]\n"
+    "  -t  largest number of threads, runs 1, 2, 4, ... up to it\n"
+    "  -d  milliseconds per run\n"
+    "  -c  comma separated cases to run\n",
+    &Options);
+
+  fprintf(stderr, "> %ld CPUs\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+  Ok = TRUE;
+  for (Idx = 0; Idx < ARRAY_SIZE(mCases); Idx++) {
+    Ok &= BenchSweep(&Options, mCases[Idx].Name, mCases[Idx].MinThreads,
+      mCases[Idx].MaxThreads, Measure, &mCases[Idx]);
+  }
+
+  if (!Ok) {
+    fprintf(stderr, "! result not possible in any sequential order\n");
+  }
+
+  return Ok ? 0 : 1;
+}
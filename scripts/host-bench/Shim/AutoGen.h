@@ -0,0 +1,37 @@
+/** @file
+  Host replacement for build generated AutoGen.h.
+
+  Fixed PCDs that hold flash addresses are redirected to variables, so the
+  benchmark can point them at synthetic or mmapped images.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef HOST_AUTOGEN_H_
+#define HOST_AUTOGEN_H_
+
+#include <HostShim.h>
+
+//
+// Sources use plain C99 'inline' in headers without external definitions.
+//
+#define inline static __inline__
+
+extern UINT32 HostBootFvBase;
+extern UINT32 HostDxeFvBase;
+extern UINT32 HostBootManifestBase;
+
+#define FixedPcdGet32(TokenName) _PCD_VALUE_##TokenName
+#define PcdGet32(TokenName) _PCD_VALUE_##TokenName
+
+#define _PCD_VALUE_PcdBootFvBase HostBootFvBase
+#define _PCD_VALUE_PcdDxeFvBase HostDxeFvBase
+#define _PCD_VALUE_PcdBootManifestBase HostBootManifestBase
+#define _PCD_VALUE_PcdBootManifestSize 0x1000
+#define _PCD_VALUE_PcdSpinLockTimeout 0
+
+#endif // HOST_AUTOGEN_H_
@@ -0,0 +1,161 @@
+/** @file
+  Thread harness shared by host synchronization benchmarks, see
+  BenchHarness.h.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BenchHarness.h"
+
+volatile UINT32 gBenchStop LINE_ALIGNED;
+
+STATIC pthread_barrier_t mStart;
+STATIC VOID (*mBody)(IN BENCH_WORKER *Self);
+
+VOID
+BenchParseOptions(
+  IN int Argc,
+  IN char **Argv,
+  IN CHAR8 SelectOpt,
+  IN CONST CHAR8 *ExtraOpts,
+  IN BOOLEAN (*Extra)(IN int Opt, IN CONST CHAR8 *Arg),
+  IN CONST CHAR8 *Usage,
+  OUT BENCH_OPTIONS *Options
+  )
+{
+  CHAR8 OptString[32];
+  int Opt;
+
+  snprintf(OptString, sizeof(OptString), "t:d:%c:h%s", SelectOpt, ExtraOpts);
+  Options->MaxThreads = BENCH_MAX_THREADS;
+  Options->DurationMs = 200;
+  Options->Select = NULL;
+
+  while ((Opt = getopt(Argc, Argv, OptString)) != -1) {
+    if (Opt == 't') {
+      Options->MaxThreads = strtoul(optarg, NULL, 0);
+    } else if (Opt == 'd') {
+      Options->DurationMs = strtoul(optarg, NULL, 0);
+    } else if (Opt == SelectOpt) {
+      Options->Select = optarg;
+    } else if (Opt == 'h' || Opt == '?' || Extra == NULL ||
+      !Extra(Opt, optarg)) {
+      fprintf(stderr, Usage, Argv[0]);
+      exit(1);
+    }
+  }
+
+  if (Options->MaxThreads < 1 || Options->MaxThreads > BENCH_MAX_THREADS) {
+    fprintf(stderr, Usage, Argv[0]);
+    exit(1);
+  }
+}
+
+UINT64
+BenchNowNs(VOID)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (UINT64) Ts.tv_sec * 1000000000ULL + Ts.tv_nsec;
+}
+
+STATIC
+VOID *
+Worker(
+  VOID *Arg
+  )
+{
+  pthread_barrier_wait(&mStart);
+  mBody(Arg);
+  return NULL;
+}
+
+UINT64
+BenchRun(
+  IN VOID (*Body)(IN BENCH_WORKER *Self),
+  IN BENCH_WORKER *Workers,
+  IN UINT32 Threads,
+  IN UINT32 DurationMs
+  )
+{
+  struct timespec Sleep;
+  UINT64 Start;
+  UINT32 Idx;
+
+  mBody = Body;
+  gBenchStop = 0;
+
+  HostPauseYields = Threads > (UINT32) sysconf(_SC_NPROCESSORS_ONLN);
+  pthread_barrier_init(&mStart, NULL, Threads + 1);
+  for (Idx = 0; Idx < Threads; Idx++) {
+    memset(&Workers[Idx], 0, sizeof(Workers[Idx]));
+    Workers[Idx].Id = Idx;
+    Workers[Idx].Threads = Threads;
+    if (pthread_create(&Workers[Idx].Thread, NULL, Worker,
+      &Workers[Idx]) != 0) {
+      fprintf(stderr, "! cannot create thread %u\n", Idx);
+      exit(1);
+    }
+  }
+
+  Sleep.tv_sec = DurationMs / 1000;
+  Sleep.tv_nsec = (DurationMs % 1000) * 1000000L;
+  pthread_barrier_wait(&mStart);
+  Start = BenchNowNs();
+  nanosleep(&Sleep, NULL);
+  __atomic_store_n(&gBenchStop, 1, __ATOMIC_RELAXED);
+
+  for (Idx = 0; Idx < Threads; Idx++) {
+    pthread_join(Workers[Idx].Thread, NULL);
+  }
+
+  pthread_barrier_destroy(&mStart);
+  return BenchNowNs() - Start;
+}
+
+BOOLEAN
+BenchSweep(
+  IN CONST BENCH_OPTIONS *Options,
+  IN CONST CHAR8 *Name,
+  IN UINT32 MinThreads,
+  IN UINT32 MaxThreads,
+  IN BOOLEAN (*Measure)(IN CONST VOID *Item, IN UINT32 Threads,
+    IN UINT32 DurationMs),
+  IN CONST VOID *Item
+  )
+{
+  UINT32 Threads;
+  UINT32 Last;
+  BOOLEAN Ok;
+
+  if (Options->Select != NULL && strstr(Options->Select, Name) == NULL) {
+    return TRUE;
+  }
+
+  Ok = TRUE;
+  Last = Options->MaxThreads < MaxThreads ? Options->MaxThreads : MaxThreads;
+  for (Threads = 1; ; Threads *= 2) {
+    Threads = Threads < Last ? Threads : Last;
+    if (Threads >= MinThreads) {
+      Ok &= Measure(Item, Threads, Options->DurationMs);
+    }
+
+    if (Threads == Last) {
+      break;
+    }
+  }
+
+  return Ok;
+}
@@ -0,0 +1,127 @@
+/** @file
+  Thread harness shared by host synchronization benchmarks.
+
+  Each measurement starts worker threads at once on a barrier, lets them run
+  for a fixed time and stops them with a flag. Measurements are repeated for
+  1, 2, 4, ... threads up to the largest count asked for.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef BENCH_HARNESS_H_
+#define BENCH_HARNESS_H_
+
+#include <pthread.h>
+#include <HostShim.h>
+#include <ArcSyncLib.h>
+
+#define BENCH_MAX_THREADS 64
+#define LINE_ALIGNED __attribute__((aligned(ARC_SYNC_LINE_SIZE)))
+
+typedef struct {
+  pthread_t Thread;
+  UINT32 Id;
+  UINT32 Threads; // Workers in this measurement
+  UINT64 Ops;
+  UINT64 Sum; // Benchmark specific
+  UINT32 Errors;
+} LINE_ALIGNED BENCH_WORKER;
+
+typedef struct {
+  UINT32 MaxThreads;
+  UINT32 DurationMs;
+  CONST CHAR8 *Select; // Comma separated names to measure, NULL for all
+} BENCH_OPTIONS;
+
+//
+// Workers run until this is set, checked with BENCH_STOPPED()
+//
+extern volatile UINT32 gBenchStop;
+
+#define BENCH_STOPPED() (__atomic_load_n(&gBenchStop, __ATOMIC_RELAXED) != 0)
+
+/**
+  Parse -t (largest thread count), -d (milliseconds per measurement) and
+  selection option, exit with usage text on anything else.
+
+  @param Argc       Argument count of main().
+  @param Argv       Arguments of main().
+  @param SelectOpt  Option letter of comma separated names to measure.
+  @param ExtraOpts  getopt() string of benchmark specific options.
+  @param Extra      Handler of benchmark specific options, FALSE for bad
+                    argument. NULL if there are none.
+  @param Usage      Usage text, printf() format taking program name.
+  @param Options    Parsed options.
+
+**/
+VOID
+BenchParseOptions(
+  IN int Argc,
+  IN char **Argv,
+  IN CHAR8 SelectOpt,
+  IN CONST CHAR8 *ExtraOpts,
+  IN BOOLEAN (*Extra)(IN int Opt, IN CONST CHAR8 *Arg),
+  IN CONST CHAR8 *Usage,
+  OUT BENCH_OPTIONS *Options
+  );
+
+/**
+  Monotonic time.
+
+  @return Nanoseconds since an arbitrary point.
+
+**/
+UINT64
+BenchNowNs(VOID);
+
+/**
+  Run workers for given time. Workers are cleared, given their Id and thread
+  count and started together, Body has to return soon after BENCH_STOPPED().
+
+  @param Body         Worker body.
+  @param Workers      Workers, at least Threads of them.
+  @param Threads      Number of worker threads.
+  @param DurationMs   Milliseconds before workers are stopped.
+
+  @return Nanoseconds from start until every worker returned.
+
+**/
+UINT64
+BenchRun(
+  IN VOID (*Body)(IN BENCH_WORKER *Self),
+  IN BENCH_WORKER *Workers,
+  IN UINT32 Threads,
+  IN UINT32 DurationMs
+  );
+
+/**
+  Measure for 1, 2, 4, ... threads up to the smaller of the largest count
+  asked for and MaxThreads, skipping counts below MinThreads. Nothing is
+  measured if Name is not selected.
+
+  @param Options      Parsed options.
+  @param Name         Name of what is measured.
+  @param MinThreads   Smallest thread count measured.
+  @param MaxThreads   Largest thread count measured.
+  @param Measure      Measurement, TRUE if results are correct.
+  @param Item         Passed to Measure.
+
+  @return TRUE if every measurement returned TRUE.
+
+**/
+BOOLEAN
+BenchSweep(
+  IN CONST BENCH_OPTIONS *Options,
+  IN CONST CHAR8 *Name,
+  IN UINT32 MinThreads,
+  IN UINT32 MaxThreads,
+  IN BOOLEAN (*Measure)(IN CONST VOID *Item, IN UINT32 Threads,
+    IN UINT32 DurationMs),
+  IN CONST VOID *Item
+  );
+
+#endif // BENCH_HARNESS_H_
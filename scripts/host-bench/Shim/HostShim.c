@@ -0,0 +1,212 @@
+/** @file
+  Host implementations of library functions used by ARC platform sources.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+#include <HostShim.h>
+
+UINT32 HostBootFvBase;
+UINT32 HostDxeFvBase;
+UINT32 HostBootManifestBase;
+BOOLEAN HostPauseYields;
+
+VOID *
+EFIAPI
+CopyMem(
+  OUT VOID *Destination,
+  IN CONST VOID *Source,
+  IN UINTN Length
+  )
+{
+  return memmove(Destination, Source, Length);
+}
+
+VOID *
+EFIAPI
+SetMem(
+  OUT VOID *Buffer,
+  IN UINTN Length,
+  IN UINT8 Value
+  )
+{
+  return memset(Buffer, Value, Length);
+}
+
+VOID *
+EFIAPI
+ZeroMem(
+  OUT VOID *Buffer,
+  IN UINTN Length
+  )
+{
+  return memset(Buffer, 0, Length);
+}
+
+BOOLEAN
+EFIAPI
+CompareGuid(
+  IN CONST GUID *Guid1,
+  IN CONST GUID *Guid2
+  )
+{
+  return memcmp(Guid1, Guid2, sizeof(GUID)) == 0;
+}
+
+GUID *
+EFIAPI
+CopyGuid(
+  OUT GUID *DestinationGuid,
+  IN CONST GUID *SourceGuid
+  )
+{
+  memcpy(DestinationGuid, SourceGuid, sizeof(GUID));
+  return DestinationGuid;
+}
+
+INTN
+EFIAPI
+LowBitSet32(
+  IN UINT32 Operand
+  )
+{
+  return Operand == 0 ? -1 : __builtin_ctz(Operand);
+}
+
+UINT32
+EFIAPI
+CalculateSum32(
+  IN CONST UINT32 *Buffer,
+  IN UINTN Length
+  )
+{
+  UINT32 Sum;
+  UINTN Idx;
+
+  for (Sum = 0, Idx = 0; Idx < Length / sizeof(UINT32); Idx++) {
+    Sum += Buffer[Idx];
+  }
+
+  return Sum;
+}
+
+//
+// Only plain printf conversions are supported; EDK2 specific ones (%a, %g)
+// are not used on the measured paths.
+//
+UINTN
+EFIAPI
+AsciiSPrint(
+  OUT CHAR8 *StartOfBuffer,
+  IN UINTN BufferSize,
+  IN CONST CHAR8 *FormatString,
+  ...
+  )
+{
+  va_list Marker;
+  int Len;
+
+  va_start(Marker, FormatString);
+  Len = vsnprintf(StartOfBuffer, BufferSize, FormatString, Marker);
+  va_end(Marker);
+
+  return Len < 0 ? 0 : (UINTN) Len;
+}
+
+UINTN
+EFIAPI
+SerialPortWrite(
+  IN UINT8 *Buffer,
+  IN UINTN Bytes
+  )
+{
+  return fwrite(Buffer, 1, Bytes, stderr);
+}
+
+RETURN_STATUS
+EFIAPI
+SerialPortInitialize(VOID)
+{
+  return RETURN_SUCCESS;
+}
+
+VOID
+EFIAPI
+CpuDeadLoop(VOID)
+{
+  abort();
+}
+
+VOID
+EFIAPI
+CpuPause(VOID)
+{
+  if (HostPauseYields) {
+    sched_yield();
+  } else {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__ ("yield");
+#endif
+  }
+}
+
+UINT64
+EFIAPI
+DivU64x32(
+  IN UINT64 Dividend,
+  IN UINT32 Divisor
+  )
+{
+  return Dividend / Divisor;
+}
+
+UINT64
+EFIAPI
+MultU64x32(
+  IN UINT64 Multiplicand,
+  IN UINT32 Multiplier
+  )
+{
+  return Multiplicand * Multiplier;
+}
+
+//
+// Nanosecond counter, counts up from 0 to MAX_UINT64
+//
+UINT64
+EFIAPI
+GetPerformanceCounter(VOID)
+{
+  struct timespec Ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+  return (UINT64) Ts.tv_sec * 1000000000ULL + Ts.tv_nsec;
+}
+
+UINT64
+EFIAPI
+GetPerformanceCounterProperties(
+  OUT UINT64 *StartValue,
+  OUT UINT64 *EndValue
+  )
+{
+  if (StartValue != NULL) {
+    *StartValue = 0;
+  }
+
+  if (EndValue != NULL) {
+    *EndValue = MAX_UINT64;
+  }
+
+  return 1000000000ULL;
+}
@@ -0,0 +1,526 @@
+/** @file
+  Thin stand-in for the parts of MdePkg/MdeModulePkg used by ARC platform
+  sources, so they can be compiled and measured on a Linux host.
+
+  Only definitions that are actually referenced are provided. Layouts of
+  on-flash structures match the PI specification.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#ifndef HOST_SHIM_H_
+#define HOST_SHIM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+//
+// Base types
+//
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef int8_t INT8;
+typedef int16_t INT16;
+typedef int32_t INT32;
+typedef int64_t INT64;
+typedef uintptr_t UINTN;
+typedef intptr_t INTN;
+typedef uint8_t BOOLEAN;
+typedef char CHAR8;
+typedef uint16_t CHAR16;
+typedef void VOID;
+
+#define IN
+#define OUT
+#define OPTIONAL
+#define CONST const
+#define STATIC static
+#define EFIAPI
+#define GLOBAL_REMOVE_IF_UNREFERENCED
+
+#define TRUE ((BOOLEAN) 1)
+#define FALSE ((BOOLEAN) 0)
+
+#define MAX_UINT8 ((UINT8) 0xff)
+#define MAX_UINT16 ((UINT16) 0xffff)
+#define MAX_UINT32 ((UINT32) 0xffffffff)
+#define MAX_UINT64 ((UINT64) 0xffffffffffffffffULL)
+#define MAX_BIT ((UINTN) 1 << (sizeof(UINTN) * 8 - 1))
+
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+#define BIT3 0x00000008
+#define BIT4 0x00000010
+#define BIT5 0x00000020
+#define BIT6 0x00000040
+#define BIT7 0x00000080
+#define BIT8 0x00000100
+#define BIT31 0x80000000
+
+#define SIGNATURE_16(A, B) ((A) | ((B) << 8))
+#define SIGNATURE_32(A, B, C, D) \
+  (SIGNATURE_16(A, B) | (SIGNATURE_16(C, D) << 16))
+
+#define ARRAY_SIZE(Array) (sizeof(Array) / sizeof((Array)[0]))
+#define OFFSET_OF(Type, Field) offsetof(Type, Field)
+#define BASE_CR(Record, Type, Field) \
+  ((Type *) ((CHAR8 *) (Record) - OFFSET_OF(Type, Field)))
+#define ALIGN_VALUE(Value, Alignment) \
+  ((Value) + (((Alignment) - (Value)) & ((Alignment) - 1)))
+
+#define ASSERT(Expression) assert(Expression)
+#define DEBUG(Expression)
+
+typedef VOID *VA_LIST_UNUSED;
+#define VA_LIST va_list
+
+//
+// Status codes
+//
+typedef UINTN RETURN_STATUS;
+typedef RETURN_STATUS EFI_STATUS;
+
+#define ENCODE_ERROR(StatusCode) ((RETURN_STATUS) (MAX_BIT | (StatusCode)))
+
+#define RETURN_SUCCESS 0
+#define RETURN_DEVICE_ERROR ENCODE_ERROR(7)
+
+#define EFI_SUCCESS 0
+#define EFI_LOAD_ERROR ENCODE_ERROR(1)
+#define EFI_INVALID_PARAMETER ENCODE_ERROR(2)
+#define EFI_UNSUPPORTED ENCODE_ERROR(3)
+#define EFI_BAD_BUFFER_SIZE ENCODE_ERROR(4)
+#define EFI_BUFFER_TOO_SMALL ENCODE_ERROR(5)
+#define EFI_NOT_READY ENCODE_ERROR(6)
+#define EFI_DEVICE_ERROR ENCODE_ERROR(7)
+#define EFI_WRITE_PROTECTED ENCODE_ERROR(8)
+#define EFI_OUT_OF_RESOURCES ENCODE_ERROR(9)
+#define EFI_VOLUME_CORRUPTED ENCODE_ERROR(10)
+#define EFI_VOLUME_FULL ENCODE_ERROR(11)
+#define EFI_NO_MEDIA ENCODE_ERROR(12)
+#define EFI_MEDIA_CHANGED ENCODE_ERROR(13)
+#define EFI_NOT_FOUND ENCODE_ERROR(14)
+#define EFI_ACCESS_DENIED ENCODE_ERROR(15)
+#define EFI_NO_RESPONSE ENCODE_ERROR(16)
+#define EFI_NO_MAPPING ENCODE_ERROR(17)
+#define EFI_TIMEOUT ENCODE_ERROR(18)
+#define EFI_NOT_STARTED ENCODE_ERROR(19)
+#define EFI_ALREADY_STARTED ENCODE_ERROR(20)
+#define EFI_ABORTED ENCODE_ERROR(21)
+#define EFI_ICMP_ERROR ENCODE_ERROR(22)
+#define EFI_TFTP_ERROR ENCODE_ERROR(23)
+#define EFI_PROTOCOL_ERROR ENCODE_ERROR(24)
+#define EFI_INCOMPATIBLE_VERSION ENCODE_ERROR(25)
+#define EFI_SECURITY_VIOLATION ENCODE_ERROR(26)
+#define EFI_CRC_ERROR ENCODE_ERROR(27)
+#define EFI_END_OF_MEDIA ENCODE_ERROR(28)
+#define EFI_END_OF_FILE ENCODE_ERROR(31)
+
+typedef struct {
+  UINT32 Data1;
+  UINT16 Data2;
+  UINT16 Data3;
+  UINT8 Data4[8];
+} GUID;
+
+typedef GUID EFI_GUID;
+typedef UINT64 EFI_PHYSICAL_ADDRESS;
+
+typedef struct {
+  UINT64 Signature;
+  UINT32 Revision;
+  UINT32 HeaderSize;
+  UINT32 CRC32;
+  UINT32 Reserved;
+} EFI_TABLE_HEADER;
+
+//
+// Firmware volume, see Pi/PiFirmwareVolume.h
+//
+typedef UINT32 EFI_FVB_ATTRIBUTES_2;
+
+typedef struct {
+  UINT32 NumBlocks;
+  UINT32 Length;
+} EFI_FV_BLOCK_MAP_ENTRY;
+
+typedef struct {
+  UINT8 ZeroVector[16];
+  EFI_GUID FileSystemGuid;
+  UINT64 FvLength;
+  UINT32 Signature;
+  EFI_FVB_ATTRIBUTES_2 Attributes;
+  UINT16 HeaderLength;
+  UINT16 Checksum;
+  UINT16 ExtHeaderOffset;
+  UINT8 Reserved[1];
+  UINT8 Revision;
+  EFI_FV_BLOCK_MAP_ENTRY BlockMap[1];
+} EFI_FIRMWARE_VOLUME_HEADER;
+
+#define EFI_FVH_SIGNATURE SIGNATURE_32('_', 'F', 'V', 'H')
+
+//
+// Firmware file, see Pi/PiFirmwareFile.h
+//
+typedef UINT8 EFI_FV_FILETYPE;
+typedef UINT8 EFI_FFS_FILE_ATTRIBUTES;
+typedef UINT8 EFI_FFS_FILE_STATE;
+typedef UINT8 EFI_SECTION_TYPE;
+typedef UINT32 EFI_FV_FILE_ATTRIBUTES;
+
+typedef union {
+  struct {
+    UINT8 Header;
+    UINT8 File;
+  } Checksum;
+  UINT16 Checksum16;
+} EFI_FFS_INTEGRITY_CHECK;
+
+typedef struct {
+  EFI_GUID Name;
+  EFI_FFS_INTEGRITY_CHECK IntegrityCheck;
+  EFI_FV_FILETYPE Type;
+  EFI_FFS_FILE_ATTRIBUTES Attributes;
+  UINT8 Size[3];
+  EFI_FFS_FILE_STATE State;
+} EFI_FFS_FILE_HEADER;
+
+#define EFI_FV_FILETYPE_ALL 0x00
+#define EFI_FV_FILETYPE_RAW 0x01
+#define EFI_FV_FILETYPE_FREEFORM 0x02
+#define EFI_FV_FILETYPE_SECURITY_CORE 0x03
+#define EFI_FV_FILETYPE_PEI_CORE 0x04
+#define EFI_FV_FILETYPE_DXE_CORE 0x05
+#define EFI_FV_FILETYPE_PEIM 0x06
+#define EFI_FV_FILETYPE_DRIVER 0x07
+#define EFI_FV_FILETYPE_FFS_PAD 0xf0
+
+#define FFS_ATTRIB_LARGE_FILE 0x01
+#define FFS_ATTRIB_CHECKSUM 0x40
+
+#define IS_FFS_FILE2(FfsFileHeaderPtr) \
+  (((((EFI_FFS_FILE_HEADER *) (UINTN) (FfsFileHeaderPtr))->Attributes) & \
+    FFS_ATTRIB_LARGE_FILE) == FFS_ATTRIB_LARGE_FILE)
+
+#define FFS_FILE_SIZE(FfsFileHeaderPtr) \
+  ((UINT32) (*((UINT32 *) ((EFI_FFS_FILE_HEADER *) (UINTN) \
+    (FfsFileHeaderPtr))->Size) & 0x00ffffff))
+
+typedef struct {
+  UINT8 Size[3];
+  EFI_SECTION_TYPE Type;
+} EFI_COMMON_SECTION_HEADER;
+
+#define SECTION_SIZE(SectionHeaderPtr) \
+  ((UINT32) (*((UINT32 *) ((EFI_COMMON_SECTION_HEADER *) (UINTN) \
+    (SectionHeaderPtr))->Size) & 0x00ffffff))
+
+#define EFI_SECTION_ALL 0x00
+#define EFI_SECTION_COMPRESSION 0x01
+#define EFI_SECTION_GUID_DEFINED 0x02
+#define EFI_SECTION_PE32 0x10
+#define EFI_SECTION_PIC 0x11
+#define EFI_SECTION_TE 0x12
+#define EFI_SECTION_DXE_DEPEX 0x13
+#define EFI_SECTION_VERSION 0x14
+#define EFI_SECTION_USER_INTERFACE 0x15
+#define EFI_SECTION_FREEFORM_SUBTYPE_GUID 0x18
+#define EFI_SECTION_RAW 0x19
+#define EFI_SECTION_PEI_DEPEX 0x1b
+
+typedef struct {
+  EFI_GUID FileNamesWithinVolume[1];
+} PEI_APRIORI_FILE_CONTENTS;
+
+//
+// TE image, see IndustryStandard/PeImage.h
+//
+typedef struct {
+  UINT32 VirtualAddress;
+  UINT32 Size;
+} EFI_IMAGE_DATA_DIRECTORY;
+
+typedef struct {
+  UINT16 Signature;
+  UINT16 Machine;
+  UINT8 NumberOfSections;
+  UINT8 Subsystem;
+  UINT16 StrippedSize;
+  UINT32 AddressOfEntryPoint;
+  UINT32 BaseOfCode;
+  UINT64 ImageBase;
+  EFI_IMAGE_DATA_DIRECTORY DataDirectory[2];
+} EFI_TE_IMAGE_HEADER;
+
+#define EFI_TE_IMAGE_HEADER_SIGNATURE SIGNATURE_16('V', 'Z')
+
+//
+// PEI services, see Pi/PiPeiCis.h
+//
+typedef VOID *EFI_PEI_FV_HANDLE;
+typedef VOID *EFI_PEI_FILE_HANDLE;
+
+typedef struct _EFI_PEI_SERVICES EFI_PEI_SERVICES;
+typedef struct _EFI_PEI_NOTIFY_DESCRIPTOR EFI_PEI_NOTIFY_DESCRIPTOR;
+
+#define EFI_PEI_PPI_DESCRIPTOR_PIC 0x00000001
+#define EFI_PEI_PPI_DESCRIPTOR_PPI 0x00000010
+#define EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK 0x00000020
+#define EFI_PEI_PPI_DESCRIPTOR_NOTIFY_DISPATCH 0x00000040
+#define EFI_PEI_PPI_DESCRIPTOR_NOTIFY_TYPES 0x00000060
+#define EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST 0x80000000
+
+typedef struct {
+  UINTN Flags;
+  EFI_GUID *Guid;
+  VOID *Ppi;
+} EFI_PEI_PPI_DESCRIPTOR;
+
+typedef
+EFI_STATUS
+(EFIAPI *EFI_PEIM_NOTIFY_ENTRY_POINT)(
+  IN EFI_PEI_SERVICES **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR *NotifyDescriptor,
+  IN VOID *Ppi
+  );
+
+struct _EFI_PEI_NOTIFY_DESCRIPTOR {
+  UINTN Flags;
+  EFI_GUID *Guid;
+  EFI_PEIM_NOTIFY_ENTRY_POINT Notify;
+};
+
+typedef struct {
+  EFI_GUID FileName;
+  EFI_FV_FILETYPE FileType;
+  EFI_FV_FILE_ATTRIBUTES FileAttributes;
+  VOID *Buffer;
+  UINT32 BufferSize;
+} EFI_FV_FILE_INFO;
+
+typedef EFI_STATUS (EFIAPI *EFI_PEI_INSTALL_PPI)(
+  IN CONST EFI_PEI_SERVICES **, IN CONST EFI_PEI_PPI_DESCRIPTOR *);
+typedef EFI_STATUS (EFIAPI *EFI_PEI_LOCATE_PPI)(
+  IN CONST EFI_PEI_SERVICES **, IN CONST EFI_GUID *, IN UINTN,
+  IN OUT EFI_PEI_PPI_DESCRIPTOR **, IN OUT VOID **);
+typedef EFI_STATUS (EFIAPI *EFI_PEI_NOTIFY_PPI)(
+  IN CONST EFI_PEI_SERVICES **, IN CONST EFI_PEI_NOTIFY_DESCRIPTOR *);
+typedef EFI_STATUS (EFIAPI *EFI_PEI_FFS_FIND_NEXT_VOLUME2)(
+  IN CONST EFI_PEI_SERVICES **, IN UINTN, IN OUT EFI_PEI_FV_HANDLE *);
+typedef EFI_STATUS (EFIAPI *EFI_PEI_FFS_FIND_NEXT_FILE2)(
+  IN CONST EFI_PEI_SERVICES **, IN EFI_FV_FILETYPE, IN CONST EFI_PEI_FV_HANDLE,
+  IN OUT EFI_PEI_FILE_HANDLE *);
+typedef EFI_STATUS (EFIAPI *EFI_PEI_FFS_FIND_SECTION_DATA2)(
+  IN CONST EFI_PEI_SERVICES **, IN EFI_SECTION_TYPE, IN EFI_PEI_FILE_HANDLE,
+  OUT VOID **);
+typedef EFI_STATUS (EFIAPI *EFI_PEI_FFS_GET_FILE_INFO)(
+  IN EFI_PEI_FILE_HANDLE, OUT EFI_FV_FILE_INFO *);
+
+struct _EFI_PEI_SERVICES {
+  EFI_TABLE_HEADER Hdr;
+  EFI_PEI_INSTALL_PPI InstallPpi;
+  VOID *ReInstallPpi;
+  EFI_PEI_LOCATE_PPI LocatePpi;
+  EFI_PEI_NOTIFY_PPI NotifyPpi;
+  VOID *GetBootMode;
+  VOID *SetBootMode;
+  VOID *GetHobList;
+  VOID *CreateHob;
+  EFI_PEI_FFS_FIND_NEXT_VOLUME2 FfsFindNextVolume;
+  EFI_PEI_FFS_FIND_NEXT_FILE2 FfsFindNextFile;
+  EFI_PEI_FFS_FIND_SECTION_DATA2 FfsFindSectionData;
+  VOID *InstallPeiMemory;
+  VOID *AllocatePages;
+  VOID *AllocatePool;
+  VOID *CopyMem;
+  VOID *SetMem;
+  VOID *ReportStatusCode;
+  VOID *ResetSystem;
+  VOID *CpuIo;
+  VOID *PciCfg;
+  VOID *FfsFindFileByName;
+  EFI_PEI_FFS_GET_FILE_INFO FfsGetFileInfo;
+  VOID *FfsGetVolumeInfo;
+  VOID *RegisterForShadow;
+  VOID *FindSectionData3;
+  VOID *FfsGetFileInfo2;
+  VOID *ResetSystem2;
+  VOID *FreePages;
+};
+
+#define PEI_SERVICES_SIGNATURE 0x5652455320494550ULL
+#define PEI_SERVICES_REVISION ((1 << 16) | 80)
+
+typedef
+EFI_STATUS
+(EFIAPI *EFI_PEIM_ENTRY_POINT2)(
+  IN EFI_PEI_FILE_HANDLE FileHandle,
+  IN CONST EFI_PEI_SERVICES **PeiServices
+  );
+
+typedef struct {
+  UINT16 DataSize;
+  EFI_PHYSICAL_ADDRESS BootFirmwareVolumeBase;
+  UINTN BootFirmwareVolumeSize;
+  VOID *TemporaryRamBase;
+  UINTN TemporaryRamSize;
+  VOID *PeiTemporaryRamBase;
+  UINTN PeiTemporaryRamSize;
+  VOID *StackBase;
+  UINTN StackSize;
+} EFI_SEC_PEI_HAND_OFF;
+
+//
+// HOBs, see Pi/PiHob.h
+//
+typedef struct {
+  UINT16 HobType;
+  UINT16 HobLength;
+  UINT32 Reserved;
+} EFI_HOB_GENERIC_HEADER;
+
+typedef union {
+  EFI_HOB_GENERIC_HEADER *Header;
+  UINT8 *Raw;
+} EFI_PEI_HOB_POINTERS;
+
+//
+// DXE IPL PPI, see Ppi/DxeIpl.h
+//
+typedef struct _EFI_DXE_IPL_PPI EFI_DXE_IPL_PPI;
+
+typedef
+EFI_STATUS
+(EFIAPI *EFI_DXE_IPL_ENTRY)(
+  IN CONST EFI_DXE_IPL_PPI *This,
+  IN EFI_PEI_SERVICES **PeiServices,
+  IN EFI_PEI_HOB_POINTERS HobList
+  );
+
+struct _EFI_DXE_IPL_PPI {
+  EFI_DXE_IPL_ENTRY Entry;
+};
+
+//
+// PEI core private data, see MdeModulePkg/Core/Pei/PeiMain.h
+//
+typedef union {
+  EFI_PEI_PPI_DESCRIPTOR *Ppi;
+  EFI_PEI_NOTIFY_DESCRIPTOR *Notify;
+  VOID *Raw;
+} PEI_PPI_LIST_POINTERS;
+
+typedef struct {
+  UINTN CurrentCount;
+  UINTN MaxCount;
+  UINTN LastDispatchedCount;
+  PEI_PPI_LIST_POINTERS *PpiPtrs;
+} PEI_PPI_LIST;
+
+typedef struct {
+  UINTN CurrentCount;
+  UINTN MaxCount;
+  PEI_PPI_LIST_POINTERS *NotifyPtrs;
+} PEI_CALLBACK_NOTIFY_LIST;
+
+typedef struct {
+  UINTN CurrentCount;
+  UINTN MaxCount;
+  UINTN LastDispatchedCount;
+  PEI_PPI_LIST_POINTERS *NotifyPtrs;
+} PEI_DISPATCH_NOTIFY_LIST;
+
+typedef struct {
+  PEI_PPI_LIST PpiList;
+  PEI_CALLBACK_NOTIFY_LIST CallbackNotifyList;
+  PEI_DISPATCH_NOTIFY_LIST DispatchNotifyList;
+} PEI_PPI_DATABASE;
+
+typedef struct {
+  EFI_FIRMWARE_VOLUME_HEADER *FvHeader;
+  VOID *FvPpi;
+  EFI_PEI_FV_HANDLE FvHandle;
+  UINTN PeimCount;
+  UINT8 *PeimState;
+  EFI_PEI_FILE_HANDLE *FvFileHandles;
+  BOOLEAN ScanFv;
+  UINT32 AuthenticationStatus;
+} PEI_CORE_FV_HANDLE;
+
+EFI_STATUS EFIAPI PeiInstallPpi(
+  IN CONST EFI_PEI_SERVICES **, IN CONST EFI_PEI_PPI_DESCRIPTOR *);
+EFI_STATUS EFIAPI PeiLocatePpi(
+  IN CONST EFI_PEI_SERVICES **, IN CONST EFI_GUID *, IN UINTN,
+  IN OUT EFI_PEI_PPI_DESCRIPTOR **, IN OUT VOID **);
+EFI_STATUS EFIAPI PeiNotifyPpi(
+  IN CONST EFI_PEI_SERVICES **, IN CONST EFI_PEI_NOTIFY_DESCRIPTOR *);
+EFI_STATUS EFIAPI PeiFfsFindNextVolume(
+  IN CONST EFI_PEI_SERVICES **, IN UINTN, IN OUT EFI_PEI_FV_HANDLE *);
+EFI_STATUS EFIAPI PeiFfsFindNextFile(
+  IN CONST EFI_PEI_SERVICES **, IN EFI_FV_FILETYPE, IN CONST EFI_PEI_FV_HANDLE,
+  IN OUT EFI_PEI_FILE_HANDLE *);
+EFI_STATUS EFIAPI PeiFfsFindSectionData(
+  IN CONST EFI_PEI_SERVICES **, IN EFI_SECTION_TYPE, IN EFI_PEI_FILE_HANDLE,
+  OUT VOID **);
+EFI_STATUS EFIAPI PeiFfsGetFileInfo(
+  IN EFI_PEI_FILE_HANDLE, OUT EFI_FV_FILE_INFO *);
+
+//
+// Dependency expression opcodes, see Pi/PiDependency.h
+//
+#define EFI_DEP_BEFORE 0x00
+#define EFI_DEP_AFTER 0x01
+#define EFI_DEP_PUSH 0x02
+#define EFI_DEP_AND 0x03
+#define EFI_DEP_OR 0x04
+#define EFI_DEP_NOT 0x05
+#define EFI_DEP_TRUE 0x06
+#define EFI_DEP_FALSE 0x07
+#define EFI_DEP_END 0x08
+#define EFI_DEP_SOR 0x09
+
+#define STATIC_ASSERT _Static_assert
+
+//
+// SynchronizationLib, see Library/SynchronizationLib.h
+//
+typedef volatile UINTN SPIN_LOCK;
+
+//
+// CpuPause() yields the host CPU when set, so that spinning threads let
+// preempted lock holders run when there are more threads than CPUs
+//
+extern BOOLEAN HostPauseYields;
+
+//
+// Library functions provided by HostShim.c
+//
+VOID *EFIAPI CopyMem(OUT VOID *, IN CONST VOID *, IN UINTN);
+VOID *EFIAPI SetMem(OUT VOID *, IN UINTN, IN UINT8);
+VOID *EFIAPI ZeroMem(OUT VOID *, IN UINTN);
+BOOLEAN EFIAPI CompareGuid(IN CONST GUID *, IN CONST GUID *);
+GUID *EFIAPI CopyGuid(OUT GUID *, IN CONST GUID *);
+INTN EFIAPI LowBitSet32(IN UINT32);
+UINT32 EFIAPI CalculateSum32(IN CONST UINT32 *, IN UINTN);
+UINTN EFIAPI AsciiSPrint(OUT CHAR8 *, IN UINTN, IN CONST CHAR8 *, ...);
+UINTN EFIAPI SerialPortWrite(IN UINT8 *, IN UINTN);
+RETURN_STATUS EFIAPI SerialPortInitialize(VOID);
+VOID EFIAPI CpuDeadLoop(VOID);
+VOID EFIAPI CpuPause(VOID);
+UINT64 EFIAPI DivU64x32(IN UINT64, IN UINT32);
+UINT64 EFIAPI MultU64x32(IN UINT64, IN UINT32);
+UINT64 EFIAPI GetPerformanceCounter(VOID);
+UINT64 EFIAPI GetPerformanceCounterProperties(OUT UINT64 *, OUT UINT64 *);
+
+#endif // HOST_SHIM_H_
@@ -0,0 +1,158 @@
+/** @file
+  Host stand-in for ARCv2 atomic primitives (CpuLib/Arc2Sync.c) and CPU info
+  used by CpuLib/CpuSync.c, built on compiler atomics. Sequentially
+  consistent atomics are full barriers, as the ARC ones are. Built for ARC
+  Linux, e.g. to run benchmarks under QEMU user mode, the ARC primitives
+  are used instead and only CPU info comes from here.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <unistd.h>
+#include <HostShim.h>
+#include <Library/ArcCpuInfoLib.h>
+#include "CpuSyncInternals.h"
+
+#ifndef __arc__
+
+#define SEQ_CST __ATOMIC_SEQ_CST
+
+VOID
+EFIAPI
+InternalSyncMemoryBarrier(VOID)
+{
+  __atomic_thread_fence(SEQ_CST);
+}
+
+UINT16
+EFIAPI
+InternalSyncCompareExchange16(
+  IN volatile UINT16 *Value,
+  IN UINT16 CompareValue,
+  IN UINT16 ExchangeValue
+  )
+{
+  __atomic_compare_exchange_n(Value, &CompareValue, ExchangeValue, FALSE,
+    SEQ_CST, SEQ_CST);
+  return CompareValue;
+}
+
+UINT32
+EFIAPI
+InternalSyncCompareExchange32(
+  IN volatile UINT32 *Value,
+  IN UINT32 CompareValue,
+  IN UINT32 ExchangeValue
+  )
+{
+  __atomic_compare_exchange_n(Value, &CompareValue, ExchangeValue, FALSE,
+    SEQ_CST, SEQ_CST);
+  return CompareValue;
+}
+
+UINT64
+EFIAPI
+InternalSyncCompareExchange64(
+  IN volatile UINT64 *Value,
+  IN UINT64 CompareValue,
+  IN UINT64 ExchangeValue
+  )
+{
+  __atomic_compare_exchange_n(Value, &CompareValue, ExchangeValue, FALSE,
+    SEQ_CST, SEQ_CST);
+  return CompareValue;
+}
+
+UINT32
+EFIAPI
+InternalSyncFetchAdd32(
+  IN volatile UINT32 *Value,
+  IN UINT32 Addend
+  )
+{
+  return __atomic_fetch_add(Value, Addend, SEQ_CST);
+}
+
+UINT32
+EFIAPI
+InternalSyncFetchAnd32(
+  IN volatile UINT32 *Value,
+  IN UINT32 AndData
+  )
+{
+  return __atomic_fetch_and(Value, AndData, SEQ_CST);
+}
+
+UINT32
+EFIAPI
+InternalSyncFetchOr32(
+  IN volatile UINT32 *Value,
+  IN UINT32 OrData
+  )
+{
+  return __atomic_fetch_or(Value, OrData, SEQ_CST);
+}
+
+UINT32
+EFIAPI
+InternalSyncExchange32(
+  IN volatile UINT32 *Value,
+  IN UINT32 ExchangeValue
+  )
+{
+  return __atomic_exchange_n(Value, ExchangeValue, SEQ_CST);
+}
+
+VOID *
+EFIAPI
+InternalSyncExchangePointer(
+  IN VOID *volatile *Value,
+  IN VOID *ExchangeValue
+  )
+{
+  return __atomic_exchange_n(Value, ExchangeValue, SEQ_CST);
+}
+
+UINT32
+EFIAPI
+InternalSyncIncrement(
+  IN volatile UINT32 *Value
+  )
+{
+  return __atomic_add_fetch(Value, 1, SEQ_CST);
+}
+
+UINT32
+EFIAPI
+InternalSyncDecrement(
+  IN volatile UINT32 *Value
+  )
+{
+  return __atomic_sub_fetch(Value, 1, SEQ_CST);
+}
+
+#endif // __arc__
+
+//
+// Host L1 data cache line, for GetSpinLockProperties()
+//
+BOOLEAN
+GetArcDCacheInfo(
+  OUT ARC_CACHE_INFO *Info
+  )
+{
+  long LineSize;
+  long Size;
+
+  LineSize = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+  Size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  Info->Size = Size > 0 ? (UINT32) Size : 0;
+  Info->LineSize = LineSize > 0 ? (UINT32) LineSize : 64;
+  Info->Ways = 0;
+  Info->Version = 0;
+  return TRUE;
+}
@@ -0,0 +1,2 @@
+// Redirected to host shim
+#include <HostShim.h>
@@ -0,0 +1,21 @@
+//
+// Part of MdePkg SynchronizationLib interface implemented by
+// Platform/ARC/Library/CpuLib/CpuSync.c
+//
+#include <HostShim.h>
+
+UINTN EFIAPI GetSpinLockProperties(VOID);
+SPIN_LOCK *EFIAPI InitializeSpinLock(OUT SPIN_LOCK *);
+SPIN_LOCK *EFIAPI AcquireSpinLock(IN OUT SPIN_LOCK *);
+BOOLEAN EFIAPI AcquireSpinLockOrFail(IN OUT SPIN_LOCK *);
+SPIN_LOCK *EFIAPI ReleaseSpinLock(IN OUT SPIN_LOCK *);
+UINT32 EFIAPI InterlockedIncrement(IN volatile UINT32 *);
+UINT32 EFIAPI InterlockedDecrement(IN volatile UINT32 *);
+UINT16 EFIAPI InterlockedCompareExchange16(
+  IN OUT volatile UINT16 *, IN UINT16, IN UINT16);
+UINT32 EFIAPI InterlockedCompareExchange32(
+  IN OUT volatile UINT32 *, IN UINT32, IN UINT32);
+UINT64 EFIAPI InterlockedCompareExchange64(
+  IN OUT volatile UINT64 *, IN UINT64, IN UINT64);
+VOID *EFIAPI InterlockedCompareExchangePointer(
+  IN OUT VOID *volatile *, IN VOID *, IN VOID *);
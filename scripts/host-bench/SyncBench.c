@@ -0,0 +1,225 @@
+/** @file
+  Host contention benchmark for spin locks and atomics of ARC
+  SynchronizationLib (Platform/ARC/Library/CpuLib/CpuSync.c and CpuLock.c).
+
+  Lock code is built as is on top of host stand-in atomics (Shim/HostSync.c)
+  and hammered by 1 up to 64 threads (Shim/BenchHarness.c), each taking the
+  lock, updating shared data and releasing it for a fixed time. Every
+  critical section checks it is alone in there and the shared counter is
+  compared against the number of acquisitions at the end, so the benchmark
+  doubles as a mutual exclusion test. Results are printed as JSON lines, one
+  per lock and thread count.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <HostShim.h>
+#include <BenchHarness.h>
+#include <Library/SynchronizationLib.h>
+#include <ArcSyncLib.h>
+
+typedef struct {
+  CONST CHAR8 *Name;
+  VOID (*Init)(VOID);
+  VOID (*Acquire)(MCS_LOCK_NODE *Node); // NULL for lock free counter
+  VOID (*Release)(MCS_LOCK_NODE *Node);
+} LOCK_KIND;
+
+STATIC SPIN_LOCK mSpinLock LINE_ALIGNED;
+STATIC TICKET_LOCK mTicketLock;
+STATIC MCS_LOCK mMcsLock;
+
+//
+// Data guarded by the lock under test, on its own line. Volatile, so that
+// the compiler keeps every access of CriticalSection() and a broken lock
+// shows up as violations.
+//
+STATIC volatile struct {
+  UINT64 Counter;
+  UINT32 Holder; // Worker Id + 1, 0 when nobody is in critical section
+  UINT32 Violations;
+} LINE_ALIGNED mShared;
+
+STATIC volatile UINT32 mAtomicCounter LINE_ALIGNED;
+
+STATIC CONST LOCK_KIND *mKind;
+STATIC UINT32 mWork; // Extra iterations spent in critical section
+
+STATIC VOID SpinInit(VOID) { InitializeSpinLock(&mSpinLock); }
+STATIC VOID SpinAcquire(MCS_LOCK_NODE *Node) { AcquireSpinLock(&mSpinLock); }
+STATIC VOID SpinRelease(MCS_LOCK_NODE *Node) { ReleaseSpinLock(&mSpinLock); }
+
+STATIC VOID TicketInit(VOID) { InitializeTicketLock(&mTicketLock); }
+STATIC VOID TicketAcquire(MCS_LOCK_NODE *Node) { AcquireTicketLock(&mTicketLock); }
+STATIC VOID TicketRelease(MCS_LOCK_NODE *Node) { ReleaseTicketLock(&mTicketLock); }
+
+STATIC VOID McsInit(VOID) { InitializeMcsLock(&mMcsLock); }
+STATIC VOID McsAcquire(MCS_LOCK_NODE *Node) { AcquireMcsLock(&mMcsLock, Node); }
+STATIC VOID McsRelease(MCS_LOCK_NODE *Node) { ReleaseMcsLock(&mMcsLock, Node); }
+
+STATIC VOID FetchAddInit(VOID) { mAtomicCounter = 0; }
+
+STATIC CONST LOCK_KIND mKinds[] = {
+  { "spin", SpinInit, SpinAcquire, SpinRelease },
+  { "ticket", TicketInit, TicketAcquire, TicketRelease },
+  { "mcs", McsInit, McsAcquire, McsRelease },
+  { "fetch-add", FetchAddInit, NULL, NULL },
+};
+
+STATIC
+VOID
+CriticalSection(
+  IN UINT32 Id
+  )
+{
+  volatile UINT32 Work;
+
+  if (mShared.Holder != 0) {
+    mShared.Violations++;
+  }
+
+  mShared.Holder = Id + 1;
+  mShared.Counter++;
+  for (Work = 0; Work < mWork; Work++) {
+  }
+
+  if (mShared.Holder != Id + 1) {
+    mShared.Violations++;
+  }
+
+  mShared.Holder = 0;
+}
+
+STATIC
+VOID
+Worker(
+  IN BENCH_WORKER *Self
+  )
+{
+  MCS_LOCK_NODE Node;
+  UINT64 Ops;
+
+  for (Ops = 0; !BENCH_STOPPED(); Ops++) {
+    if (mKind->Acquire == NULL) {
+      InterlockedFetchAdd32(&mAtomicCounter, 1);
+      continue;
+    }
+
+    mKind->Acquire(&Node);
+    CriticalSection(Self->Id);
+    mKind->Release(&Node);
+  }
+
+  Self->Ops = Ops;
+}
+
+STATIC
+BOOLEAN
+Measure(
+  IN CONST VOID *Item,
+  IN UINT32 Threads,
+  IN UINT32 DurationMs
+  )
+{
+  STATIC BENCH_WORKER Workers[BENCH_MAX_THREADS];
+  CONST LOCK_KIND *Kind;
+  UINT64 Ns;
+  UINT64 Total;
+  UINT64 Min;
+  UINT64 Max;
+  BOOLEAN Ok;
+  UINT32 Idx;
+
+  Kind = Item;
+  mKind = Kind;
+  memset((VOID *) &mShared, 0, sizeof(mShared));
+  Kind->Init();
+
+  Ns = BenchRun(Worker, Workers, Threads, DurationMs);
+
+  Total = 0;
+  Min = MAX_UINT64;
+  Max = 0;
+  for (Idx = 0; Idx < Threads; Idx++) {
+    Total += Workers[Idx].Ops;
+    Min = Workers[Idx].Ops < Min ? Workers[Idx].Ops : Min;
+    Max = Workers[Idx].Ops > Max ? Workers[Idx].Ops : Max;
+  }
+
+  if (Kind->Acquire == NULL) {
+    Ok = mAtomicCounter == (UINT32) Total;
+  } else {
+    Ok = mShared.Violations == 0 && mShared.Counter == Total;
+  }
+
+  printf("{\"bench\": \"sync\", \"lock\": \"%s\", \"threads\": %u, "
+    "\"ops\": %lu, \"ns\": %lu, \"mops_per_s\": %.3f, \"ns_per_op\": %.2f, "
+    "\"fairness\": %.3f, \"pause_yields\": %s, \"ok\": %s}\n",
+    Kind->Name, Threads, (unsigned long) Total, (unsigned long) Ns,
+    Ns ? 1000.0 * Total / Ns : 0, Total ? (double) Ns / Total : 0,
+    Max ? (double) Min / Max : 0, HostPauseYields ? "true" : "false",
+    Ok ? "true" : "false");
+  fflush(stdout);
+  return Ok;
+}
+
+STATIC
+BOOLEAN
+ParseOption(
+  IN int Opt,
+  IN CONST CHAR8 *Arg
+  )
+{
+  if (Opt != 'w') {
+    return FALSE;
+  }
+
+  mWork = strtoul(Arg, NULL, 0);
+  return TRUE;
+}
+
+int
+main(
+  int Argc,
+  char **Argv
+  )
+{
+  BENCH_OPTIONS Options;
+  BOOLEAN Ok;
+  UINTN Idx;
+
+  mWork = 0;
+  BenchParseOptions(Argc, Argv, 'l', "w:", ParseOption,
+    "Usage: %s [-t 64] [-d 200] [-w 0] [-l spin,ticket,mcs,fetch-add]\n"
+    "  -t  largest number of threads, runs 1, 2, 4, ... up to it\n"
+    "  -d  milliseconds per measurement\n"
+    "  -w  busy loop iterations inside critical section\n"
+    "  -l  comma separated locks to measure\n",
+    &Options);
+
+  fprintf(stderr, "> spin lock alignment %lu, %ld CPUs\n",
+    (unsigned long) GetSpinLockProperties(),
+    sysconf(_SC_NPROCESSORS_ONLN));
+
+  Ok = TRUE;
+  for (Idx = 0; Idx < ARRAY_SIZE(mKinds); Idx++) {
+    Ok &= BenchSweep(&Options, mKinds[Idx].Name, 1, BENCH_MAX_THREADS,
+      Measure, &mKinds[Idx]);
+  }
+
+  if (!Ok) {
+    fprintf(stderr, "! mutual exclusion violated or operations lost\n");
+  }
+
+  return Ok ? 0 : 1;
+}
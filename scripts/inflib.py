@@ -0,0 +1,136 @@
+#
+# Minimal FDF, INF and DEC parser shared by build helper scripts.
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import os
+import re
+import struct
+
+PRODUCES = ('PRODUCES', 'SOMETIMES_PRODUCES')
+NOTIFIES = ('NOTIFY', 'SOMETIMES_NOTIFY')
+
+
+def strip_comment(line):
+    return line.split('#', 1)[0].strip()
+
+
+def read_lines(path):
+    with open(path) as f:
+        return [line.strip() for line in f]
+
+
+def sections(path):
+    """Yield (section, line) pairs, section names are lower case without
+    architecture suffix."""
+    section = None
+    for line in read_lines(path):
+        match = re.match(r'^\[(.+)\]$', strip_comment(line))
+        if match:
+            section = match.group(1).split('.')[0].lower()
+            continue
+        if strip_comment(line):
+            yield section, line
+
+
+def find_file(path):
+    """Resolve package relative path against WORKSPACE and PACKAGES_PATH."""
+    roots = [os.environ.get('WORKSPACE', '.')]
+    roots += os.environ.get('PACKAGES_PATH', '').split(os.pathsep)
+    for root in roots:
+        full = os.path.join(root, path)
+        if os.path.isfile(full):
+            return full
+    return None
+
+
+def build_output_inf(build_dir, path):
+    """INF file of module whose build output file is given, build output
+    mirrors package relative INF path, e.g. <build-dir>/<dir>/<name>/DEBUG/
+    <name>.debug is built from <dir>/<name>.inf."""
+    rel = os.path.relpath(os.path.dirname(os.path.dirname(path)), build_dir)
+    parts = rel.split(os.sep)
+    for idx in range(len(parts)):
+        full = find_file(os.path.join(*parts[idx:]) + '.inf')
+        if full is not None:
+            return full
+    return None
+
+
+def fv_inf_paths(fdf, fv_names):
+    """INF files listed in given FV sections, each one only once."""
+    paths = []
+    section = None
+    for line in read_lines(fdf):
+        entry = strip_comment(line)
+        match = re.match(r'^\[(.+)\]$', entry)
+        if match:
+            section = match.group(1)
+            continue
+        if section not in ['FV.' + name for name in fv_names]:
+            continue
+        match = re.match(r'^INF\s+(?:.*\s)?(\S+\.inf)$', entry)
+        if match and match.group(1) not in paths:  # APRIORI lists INF twice
+            paths.append(match.group(1))
+    return paths
+
+
+class Inf:
+    def __init__(self, path):
+        self.path = path
+        self.module_type = None
+        self.file_guid = None
+        self.packages = []
+        self.ppis = []  # (cname, usage), usage is None when not annotated
+
+        for section, line in sections(path):
+            entry = strip_comment(line)
+            if section == 'defines':
+                match = re.match(r'^(\w+)\s*=\s*(\S+)$', entry)
+                if match and match.group(1) == 'MODULE_TYPE':
+                    self.module_type = match.group(2)
+                elif match and match.group(1) == 'FILE_GUID':
+                    self.file_guid = match.group(2)
+            elif section == 'packages':
+                self.packages.append(entry)
+            elif section == 'ppis':
+                usage = line.split('##', 1)[1].split() if '##' in line else []
+                self.ppis.append((entry.split('|')[0].strip(),
+                                  usage[0] if usage else None))
+
+    def produced_ppis(self):
+        """PPIs without usage comment are counted as produced."""
+        return [name for name, usage in self.ppis
+                if usage is None or usage in PRODUCES]
+
+    def notified_ppis(self):
+        return [name for name, usage in self.ppis if usage in NOTIFIES]
+
+
+def dec_guids(path):
+    """Map of GUID C names to GUID bytes declared in DEC file."""
+    guids = {}
+    for section, line in sections(path):
+        if section not in ('guids', 'ppis', 'protocols'):
+            continue
+        match = re.match(r'^(\w+)\s*=\s*(\{.*\})', strip_comment(line))
+        if not match:
+            continue
+        vals = [int(v, 16) for v in re.findall(r'0x[0-9a-fA-F]+', match.group(2))]
+        if len(vals) == 11:
+            guids[match.group(1)] = struct.pack('<IHH8B', *vals)
+    return guids
+
+
+def package_guids(inf):
+    guids = {}
+    for package in inf.packages:
+        dec = find_file(package)
+        if dec is not None:
+            guids.update(dec_guids(dec))
+    return guids
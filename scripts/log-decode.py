@@ -0,0 +1,302 @@
+#!/usr/bin/env python3
+#
+# Binary log ring decoder.
+#
+# Rebuilds LOG() messages from a log ring dump. Format strings are taken
+# from .logfmt sections of module .debug images, where each entry is the
+# address of logging site anchor followed by the format string. Records
+# refer to sites by runtime anchor address, which is mapped to an image by
+# FD layout.
+# Strings and GUIDs passed by pointer are read from FD image, pointers to
+# anything else are printed as is. Record layout matches LOG_RING in
+# Platform/ARC/Include/Library/UtilsLib.h.
+#
+# Dump is either a raw copy of the ring memory (PcdLogRingBase/Size) or
+# console output containing "@log" lines written by LogDump().
+#
+# Usage:
+#   log-decode.py <build-dir> <image.fd> <dump> [fd-base]
+#
+#   build-dir  directory to search for .debug images, e.g.
+#              $WORKSPACE/Build/hs4x/DEBUG_GCC/ARC2
+#   fd-base    address FD is visible at during boot (default 0)
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import os
+import re
+import struct
+import sys
+
+import fvlib
+import inflib
+
+LOG_RING_SIGNATURE = b'LRNG'
+LOG_RING_HEADER = '<4sIII'
+LOG_RECORD_MAGIC = 0x4c4f4700
+LOG_MAX_ARGS = 8
+
+# Conversions of MdePkg/Include/Library/PrintLib.h
+FORMAT_RE = re.compile(r'%([-+ 0#,]*)(\d+|\*)?(?:\.(\d+|\*))?[lL]?(.)')
+
+STATUS_NAMES = {
+    0: 'Success',
+    1: 'Load Error',
+    2: 'Invalid Parameter',
+    3: 'Unsupported',
+    4: 'Bad Buffer Size',
+    5: 'Buffer Too Small',
+    6: 'Not Ready',
+    7: 'Device Error',
+    8: 'Write Protected',
+    9: 'Out of Resources',
+    10: 'Volume Corrupt',
+    11: 'Volume Full',
+    12: 'No Media',
+    13: 'Media changed',
+    14: 'Not Found',
+    15: 'Access Denied',
+    21: 'Aborted',
+    25: 'Security Violation',
+}
+
+
+def elf_section(path, name):
+    """Contents of named section of ELF file, None if there is none."""
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF':
+        raise ValueError('%s is not ELF file' % path)
+
+    if elf[4] == 1:  # ELFCLASS32
+        shoff, = struct.unpack_from('<I', elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2e)
+        shdr = '<IIIIII'
+    else:
+        shoff, = struct.unpack_from('<Q', elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x3a)
+        shdr = '<IIQQQQ'
+
+    headers = [struct.unpack_from(shdr, elf, shoff + idx * shentsize)
+               for idx in range(shnum)]
+    strtab = headers[shstrndx]
+    for (name_off, _, _, _, offset, size) in headers:
+        pos = strtab[4] + name_off
+        if elf[pos:elf.index(b'\0', pos)].decode() == name:
+            return elf[offset:offset + size], elf[4] == 1
+    return None, True
+
+
+def log_formats(path):
+    """Map of logging site anchor addresses to format strings."""
+    data, elf32 = elf_section(path, '.logfmt')
+    formats = {}
+    if data is None:
+        return formats
+
+    site_size = 4 if elf32 else 8
+    pos = 0
+    while pos + site_size < len(data):
+        site, = struct.unpack_from('<I' if elf32 else '<Q', data, pos)
+        end = data.index(b'\0', pos + site_size)
+        formats[site] = data[pos + site_size:end].decode(errors='replace')
+        pos = fvlib.align(end + 1, site_size)
+        # Compiler may align entries further, sites are never zero
+        while data[pos:pos + site_size] == b'\0' * site_size:
+            pos += site_size
+    return formats
+
+
+def collect_formats(build_dir):
+    """Map of module file GUIDs to their format maps."""
+    modules = {}
+    for root, _, files in os.walk(build_dir):
+        if os.path.basename(root) != 'DEBUG':
+            continue
+        for name in files:
+            if not name.endswith('.debug'):
+                continue
+            path = os.path.join(root, name)
+            inf = inflib.build_output_inf(build_dir, path)
+            if inf is None:
+                print('! no INF file for %s' % path, file=sys.stderr)
+                continue
+            guid = inflib.Inf(inf).file_guid
+            if guid is not None:
+                modules[fvlib.guid_bytes(guid)] = log_formats(path)
+    return modules
+
+
+def load_dump(path):
+    """Ring header fields and record area words."""
+    with open(path, 'rb') as f:
+        raw = f.read()
+
+    if raw[:4] != LOG_RING_SIGNATURE:
+        words = []
+        for line in raw.decode(errors='replace').splitlines():
+            pos = line.find('@log ')
+            if pos >= 0:
+                words += [int(word, 16) for word in line[pos + 5:].split()]
+        raw = struct.pack('<%uI' % len(words), *words)
+
+    hdr_size = struct.calcsize(LOG_RING_HEADER)
+    if len(raw) < hdr_size:
+        raise ValueError('no log ring in %s' % path)
+    sig, size, head, lap = struct.unpack_from(LOG_RING_HEADER, raw)
+    if sig != LOG_RING_SIGNATURE:
+        raise ValueError('bad log ring signature in %s' % path)
+
+    area = raw[hdr_size:hdr_size + size]
+    words = list(struct.unpack('<%uI' % (len(area) // 4), area[:len(area) & ~3]))
+    return head, lap, words
+
+
+def records(head, lap, words):
+    """Yield (site, args) of records from oldest to newest."""
+    head //= 4
+    if lap == 0:
+        order = [(0, head)]
+    else:
+        # Area after head holds previous lap, whose first record may be
+        # overwritten partially, so look for the next record start
+        order = [(head, len(words)), (0, head)]
+
+    for (start, end) in order:
+        pos = start
+        while pos < end:
+            word = words[pos]
+            if word & ~0xff != LOG_RECORD_MAGIC or (word & 0xff) > LOG_MAX_ARGS:
+                if word == 0 and start == 0:
+                    break  # Writer wrapped here
+                pos += 1
+                continue
+            count = word & 0xff
+            if pos + 2 + count > end:
+                break
+            yield words[pos + 1], words[pos + 2:pos + 2 + count]
+            pos += 2 + count
+
+
+class Decoder:
+    def __init__(self, fd, fd_base, images, modules):
+        self.fd = fd
+        self.fd_base = fd_base
+        self.images = images
+        self.modules = modules
+
+    def read(self, addr, size):
+        offset = addr - self.fd_base
+        if offset < 0 or offset + size > len(self.fd):
+            return None
+        return bytes(self.fd[offset:offset + size])
+
+    def read_str(self, addr, char_size):
+        offset = addr - self.fd_base
+        if offset < 0 or offset >= len(self.fd):
+            return None
+        term = b'\0' * char_size
+        end = offset
+        while end + char_size <= len(self.fd) and \
+                self.fd[end:end + char_size] != term:
+            end += char_size
+        raw = bytes(self.fd[offset:end])
+        return raw.decode('ascii' if char_size == 1 else 'utf-16-le',
+                          errors='replace')
+
+    def format_for(self, site):
+        for (base, end, name) in self.images:
+            if base <= site < end:
+                return self.modules.get(name, {}).get(site - base)
+        return None
+
+    def convert(self, conv, flags, width, val):
+        if conv in 'aAsS':
+            text = self.read_str(val, 1 if conv in 'aA' else 2)
+            if text is None:
+                return '<%s@0x%x>' % (conv, val)
+            return text
+        if conv == 'g':
+            raw = self.read(val, 16)
+            if raw is None:
+                return '<g@0x%x>' % val
+            return fvlib.guid_str(raw)
+        if conv == 'r':
+            if val == 0 or val & 0x80000000:
+                name = STATUS_NAMES.get(val & 0x7fffffff)
+                if name is not None:
+                    return name
+            return '0x%08x' % val
+        if conv == 'c':
+            return chr(val & 0xffff)
+
+        pad = '0' if '0' in flags or conv in 'Xp' else ' '
+        if conv == 'p':
+            width = width or 8
+        if conv in 'xXp':
+            text = '%X' % val
+        elif conv in 'di':
+            text = '%d' % (val - (1 << 32) if val & 0x80000000 else val)
+        else:
+            text = '%u' % val
+        if '-' in flags:
+            return text.ljust(width)
+        return text.rjust(width, pad)
+
+    def render(self, fmt, args):
+        args = list(args)
+        out = []
+        pos = 0
+        for match in FORMAT_RE.finditer(fmt):
+            out.append(fmt[pos:match.start()])
+            pos = match.end()
+            flags, width, _, conv = match.groups()
+            if conv == '%':
+                out.append('%')
+                continue
+            if width == '*':
+                width = args.pop(0) if args else 0
+            width = int(width or 0)
+            if not args:
+                out.append('<missing>')
+                continue
+            out.append(self.convert(conv, flags, width, args.pop(0)))
+        out.append(fmt[pos:])
+        return ''.join(out)
+
+    def decode(self, site, args):
+        fmt = self.format_for(site)
+        if fmt is None:
+            return '? site 0x%08x args %s\n' % (
+                site, ' '.join('0x%x' % arg for arg in args))
+        return self.render(fmt, args)
+
+
+def main(argv):
+    if len(argv) < 4:
+        print('Usage: %s <build-dir> <image.fd> <dump> [fd-base]' % argv[0])
+        return 1
+
+    build_dir = argv[1]
+    fd = fvlib.load(argv[2])
+    fd_base = int(argv[4], 0) if len(argv) > 4 else 0
+
+    decoder = Decoder(fd, fd_base, fvlib.te_images(fd, fd_base),
+                      collect_formats(build_dir))
+    head, lap, words = load_dump(argv[3])
+    if lap != 0:
+        print('! log ring wrapped %u times, oldest records are lost' % lap,
+              file=sys.stderr)
+
+    for (site, args) in records(head, lap, words):
+        sys.stdout.write(decoder.decode(site, args))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
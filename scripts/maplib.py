@@ -0,0 +1,160 @@
+#
+# GNU ld map file parser shared by profiling scripts.
+#
+# Function addresses are taken from linker map files written next to module
+# .debug images (-Map in GCC_ARC2_DLINK_FLAGS of snps-tools.txt), addresses
+# are mapped to images by FD layout the same way as log-decode.py maps
+# logging sites.
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import bisect
+import os
+import re
+import sys
+
+import fvlib
+import inflib
+
+# Input section of -ffunction-sections build, address and size may follow on
+# the same line or on the next one
+INPUT_SECTION_RE = re.compile(
+    r'^ \.text\.(\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+\S+)?$')
+ADDR_SIZE_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+\S+$')
+SYMBOL_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)$')
+OUTPUT_SECTION_RE = re.compile(
+    r'^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?')
+
+
+class Symbols:
+    """Functions of one image, by link address."""
+
+    def __init__(self, module):
+        self.module = module
+        self.starts = []
+        self.entries = []  # (start, end or None, name)
+        self.text_end = 0  # Labels without size end here at most
+
+    def add(self, start, end, name):
+        self.entries.append((start, end, name))
+
+    def finish(self):
+        # Sized input sections win over labels at the same address
+        self.entries.sort(key=lambda entry: (entry[0], entry[1] is None))
+        unique = []
+        for entry in self.entries:
+            if not unique or unique[-1][0] != entry[0]:
+                unique.append(entry)
+        self.entries = unique
+        self.starts = [entry[0] for entry in unique]
+
+    def lookup(self, addr):
+        idx = bisect.bisect_right(self.starts, addr) - 1
+        if idx < 0:
+            return None
+        start, end, name = self.entries[idx]
+        if addr >= (self.text_end if end is None else end):
+            return None
+        return name
+
+
+def parse_map(path, module):
+    """Functions of GNU ld map file."""
+    symbols = Symbols(module)
+    in_map = False
+    in_text = False
+    pending = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if not in_map:
+                in_map = line.startswith('Linker script and memory map')
+                continue
+
+            match = OUTPUT_SECTION_RE.match(line)
+            if match:
+                in_text = match.group(1).startswith('.text')
+                if in_text and match.group(2) is not None:
+                    symbols.text_end = max(symbols.text_end,
+                                           int(match.group(2), 16) +
+                                           int(match.group(3), 16))
+                pending = None
+                continue
+            if not in_text:
+                continue
+
+            if pending is not None:
+                match = ADDR_SIZE_RE.match(line)
+                if match:
+                    start = int(match.group(1), 16)
+                    size = int(match.group(2), 16)
+                    if size != 0:
+                        symbols.add(start, start + size, pending)
+                pending = None
+                continue
+
+            match = INPUT_SECTION_RE.match(line)
+            if match:
+                if match.group(2) is None:
+                    pending = match.group(1)
+                elif int(match.group(3), 16) != 0:
+                    start = int(match.group(2), 16)
+                    symbols.add(start, start + int(match.group(3), 16),
+                                match.group(1))
+                continue
+
+            match = SYMBOL_RE.match(line)
+            if match:
+                symbols.add(int(match.group(1), 16), None, match.group(2))
+
+    symbols.finish()
+    return symbols
+
+
+def collect_symbols(build_dir):
+    """Map of module file GUIDs to their functions."""
+    modules = {}
+    for root, _, files in os.walk(build_dir):
+        if os.path.basename(root) != 'DEBUG':
+            continue
+        for name in files:
+            if not name.endswith('.map'):
+                continue
+            path = os.path.join(root, name)
+            inf = inflib.build_output_inf(build_dir, path)
+            if inf is None:
+                print('! no INF file for %s' % path, file=sys.stderr)
+                continue
+            guid = inflib.Inf(inf).file_guid
+            if guid is not None:
+                modules[fvlib.guid_bytes(guid)] = parse_map(path, name[:-4])
+    return modules
+
+
+class Symbolizer:
+    def __init__(self, images, modules):
+        self.images = images
+        self.modules = modules
+        self.cache = {}
+
+    def name(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        text = '? 0x%08x' % addr
+        for (base, end, name) in self.images:
+            if base <= addr < end:
+                symbols = self.modules.get(name)
+                if symbols is None:
+                    text = '%s!0x%x' % (fvlib.guid_str(name), addr - base)
+                else:
+                    func = symbols.lookup(addr - base)
+                    text = '%s!%s' % (symbols.module,
+                                      func or '0x%x' % (addr - base))
+                break
+        self.cache[addr] = text
+        return text
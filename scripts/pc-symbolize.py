@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+#
+# PC sample histogram symbolizer.
+#
+# Attributes PC samples taken by PcSampleLib to functions, see maplib.py.
+# Histogram layout matches PC_SAMPLE_BUFFER in
+# Platform/ARC/Include/Library/PcSampleLib.h.
+#
+# Dump is either a raw copy of the histogram memory (PcdPcSampleBufferBase/
+# Size) or console output containing "@pcs" lines written by PcSampleDump().
+#
+# Usage:
+#   pc-symbolize.py <build-dir> <image.fd> <dump> [fd-base] [top]
+#
+#   build-dir  directory to search for .map files, e.g.
+#              $WORKSPACE/Build/hs4x/DEBUG_GCC/ARC2
+#   fd-base    address FD is visible at during boot (default 0)
+#   top        number of functions and call pairs listed (default 30)
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import struct
+import sys
+
+import fvlib
+import maplib
+
+PC_SAMPLE_SIGNATURE = b'PCSM'
+PC_SAMPLE_HEADER = '<4sIIIII'
+PC_SAMPLE = '<III'
+
+
+def load_dump(path):
+    """Histogram header fields and (pc, blink, count) of used entries."""
+    with open(path, 'rb') as f:
+        raw = f.read()
+
+    if raw[:4] != PC_SAMPLE_SIGNATURE:
+        words = []
+        for line in raw.decode(errors='replace').splitlines():
+            pos = line.find('@pcs ')
+            if pos >= 0:
+                words += [int(word, 16) for word in line[pos + 5:].split()]
+        raw = struct.pack('<%uI' % len(words), *words)
+
+    hdr_size = struct.calcsize(PC_SAMPLE_HEADER)
+    if len(raw) < hdr_size:
+        raise ValueError('no PC samples in %s' % path)
+    sig, capacity, samples, dropped, rate, _ = struct.unpack_from(
+        PC_SAMPLE_HEADER, raw)
+    if sig != PC_SAMPLE_SIGNATURE:
+        raise ValueError('bad PC sample signature in %s' % path)
+
+    entries = []
+    size = struct.calcsize(PC_SAMPLE)
+    for pos in range(hdr_size, len(raw) - size + 1, size):
+        entry = struct.unpack_from(PC_SAMPLE, raw, pos)
+        if entry[2] != 0:
+            entries.append(entry)
+    return samples, dropped, rate, entries
+
+
+def print_top(title, counts, total, top):
+    print(title)
+    for (name, count) in sorted(counts.items(), key=lambda item: -item[1])[:top]:
+        print('  %6.2f%% %8u  %s' % (100.0 * count / total, count, name))
+
+
+def main(argv):
+    if len(argv) < 4:
+        print('Usage: %s <build-dir> <image.fd> <dump> [fd-base] [top]' %
+              argv[0])
+        return 1
+
+    build_dir = argv[1]
+    fd = fvlib.load(argv[2])
+    fd_base = int(argv[4], 0) if len(argv) > 4 else 0
+    top = int(argv[5], 0) if len(argv) > 5 else 30
+
+    symbolizer = maplib.Symbolizer(fvlib.te_images(fd, fd_base),
+                                   maplib.collect_symbols(build_dir))
+    samples, dropped, rate, entries = load_dump(argv[3])
+
+    funcs = {}
+    pairs = {}
+    for (pc, blink, count) in entries:
+        func = symbolizer.name(pc)
+        funcs[func] = funcs.get(func, 0) + count
+        pair = '%s <- %s' % (func, symbolizer.name(blink))
+        pairs[pair] = pairs.get(pair, 0) + count
+
+    total = sum(funcs.values())
+    if total == 0:
+        print('! no samples', file=sys.stderr)
+        return 1
+
+    print('# %u samples at %u Hz (%.1f ms), %u dropped' % (
+        samples, rate, 1000.0 * samples / rate if rate else 0, dropped))
+    print_top('Functions:', funcs, total, top)
+    print_top('Functions <- BLINK:', pairs, total, top)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+#
+# PEI core capacity calculator.
+#
+# Counts PPIs produced by, PPI notifies registered by, or the number of, SEC,
+# PEI core and PEIM modules listed in given FV sections of FDF file, so
+# PcdPeiPpiCapacity, PcdPeiNotifyCapacity and PcdPeiPeimCapacity match the
+# platform instead of a fixed worst case. PPIs are taken from [Ppis] sections
+# of module INF files, entries without usage comment are counted as produced,
+# entries with NOTIFY usage as notifies.
+#
+# Usage:
+#   pei-capacity.py <file.fdf> <ppis|notifies|peims> [fv-name ...]
+#
+#   fv-name  FV sections to look at (default BootFv)
+#
+# INF paths are resolved against WORKSPACE and PACKAGES_PATH variables.
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import sys
+
+import inflib
+
+PEI_MODULE_TYPES = ('SEC', 'PEI_CORE', 'PEIM')
+
+
+def main():
+    if len(sys.argv) < 3 or sys.argv[2] not in ('ppis', 'notifies',
+                                                'peims'):
+        print('Usage: %s <file.fdf> <ppis|notifies|peims> [fv-name ...]' %
+              sys.argv[0], file=sys.stderr)
+        return 1
+
+    fv_names = sys.argv[3:] or ['BootFv']
+    capacity = 0
+    for path in inflib.fv_inf_paths(sys.argv[1], fv_names):
+        full = inflib.find_file(path)
+        if full is None:
+            print('Failed to find %s' % path, file=sys.stderr)
+            return 1
+        inf = inflib.Inf(full)
+        if inf.module_type not in PEI_MODULE_TYPES:
+            continue
+        if sys.argv[2] == 'ppis':
+            count = len(inf.produced_ppis())
+        elif sys.argv[2] == 'notifies':
+            count = len(inf.notified_ppis())
+        else:
+            count = 1 if inf.module_type == 'PEIM' else 0
+        print('| %s: %u' % (path, count), file=sys.stderr)
+        capacity += count
+
+    print(max(capacity, 1))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
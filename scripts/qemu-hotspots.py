@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+#
+# Per-function instruction and memory read report of QEMU hotspots plugin.
+#
+# Attributes instruction counts and reads recorded per guest instruction by
+# scripts/qemu-plugin/Hotspots.c to functions, see maplib.py. Reads are split
+# by address ranges given to the plugin: flash (FD), temporary RAM, DRAM and
+# other (MMIO). Bytes fetched by instructions executed in place are listed
+# apart from data reads.
+#
+# Usage:
+#   qemu-hotspots.py <build-dir> <image.fd> <plugin-output> [fd-base] [top]
+#
+#   build-dir  directory to search for .map files, e.g.
+#              $WORKSPACE/Build/hs4x/DEBUG_GCC/ARC2
+#   fd-base    address FD is visible at during boot (default 0)
+#   top        number of functions listed (default 30)
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import sys
+
+import fvlib
+import maplib
+
+# Column order of plugin output, see REGION_* in Hotspots.c
+REGIONS = ('flash', 'tram', 'dram', 'other')
+
+
+class Cost:
+    def __init__(self):
+        self.insns = 0
+        self.fetched = 0  # Instruction bytes executed from flash
+        self.reads = [0] * len(REGIONS)
+        self.bytes = [0] * len(REGIONS)
+
+    def add(self, other):
+        self.insns += other.insns
+        self.fetched += other.fetched
+        for idx in range(len(REGIONS)):
+            self.reads[idx] += other.reads[idx]
+            self.bytes[idx] += other.bytes[idx]
+
+
+def load_output(path):
+    """(flash range, [(pc, Cost)]) of plugin output."""
+    flash = None
+    records = []
+    with open(path) as f:
+        for line in f:
+            words = line.split()
+            if not words:
+                continue
+            if words[0] == '#':
+                if len(words) == 3 and words[1] == 'flash':
+                    base, size = [int(val, 0) for val in words[2].split(':')]
+                    flash = (base, base + size)
+                continue
+
+            vals = [int(words[0], 16)] + [int(word) for word in words[1:]]
+            if len(vals) != 3 + 2 * len(REGIONS):
+                raise ValueError('bad line in %s: %s' % (path, line.strip()))
+            cost = Cost()
+            cost.insns = vals[2]
+            cost.reads = vals[3::2]
+            cost.bytes = vals[4::2]
+            if flash is not None and flash[0] <= vals[0] < flash[1]:
+                cost.fetched = vals[1] * vals[2]
+            records.append((vals[0], cost))
+    return records
+
+
+def print_top(title, costs, key, total, top):
+    print('%s (%u)' % (title, total))
+    print('  %7s %12s %10s %10s %10s %10s  %s' % (
+        '%', 'count', 'fetched', 'flash', 'tram', 'dram', 'function'))
+    for (name, cost) in sorted(costs.items(),
+                               key=lambda item: -key(item[1]))[:top]:
+        if key(cost) == 0:
+            break
+        print('  %6.2f%% %12u %10u %10u %10u %10u  %s' % (
+            100.0 * key(cost) / total if total else 0, key(cost), cost.fetched,
+            cost.bytes[0], cost.bytes[1], cost.bytes[2], name))
+
+
+def main(argv):
+    if len(argv) < 4:
+        print('Usage: %s <build-dir> <image.fd> <plugin-output> [fd-base] '
+              '[top]' % argv[0])
+        return 1
+
+    build_dir = argv[1]
+    fd = fvlib.load(argv[2])
+    fd_base = int(argv[4], 0) if len(argv) > 4 else 0
+    top = int(argv[5], 0) if len(argv) > 5 else 30
+
+    symbolizer = maplib.Symbolizer(fvlib.te_images(fd, fd_base),
+                                   maplib.collect_symbols(build_dir))
+    costs = {}
+    total = Cost()
+    for (pc, cost) in load_output(argv[3]):
+        name = symbolizer.name(pc)
+        costs.setdefault(name, Cost()).add(cost)
+        total.add(cost)
+
+    if total.insns == 0:
+        print('! no instructions', file=sys.stderr)
+        return 1
+
+    print('# %u instructions, %u bytes fetched from flash' % (
+        total.insns, total.fetched))
+    for (idx, region) in enumerate(REGIONS):
+        print('# %s: %u reads, %u bytes' % (region, total.reads[idx],
+                                             total.bytes[idx]))
+    print_top('Instructions:', costs, lambda cost: cost.insns, total.insns,
+              top)
+    print_top('Flash bytes read:', costs, lambda cost: cost.bytes[0],
+              total.bytes[0], top)
+    print_top('Flash bytes fetched:', costs, lambda cost: cost.fetched,
+              total.fetched, top)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,299 @@
+/** @file
+  QEMU TCG plugin counting executed instructions and memory reads per guest
+  instruction address.
+
+  Every translated instruction gets a record holding its execution count and
+  the number of reads it did, and bytes read, from flash, temporary RAM, DRAM
+  and anything else (MMIO). Records are written at exit as text, one line
+  per instruction address, for scripts/qemu-hotspots.py to attribute them to
+  functions.
+
+  Plugin arguments (address ranges are base:size):
+    out=<path>         output file, default is QEMU log
+    flash=<range>      FD, default 0:0x400000 (build-qemu-fd.sh fd-base)
+    tram=<range>       temporary RAM, default 0x80000000:0x10000
+    dram=<range>       DRAM, default 0x80010000:0x7fff0000
+
+  Firmware runs with MMU off, so virtual addresses are physical ones.
+
+  Copyright (c) 2023 Basemark Oy
+
+  Author: Aliaksei Katovich @ basemark.com
+
+  Released under the BSD-2-Clause License
+**/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <qemu-plugin.h>
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+enum {
+  REGION_FLASH,
+  REGION_TRAM,
+  REGION_DRAM,
+  REGION_OTHER, // Not in any range above, e.g. MMIO
+  REGION_COUNT
+};
+
+typedef struct {
+  const char *Name;
+  uint64_t Base;
+  uint64_t Size;
+} REGION;
+
+typedef struct {
+  uint64_t Pc;
+  uint32_t Size; // Instruction length, fetched bytes are Size * Insns
+  uint64_t Insns;
+  uint64_t Reads[REGION_COUNT];
+  uint64_t Bytes[REGION_COUNT];
+} INSN_RECORD;
+
+static REGION mRegions[REGION_COUNT] = {
+  [REGION_FLASH] = { "flash", 0, 0x400000 },
+  [REGION_TRAM] = { "tram", 0x80000000, 0x10000 },
+  [REGION_DRAM] = { "dram", 0x80010000, 0x7fff0000 },
+  [REGION_OTHER] = { "other", 0, 0 },
+};
+
+static GHashTable *mRecords;
+static GMutex mLock;
+static char *mOutPath;
+
+static
+unsigned int
+AddrToRegion(
+  uint64_t Addr
+  )
+{
+  unsigned int Idx;
+
+  for (Idx = 0; Idx < REGION_OTHER; Idx++) {
+    if (Addr - mRegions[Idx].Base < mRegions[Idx].Size) {
+      return Idx;
+    }
+  }
+
+  return REGION_OTHER;
+}
+
+static
+void
+OnInsnExec(
+  unsigned int VcpuIdx,
+  void *UserData
+  )
+{
+  INSN_RECORD *Record = UserData;
+
+  __atomic_fetch_add(&Record->Insns, 1, __ATOMIC_RELAXED);
+}
+
+static
+void
+OnMemRead(
+  unsigned int VcpuIdx,
+  qemu_plugin_meminfo_t Info,
+  uint64_t Addr,
+  void *UserData
+  )
+{
+  INSN_RECORD *Record = UserData;
+  unsigned int Region;
+
+  Region = AddrToRegion(Addr);
+  __atomic_fetch_add(&Record->Reads[Region], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&Record->Bytes[Region],
+    1U << qemu_plugin_mem_size_shift(Info), __ATOMIC_RELAXED);
+}
+
+static
+INSN_RECORD *
+GetRecord(
+  uint64_t Pc,
+  uint32_t Size
+  )
+{
+  INSN_RECORD *Record;
+
+  //
+  // Blocks get translated again, e.g. after TB cache flush, keep counting
+  // in the same record
+  //
+  g_mutex_lock(&mLock);
+  Record = g_hash_table_lookup(mRecords, &Pc);
+  if (Record == NULL) {
+    Record = g_new0(INSN_RECORD, 1);
+    Record->Pc = Pc;
+    Record->Size = Size;
+    g_hash_table_insert(mRecords, &Record->Pc, Record);
+  }
+  g_mutex_unlock(&mLock);
+  return Record;
+}
+
+static
+void
+OnTbTrans(
+  qemu_plugin_id_t Id,
+  struct qemu_plugin_tb *Tb
+  )
+{
+  struct qemu_plugin_insn *Insn;
+  INSN_RECORD *Record;
+  size_t Count;
+  size_t Idx;
+
+  Count = qemu_plugin_tb_n_insns(Tb);
+  for (Idx = 0; Idx < Count; Idx++) {
+    Insn = qemu_plugin_tb_get_insn(Tb, Idx);
+    Record = GetRecord(qemu_plugin_insn_vaddr(Insn),
+      qemu_plugin_insn_size(Insn));
+
+    qemu_plugin_register_vcpu_insn_exec_cb(Insn, OnInsnExec,
+      QEMU_PLUGIN_CB_NO_REGS, Record);
+    qemu_plugin_register_vcpu_mem_cb(Insn, OnMemRead,
+      QEMU_PLUGIN_CB_NO_REGS, QEMU_PLUGIN_MEM_R, Record);
+  }
+}
+
+static
+gint
+ComparePc(
+  gconstpointer A,
+  gconstpointer B
+  )
+{
+  const INSN_RECORD *RecordA = A;
+  const INSN_RECORD *RecordB = B;
+
+  return RecordA->Pc < RecordB->Pc ? -1 : RecordA->Pc > RecordB->Pc;
+}
+
+static
+void
+OnExit(
+  qemu_plugin_id_t Id,
+  void *UserData
+  )
+{
+  GString *Out;
+  GList *Records;
+  GList *Item;
+  INSN_RECORD *Record;
+  unsigned int Region;
+  FILE *File;
+
+  Out = g_string_new("# pc size insns");
+  for (Region = 0; Region < REGION_COUNT; Region++) {
+    g_string_append_printf(Out, " %s-reads %s-bytes", mRegions[Region].Name,
+      mRegions[Region].Name);
+  }
+
+  g_string_append(Out, "\n");
+  for (Region = 0; Region < REGION_OTHER; Region++) {
+    g_string_append_printf(Out, "# %s 0x%" PRIx64 ":0x%" PRIx64 "\n",
+      mRegions[Region].Name, mRegions[Region].Base, mRegions[Region].Size);
+  }
+
+  g_mutex_lock(&mLock);
+  Records = g_list_sort(g_hash_table_get_values(mRecords), ComparePc);
+  for (Item = Records; Item != NULL; Item = Item->next) {
+    Record = Item->data;
+    if (Record->Insns == 0) {
+      continue;
+    }
+
+    g_string_append_printf(Out, "%08" PRIx64 " %u %" PRIu64, Record->Pc,
+      Record->Size, Record->Insns);
+    for (Region = 0; Region < REGION_COUNT; Region++) {
+      g_string_append_printf(Out, " %" PRIu64 " %" PRIu64,
+        Record->Reads[Region], Record->Bytes[Region]);
+    }
+
+    g_string_append(Out, "\n");
+  }
+  g_mutex_unlock(&mLock);
+  g_list_free(Records);
+
+  File = mOutPath != NULL ? fopen(mOutPath, "w") : NULL;
+  if (File != NULL) {
+    fwrite(Out->str, 1, Out->len, File);
+    fclose(File);
+  } else {
+    if (mOutPath != NULL) {
+      qemu_plugin_outs("hotspots: cannot write output file, using log\n");
+    }
+    qemu_plugin_outs(Out->str);
+  }
+
+  g_string_free(Out, TRUE);
+}
+
+static
+bool
+ParseRange(
+  const char *Value,
+  REGION *Region
+  )
+{
+  char *End;
+
+  Region->Base = strtoull(Value, &End, 0);
+  if (*End != ':') {
+    return false;
+  }
+
+  Region->Size = strtoull(End + 1, &End, 0);
+  return *End == '\0';
+}
+
+QEMU_PLUGIN_EXPORT
+int
+qemu_plugin_install(
+  qemu_plugin_id_t Id,
+  const qemu_info_t *Info,
+  int Argc,
+  char **Argv
+  )
+{
+  char *Value;
+  unsigned int Region;
+  int Idx;
+
+  for (Idx = 0; Idx < Argc; Idx++) {
+    Value = strchr(Argv[Idx], '=');
+    if (Value == NULL) {
+      fprintf(stderr, "hotspots: bad argument %s\n", Argv[Idx]);
+      return -1;
+    }
+
+    *Value++ = '\0';
+    if (strcmp(Argv[Idx], "out") == 0) {
+      mOutPath = g_strdup(Value);
+      continue;
+    }
+
+    for (Region = 0; Region < REGION_OTHER; Region++) {
+      if (strcmp(Argv[Idx], mRegions[Region].Name) == 0) {
+        break;
+      }
+    }
+
+    if (Region == REGION_OTHER || !ParseRange(Value, &mRegions[Region])) {
+      fprintf(stderr, "hotspots: bad argument %s=%s\n", Argv[Idx], Value);
+      return -1;
+    }
+  }
+
+  mRecords = g_hash_table_new(g_int64_hash, g_int64_equal);
+  qemu_plugin_register_vcpu_tb_trans_cb(Id, OnTbTrans);
+  qemu_plugin_register_atexit_cb(Id, OnExit, NULL);
+  return 0;
+}
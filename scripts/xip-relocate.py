@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+#
+# Build-time relocation of XIP images.
+#
+# SEC, PEI core and PEIMs are linked with -fpie and run in place from flash.
+# Instead of adding fixups to pointers at every boot, this script applies
+# base relocations of their TE images for the address FD is visible at, and
+# updates ImageBase in TE headers accordingly. FREEFORM_SUBTYPE_GUID fixup
+# sections of relocated images are turned into RAW sections, so neither
+# scripts/boot-manifest.py nor PEI core find a fixup for them and nothing
+# gets patched at runtime.
+#
+# Usage:
+#   xip-relocate.py <image.fd> [fd-base]
+#
+#   fd-base  address FD is visible at during boot (default 0), must match
+#            the one given to scripts/boot-manifest.py
+#
+# Copyright (c) 2023 Basemark Oy
+#
+# Author: Aliaksei Katovich @ basemark.com
+#
+# Released under the BSD-2-Clause License
+#
+
+import struct
+import sys
+
+import fvlib
+
+IMAGE_TYPES = (
+    fvlib.FV_FILETYPE_SECURITY_CORE,
+    fvlib.FV_FILETYPE_PEI_CORE,
+    fvlib.FV_FILETYPE_PEIM,
+)
+
+# Base relocation types, see MdePkg/Include/IndustryStandard/PeImage.h
+REL_BASED_ABSOLUTE = 0
+REL_BASED_HIGHLOW = 3
+REL_BASED_DIR64 = 10
+
+
+def relocate(file_, fd_base):
+    """Rebase TE image of given file, returns applied delta."""
+    te = file_.section(fvlib.SECTION_TE)
+    if te is None:
+        return None
+
+    fd = file_.fd
+    hdr = te.data_offset
+    (sig, _, _, _, stripped, _, _, image_base) = struct.unpack_from(
+        fvlib.TE_HEADER_FORMAT, fd, hdr)
+    if sig != b'VZ':
+        raise ValueError('bad TE signature in %s' % file_.guid)
+
+    # Same math as GetTeEntryPoint() in UtilsLib.c, RVA 0 is at this offset
+    rva0 = hdr + fvlib.TE_HEADER_SIZE - stripped
+    target = fd_base + rva0
+    delta = (target - image_base) & 0xffffffffffffffff
+
+    reloc_rva, reloc_size = struct.unpack_from('<II', fd,
+                                               hdr + fvlib.TE_BASE_RELOC_OFFSET)
+    if delta != 0 and reloc_size == 0:
+        raise ValueError('%s has no relocations to move it from 0x%x to 0x%x'
+                         % (file_.guid, image_base, target))
+
+    pos = rva0 + reloc_rva
+    end = pos + reloc_size
+    while delta != 0 and pos + 8 <= end:
+        page, size = struct.unpack_from('<II', fd, pos)
+        if size < 8 or pos + size > end:
+            raise ValueError('corrupted relocations in %s' % file_.guid)
+        for entry, in struct.iter_unpack('<H', fd[pos + 8:pos + size]):
+            type_ = entry >> 12
+            addr = rva0 + page + (entry & 0xfff)
+            if type_ == REL_BASED_ABSOLUTE:
+                continue  # Block padding
+            elif type_ == REL_BASED_HIGHLOW:
+                val, = struct.unpack_from('<I', fd, addr)
+                struct.pack_into('<I', fd, addr, (val + delta) & 0xffffffff)
+            elif type_ == REL_BASED_DIR64:
+                val, = struct.unpack_from('<Q', fd, addr)
+                struct.pack_into('<Q', fd, addr,
+                                 (val + delta) & 0xffffffffffffffff)
+            else:
+                raise ValueError('unsupported relocation type %u in %s' %
+                                 (type_, file_.guid))
+        pos += size
+
+    struct.pack_into('<Q', fd, hdr + fvlib.TE_IMAGE_BASE_OFFSET, target)
+
+    fixup = file_.section(fvlib.SECTION_FREEFORM_SUBTYPE_GUID)
+    if fixup is not None:
+        fd[fixup.offset + 3] = fvlib.SECTION_RAW
+
+    file_.update_checksum()
+    return delta
+
+
+def main(argv):
+    if len(argv) < 2:
+        print('Usage: %s <image.fd> [fd-base]' % argv[0])
+        return 1
+
+    path = argv[1]
+    fd_base = int(argv[2], 0) if len(argv) > 2 else 0
+
+    fd = fvlib.load(path)
+    count = 0
+    for fv in fvlib.volumes(fd):
+        for file_ in fv.files():
+            if file_.type not in IMAGE_TYPES:
+                continue
+            delta = relocate(file_, fd_base)
+            if delta is None:
+                continue
+            print('| %s type 0x%02x delta 0x%x' % (file_.guid, file_.type,
+                                                   delta))
+            count += 1
+
+    fvlib.save(path, fd)
+    print('> %s: relocated %u images for FD at 0x%x' % (path, count, fd_base))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))